@@ -12,7 +12,25 @@
 #include "GameFrameWork/SpringArmComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Weapon/public/DefaultThrowingWeapon.h"
-
+#include "Weapon/public/ThrowingWeaponTetherComponent.h"
+#include "Weapon/public/WeaponThrowLatency.h"
+#include "Weapon/public/ThrowTargetComponent.h"
+#include "Weapon/public/ThrowTargetSubsystem.h"
+#include "Weapon/public/ThrowingWeaponSignificanceSubsystem.h"
+#include "PlayerCharacterStats.h"
+#include "PlayerCharacterReplay.h"
+#include "Net/UnrealNetwork.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/AssetManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+
+static int32 GPlayerCharacterReplayRecord = 0;
+static FAutoConsoleVariableRef CVarPlayerCharacterReplayRecord(
+	TEXT("Player.Replay.Record"),
+	GPlayerCharacterReplayRecord,
+	TEXT("Record the local player's input and throwing weapon states to Saved/Replays for Player.Replay.Play. Set it to 0 to finish the recording"));
 
 // Sets default values
 APlayerCharacterBase::APlayerCharacterBase()
@@ -48,17 +66,42 @@ APlayerCharacterBase::APlayerCharacterBase()
 	ThrowingWeaponChildComponent->SetupAttachment(GetMesh(), FName("WeaponGripPoint"));
 	
 	RopeComponent = CreateDefaultSubobject<UCableComponent>(TEXT("Throwing Weapon Rope"));
-	RopeComponent->SetupAttachment(GetMesh(), FName("RopeSocket"));
+	RopeComponent->SetupAttachment(GetMesh()); // Follows RopeSocket through the socket transform cache
 	RopeComponent->bAttachEnd = true;		
 
+	TetherComponent = CreateDefaultSubobject<UThrowingWeaponTetherComponent>(TEXT("Throwing Weapon Tether"));
+	TetherComponent->SetupAttachment(GetMesh()); // Follows RopeSocket through the socket transform cache
+	bUseNativeTether = true;
+
+	ThrowPreviewComponent = CreateDefaultSubobject<ULineBatchComponent>(TEXT("Throw Preview"));
+	ThrowPreviewComponent->SetupAttachment(RootComponent); // Lines are in world space, the attachment only keeps it with the player
+	bShowThrowPreview = true;
+	ThrowPreviewColor = FLinearColor(1, 1, 1, 0.6f);
+	ThrowPreviewThickness = 2;
+	bUseAimAssist = true;
+	AimAssistConeAngle = 10;
+	AimAssistMaxDistance = 4000;
+	AimAssistStrength = 0.75f;
+	LaunchLocationTolerance = 150;
+	LaunchDirectionTolerance = 40;
+	bIsThrowPreviewDrawn = false;
+
 	/// <summary>
 	/// Timelines
 	/// </summary> 
 	TLRangedCameraComponent = CreateDefaultSubobject<UTimelineComponent>(TEXT("Ranged Camera Timeline"));
-	RangedCameraInterpFunction.BindUFunction(this, FName("TLRangedCameraUpdate"));
 	RangedCameraTimelineFinished.BindUFunction(this, FName("TLRangedCameraFinished"));	
+	RangedCameraTimelinePostUpdate.BindUFunction(this, FName("TLRangedCameraPostUpdate"));
 
+	/// <summary>
+	/// Cached sockets
+	/// </summary> 
+	WeaponGripPointSocketHandle = SocketTransformCache.AddSocket(FName("WeaponGripPoint"));
+	RopeSocketHandle = SocketTransformCache.AddSocket(FName("RopeSocket"));
+	RopeRelativeTransform = FTransform::Identity;
 
+	AppliedThrowSequence = INDEX_NONE;
+	bIsReplayPlaying = false;
 }
 
 // Called when the game starts or when spawned
@@ -76,16 +119,78 @@ void APlayerCharacterBase::BeginPlay()
 		}
 	}
 
+	// Every player has its own weapon, so the weapon can't assume the local player owns it
+	DefaultThrowingWeaponReference->SetOwningPlayer(this);
+	DefaultThrowingWeaponReference->OnThrowingWeaponStateChanged.AddUObject(this, &APlayerCharacterBase::ThrowingWeaponStateChanged);
+
 	TArray<FName> viableSockets = DefaultThrowingWeaponReference->ThrowingWeaponMeshComponent->GetAllSocketNames();
 	for (int i = 0; i < viableSockets.Num(); i++)
 	{
 		if (viableSockets[i] == FName("ThrowingWeaponRope"))
 		{
 			RopeComponent->SetAttachEndTo(DefaultThrowingWeaponReference, FName("ThrowingWeaponMeshComponent"), viableSockets[i]);
+			TetherComponent->SetTetherEnd(DefaultThrowingWeaponReference->ThrowingWeaponMeshComponent, viableSockets[i]);
 		}
 	}
 
-	
+	// Only one of the ropes simulates, and neither does while the weapon is in the hand
+	RopeComponent->SetComponentTickEnabled(false);
+	if (bUseNativeTether)
+	{
+		TetherComponent->TetherLength = RopeComponent->CableLength;
+		TetherComponent->Width = RopeComponent->CableWidth;
+		TetherComponent->NumSides = RopeComponent->NumSides;
+		TetherComponent->TileMaterial = RopeComponent->TileMaterial;
+		TetherComponent->GravityScale = RopeComponent->CableGravityScale;
+		TetherComponent->MaxSegments = RopeComponent->NumSegments;
+		TetherComponent->MaxIterations = RopeComponent->SolverIterations;
+		TetherComponent->SetMaterial(0, RopeComponent->GetMaterial(0));
+		TetherComponent->SetRelativeTransform(RopeComponent->GetRelativeTransform());
+
+		RopeComponent->SetVisibility(false);
+	}
+
+	// The timeline only keeps time, the camera curve is read from its baked table (a constant one until the curve is loaded)
+	RangedCameraCurveTable = FBakedCurve::FindOrBake(nullptr, 0);
+	if (!TLRangedCamera_Curve.IsNull())
+	{
+		RangedCameraCurveHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(TLRangedCamera_Curve.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &APlayerCharacterBase::RangedCameraCurveLoaded));
+	}
+	TLRangedCameraComponent->SetTimelinePostUpdateFunc(RangedCameraTimelinePostUpdate);
+	TLRangedCameraComponent->SetLooping(false);
+
+	// Bone indices are found once here, the cache is refreshed after every pose update and mesh move
+	RopeRelativeTransform = RopeComponent->GetRelativeTransform();
+	SocketTransformCache.Resolve(GetMesh());
+	RefreshSocketTransformCache();
+
+	GetMesh()->OnBoneTransformsFinalized.AddDynamic(this, &APlayerCharacterBase::RefreshSocketTransformCache);
+	GetMesh()->TransformUpdated.AddUObject(this, &APlayerCharacterBase::MeshTransformUpdated);
+
+	if (UThrowingWeaponSignificanceSubsystem* significanceSubsystem = UWorld::GetSubsystem<UThrowingWeaponSignificanceSubsystem>(GetWorld()))
+	{
+		significanceSubsystem->RegisterActor(this);
+	}
+}
+
+// Called when the player is destroyed or the level ends
+void APlayerCharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->Close();
+		ReplayWriter.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Replicated properties
+void APlayerCharacterBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(APlayerCharacterBase, ThrowingWeaponNetState);
 }
 
 // Called every frame
@@ -95,6 +200,27 @@ void APlayerCharacterBase::Tick(float DeltaTime)
 
 	CharacterRotation(DeltaTime);	
 
+	// Lock-on is only needed by the player who aims
+	if (bUseAimAssist && bIsAiming && !bIsThrowingWeaponLaunched && IsLocallyControlled())
+	{
+		UpdateAimAssistTarget();
+	}
+	else
+	{
+		AimAssistTarget.Reset();
+	}
+
+	// Only the aiming player sees where the throw goes
+	if (bShowThrowPreview && bIsAiming && !bIsThrowingWeaponLaunched && IsLocallyControlled() && DefaultThrowingWeaponReference != nullptr)
+	{
+		UpdateThrowPreview();
+	}
+	else if (bIsThrowPreviewDrawn)
+	{
+		ClearThrowPreview();
+	}
+
+	UpdateReplayRecording(DeltaTime);
 }
 
 // Called to bind functionality to input
@@ -127,15 +253,17 @@ void APlayerCharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInpu
 // Attach the throwing weapon to player socket (WeaponGripPoint)
 void APlayerCharacterBase::CatchThrowingWeapon()
 {
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerAttachWeapon);
+
 	if (DefaultThrowingWeaponReference != nullptr)
 	{		
-		RopeComponent->SetVisibility(false);
+		SetRopeVisibility(false);
 
 		DefaultThrowingWeaponReference->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, EAttachmentRule::SnapToTarget, EAttachmentRule::SnapToTarget, false), FName("WeaponGripPoint"));
 		
 		bIsThrowingWeaponLaunched = false;
 
-		DefaultThrowingWeaponReference->CurrentThrowingWeaponState = ThrowingWeaponState::Idle;
+		DefaultThrowingWeaponReference->SetThrowingWeaponState(ThrowingWeaponState::Idle);
 
 		DoOnce.Reset();
 	}
@@ -145,6 +273,11 @@ void APlayerCharacterBase::Move(const FInputActionValue& Value)
 {
 	FVector2D MovementVector = Value.Get<FVector2D>();
 
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordAxis(EPlayerReplayEvent::Move, MovementVector);
+	}
+
 	if (Controller != nullptr)
 	{
 		// Find out which way is forward
@@ -167,6 +300,11 @@ void APlayerCharacterBase::Look(const FInputActionValue& Value)
 {
 	FVector2D lookingAxisVector = Value.Get<FVector2D>();
 
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordAxis(EPlayerReplayEvent::Look, lookingAxisVector);
+	}
+
 	if (Controller != nullptr)
 	{
 		// Yaw and pitch for the lookAxis controller input
@@ -180,22 +318,44 @@ void APlayerCharacterBase::LerpCameraPosition(float boomLengthIdle, float boomLe
 	float lerpBoomLength = FMath::Lerp(boomLengthIdle, boomLengthAimed, alpha);
 	CameraBoomComponent->TargetArmLength = lerpBoomLength;
 }
-// Updates the camera based on whether or not the player is aiming 
+// Start the timeline towards the aimed camera, only if it isn't already heading there
 void APlayerCharacterBase::UpdateRangedCamera()
 {
-	if (TLRangedCamera_Curve != nullptr)
+	// Aim is Triggered every frame while the button is held, the timeline only needs to start once. It stops playing when
+	// it reaches the aimed camera, so IsPlaying alone would restart it every frame after that
+	if (bIsRangedCameraAimed)
 	{
-		TLRangedCameraComponent->AddInterpFloat(TLRangedCamera_Curve, RangedCameraInterpFunction, FName("Update Ranged Camera"));
+		return;
 	}
+	bIsRangedCameraAimed = true;
+
 	TLRangedCameraComponent->SetPlayRate(8);
 	TLRangedCameraComponent->Play();
-	TLRangedCameraComponent->SetLooping(false);
 }
 // Update the timeline for switching between idle and aimed camera
 void APlayerCharacterBase::TLRangedCameraUpdate(float value)
 {
 	LerpCameraPosition(CameraBoomIdle, CameraBoomAimed, value);
 }
+// Evaluate the baked ranged camera curve at the timeline position
+void APlayerCharacterBase::TLRangedCameraPostUpdate()
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerRangedCamera);
+
+	TLRangedCameraUpdate(RangedCameraCurveTable->Evaluate(TLRangedCameraComponent->GetPlaybackPosition()));
+}
+// Bake the camera curve once it is in memory and fit the timeline to it
+void APlayerCharacterBase::RangedCameraCurveLoaded()
+{
+	if (const UCurveFloat* rangedCameraCurve = TLRangedCamera_Curve.Get())
+	{
+		RangedCameraCurveTable = FBakedCurve::FindOrBake(rangedCameraCurve, 0);
+		TLRangedCameraComponent->SetTimelineLength(RangedCameraCurveTable->GetEndTime());
+	}
+
+	// Only the table is read from here on, the curve asset can be unloaded
+	RangedCameraCurveHandle.Reset();
+}
 // If player isn't aiming reverse the timeline back to idle camera position
 void APlayerCharacterBase::TLRangedCameraFinished()
 {
@@ -204,12 +364,21 @@ void APlayerCharacterBase::TLRangedCameraFinished()
 // Rotate the player accordingly when the player is aiming a weapon
 void APlayerCharacterBase::CharacterRotation(float DeltaTime)
 {
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerRotation);
+
 	if (bIsAiming)
 	{
 		FRotator actorRotation = GetActorRotation();
 		FRotator controlRotation = GetControlRotation();
 
 		FRotator newCharacterRotation = FRotator(actorRotation.Pitch, controlRotation.Yaw, actorRotation.Roll);
+
+		// Already facing the aim, don't move the capsule and everything attached to it
+		if (actorRotation.Equals(newCharacterRotation))
+		{
+			return;
+		}
+
 		FRotator interpRotation = FMath::RInterpTo(actorRotation, newCharacterRotation, DeltaTime, 50);
 
 		SetActorRotation(interpRotation);
@@ -218,38 +387,102 @@ void APlayerCharacterBase::CharacterRotation(float DeltaTime)
 // Aim the equipped weapon
 void APlayerCharacterBase::Aim()
 {	
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordEvent(EPlayerReplayEvent::Aim);
+	}
+
 	bIsAiming = true;	
 	CameraTurnRate = CameraTurnRateAim;
 
 	GetCharacterMovement()->MaxWalkSpeed = MaxWalkSpeedAim;
 	UpdateRangedCamera();
+
+	RefreshSignificance();
 }
 // Stop aiming the equipped weapon
 void APlayerCharacterBase::StopAim()
 {
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordEvent(EPlayerReplayEvent::StopAim);
+	}
+
 	bIsAiming = false;	
+	bIsRangedCameraAimed = false;
 	CameraTurnRate = CameraTurnRateIdle;
 
 	GetCharacterMovement()->MaxWalkSpeed = MaxWalkSpeedIdle;
 	TLRangedCameraComponent->SetPlayRate(8);
 	TLRangedCameraComponent->Reverse();
+
+	RefreshSignificance();
+}
+// Aiming changes what the character ticks for, so its tick rate is scored again right away
+void APlayerCharacterBase::RefreshSignificance()
+{
+	if (UThrowingWeaponSignificanceSubsystem* significanceSubsystem = UWorld::GetSubsystem<UThrowingWeaponSignificanceSubsystem>(GetWorld()))
+	{
+		significanceSubsystem->RefreshActor(this);
+	}
+}
+// Read the cached sockets from the new pose and move the rope start with it
+void APlayerCharacterBase::RefreshSocketTransformCache()
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerRopeUpdate);
+	INC_DWORD_STAT(STAT_PlayerRopeUpdates);
+
+	SocketTransformCache.RefreshPose(GetMesh());
+
+	const FTransform ropeTransform = RopeRelativeTransform * SocketTransformCache.GetComponentSpaceTransform(RopeSocketHandle);
+
+	if (bUseNativeTether)
+	{
+		TetherComponent->SetRelativeTransform(ropeTransform);
+	}
+	else
+	{
+		RopeComponent->SetRelativeTransform(ropeTransform);
+	}
+}
+// The mesh moved without a new pose, only the world transforms change
+void APlayerCharacterBase::MeshTransformUpdated(USceneComponent* updatedComponent, EUpdateTransformFlags updateTransformFlags, ETeleportType teleport)
+{
+	SocketTransformCache.RefreshWorld(GetMesh());
 }
 // Launch the equipped throwing weapon
 void APlayerCharacterBase::LaunchThrowingWeapon()
 {
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordEvent(EPlayerReplayEvent::LaunchThrowingWeapon);
+	}
+
 	if (Controller != nullptr && DefaultThrowingWeaponReference != nullptr)
 	{
 		if (bIsAiming)
 		{			
 			if (!bIsThrowingWeaponLaunched)
 			{
-				RopeComponent->SetVisibility(true);
-
-				DefaultThrowingWeaponReference->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);				
-
-				DefaultThrowingWeaponReference->ThrowWeapon(FollowCameraComponent->GetComponentRotation(), FollowCameraComponent->GetForwardVector(), GetMesh()->GetSocketLocation(FName("WeaponGripPoint")), WeaponThrowSpeed);
-
-				bIsThrowingWeaponLaunched = true;
+				FThrowingWeaponNetState launch;
+				launch.State = ThrowingWeaponState::Launched;
+				launch.Sequence = ThrowingWeaponNetState.Sequence + 1;
+				launch.Location = GetWeaponGripPointTransform().GetLocation();
+				launch.Direction = GetAimedThrowDirection();
+				launch.Rotation = FollowCameraComponent->GetComponentRotation();
+
+				WEAPON_THROW_LATENCY_INPUT();
+
+				// Thrown here right away, the server throws with the same launch and replicates it to everyone else
+				PerformThrow(launch);
+
+				if (!HasAuthority())
+				{
+					ServerLaunchThrowingWeapon(launch);
+#if !UE_BUILD_SHIPPING
+					FThrowingWeaponNetState::RecordSent(launch, true);
+#endif
+				}
 			}
 		}
 	}
@@ -257,6 +490,11 @@ void APlayerCharacterBase::LaunchThrowingWeapon()
 // Recall the equipped throwing weapon 
 void APlayerCharacterBase::RecallThrowingWeapon()
 {
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordEvent(EPlayerReplayEvent::RecallThrowingWeapon);
+	}
+
 	if (Controller != nullptr && DefaultThrowingWeaponReference != nullptr)
 	{
 		if (bIsThrowingWeaponLaunched)
@@ -264,9 +502,322 @@ void APlayerCharacterBase::RecallThrowingWeapon()
 			if (DoOnce.Execute())
 			{
 				DefaultThrowingWeaponReference->RecallThrowingWeapon();
+
+				if (!HasAuthority())
+				{
+					ServerRecallThrowingWeapon(static_cast<uint8>(AppliedThrowSequence));
+#if !UE_BUILD_SHIPPING
+					FThrowingWeaponNetState::RecordSentRecall();
+#endif
+				}
 			}			
 		}
 	}
 }
+// Detach and throw the weapon with a launch, on the server this also starts replicating it
+void APlayerCharacterBase::PerformThrow(const FThrowingWeaponNetState& launch)
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerDetachWeapon);
+
+	SetRopeVisibility(true);
+
+	DefaultThrowingWeaponReference->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+
+	AppliedThrowSequence = launch.Sequence;
+	bIsThrowingWeaponLaunched = true;
+
+	if (HasAuthority())
+	{
+		// The state itself is filled in by ThrowingWeaponStateChanged
+		ThrowingWeaponNetState = launch;
+#if !UE_BUILD_SHIPPING
+		FThrowingWeaponNetState::RecordThrow();
+#endif
+	}
+
+	DefaultThrowingWeaponReference->ThrowWeapon(launch.Rotation, launch.Direction, launch.Location, WeaponThrowSpeed);
+}
+// Throw on the server with the launch the client predicted, or with the server's own launch when the client's is off
+void APlayerCharacterBase::ServerLaunchThrowingWeapon_Implementation(const FThrowingWeaponNetState& launch)
+{
+	if (DefaultThrowingWeaponReference == nullptr || bIsThrowingWeaponLaunched)
+	{
+		return;
+	}
+
+	if (IsLaunchPlausible(launch))
+	{
+		PerformThrow(launch);
+		return;
+	}
+
+	// A new sequence makes the owning client treat the replicated launch as a throw it didn't start, so OnRep throws it again from here
+	FThrowingWeaponNetState serverLaunch;
+	serverLaunch.State = ThrowingWeaponState::Launched;
+	serverLaunch.Sequence = launch.Sequence + 1;
+	serverLaunch.Location = GetWeaponGripPointTransform().GetLocation();
+	serverLaunch.Direction = GetControlRotation().Vector();
+	serverLaunch.Rotation = GetControlRotation();
+
+	PerformThrow(serverLaunch);
+}
+// Does a client's launch start at the server's grip point and point where the server's control rotation does?
+bool APlayerCharacterBase::IsLaunchPlausible(const FThrowingWeaponNetState& launch) const
+{
+	if (!FMath::IsNearlyEqual(launch.Direction.SizeSquared(), 1.0, 0.01))
+	{
+		return false;
+	}
+
+	if (FVector::DistSquared(launch.Location, GetWeaponGripPointTransform().GetLocation()) > FMath::Square(LaunchLocationTolerance))
+	{
+		return false;
+	}
+
+	return FVector::DotProduct(launch.Direction, GetControlRotation().Vector()) >= FMath::Cos(FMath::DegreesToRadians(LaunchDirectionTolerance));
+}
+// Recall on the server after the client predicted it, only for the throw the server is simulating and while it can still be recalled
+void APlayerCharacterBase::ServerRecallThrowingWeapon_Implementation(uint8 sequence)
+{
+	if (DefaultThrowingWeaponReference == nullptr || !bIsThrowingWeaponLaunched)
+	{
+		return;
+	}
+
+	// Sequences wrap at 256, so they are compared as the uint8 that was sent. A recall of an older throw is dropped
+	if (AppliedThrowSequence == INDEX_NONE || static_cast<uint8>(AppliedThrowSequence) != sequence)
+	{
+		return;
+	}
+
+	const ThrowingWeaponState state = DefaultThrowingWeaponReference->CurrentThrowingWeaponState;
+	if (state != ThrowingWeaponState::Launched && state != ThrowingWeaponState::Lodged)
+	{
+		return;
+	}
+
+	if (DoOnce.Execute())
+	{
+		DefaultThrowingWeaponReference->RecallThrowingWeapon();
+	}
+}
+// Wake or sleep the rope, and on the server put every new state of the weapon in ThrowingWeaponNetState
+void APlayerCharacterBase::ThrowingWeaponStateChanged(AThrowingWeaponBase* throwingWeapon, ThrowingWeaponState newState)
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerWeaponStateChanged);
+
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->RecordWeaponState(newState);
+	}
+
+	if (bUseNativeTether)
+	{
+		TetherComponent->SetThrowingWeaponState(newState);
+	}
+	else
+	{
+		RopeComponent->SetComponentTickEnabled(newState != ThrowingWeaponState::Idle);
+	}
+
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	ThrowingWeaponNetState.State = newState;
+
+	if (newState == ThrowingWeaponState::Lodged)
+	{
+		ThrowingWeaponNetState.Location = throwingWeapon->GetActorLocation();
+		ThrowingWeaponNetState.Rotation = throwingWeapon->GetLodgePointRotation();
+	}
+
+#if !UE_BUILD_SHIPPING
+	FThrowingWeaponNetState::RecordSent(ThrowingWeaponNetState, false);
+#endif
+}
+// Step the predicted throw arc, the lines are only rebuilt when the arc changed
+void APlayerCharacterBase::UpdateThrowPreview()
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerThrowPreview);
+
+	const bool bChanged = ThrowPreview.Update(*DefaultThrowingWeaponReference, GetAimedThrowDirection(), GetWeaponGripPointTransform().GetLocation());
+
+	if (!bChanged && bIsThrowPreviewDrawn)
+	{
+		return;
+	}
+
+	ThrowPreviewComponent->Flush();
+
+	const int32 numPoints = ThrowPreview.GetNumVisiblePoints();
+	for (int32 i = 0; i + 1 < numPoints; i++)
+	{
+		ThrowPreviewComponent->DrawLine(ThrowPreview.GetVisiblePoint(i), ThrowPreview.GetVisiblePoint(i + 1), ThrowPreviewColor, SDPG_World, ThrowPreviewThickness, 0);
+	}
+
+	// A small cross standing on the surface where the weapon would lodge
+	if (ThrowPreview.HasLodgePoint())
+	{
+		const FVector lodgePoint = ThrowPreview.GetLodgePoint();
+		const FVector lodgeNormal = ThrowPreview.GetLodgeNormal();
+		const FVector tangent = FVector::CrossProduct(lodgeNormal, FMath::Abs(lodgeNormal.Z) < 0.99f ? FVector::UpVector : FVector::ForwardVector).GetSafeNormal() * 15;
+		const FVector bitangent = FVector::CrossProduct(lodgeNormal, tangent);
+
+		ThrowPreviewComponent->DrawLine(lodgePoint - tangent, lodgePoint + tangent, ThrowPreviewColor, SDPG_World, ThrowPreviewThickness, 0);
+		ThrowPreviewComponent->DrawLine(lodgePoint - bitangent, lodgePoint + bitangent, ThrowPreviewColor, SDPG_World, ThrowPreviewThickness, 0);
+	}
+
+	bIsThrowPreviewDrawn = true;
+}
+// Hide the predicted throw arc, the next aim starts a new one
+void APlayerCharacterBase::ClearThrowPreview()
+{
+	ThrowPreviewComponent->Flush();
+	ThrowPreview.Reset();
+	bIsThrowPreviewDrawn = false;
+}
+// Pick the throw target in the aim cone from the target grid
+void APlayerCharacterBase::UpdateAimAssistTarget()
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerAimAssist);
+
+	const UThrowTargetSubsystem* throwTargetSubsystem = UWorld::GetSubsystem<UThrowTargetSubsystem>(GetWorld());
+
+	AimAssistTarget = throwTargetSubsystem != nullptr
+		? throwTargetSubsystem->FindBestTarget(FollowCameraComponent->GetComponentLocation(), FollowCameraComponent->GetForwardVector(), AimAssistConeAngle, AimAssistMaxDistance, this)
+		: nullptr;
+}
+// Camera forward, pulled towards the throw that hits the aim assist target when there is one
+FVector APlayerCharacterBase::GetAimedThrowDirection() const
+{
+	const FVector cameraForward = FollowCameraComponent->GetForwardVector();
+
+	const UThrowTargetComponent* target = AimAssistTarget.Get();
+	if (target == nullptr)
+	{
+		return cameraForward;
+	}
+
+	// The solved throw drops onto the target and leads it, a target out of reach just gets the straight line
+	FVector toTarget = (target->GetComponentLocation() - FollowCameraComponent->GetComponentLocation()).GetSafeNormal();
+	if (DefaultThrowingWeaponReference != nullptr)
+	{
+		const FVector targetVelocity = target->GetOwner() != nullptr ? target->GetOwner()->GetVelocity() : FVector::ZeroVector;
+		DefaultThrowingWeaponReference->SolveThrowDirection(GetWeaponGripPointTransform().GetLocation(), target->GetComponentLocation(), targetVelocity, false, toTarget);
+	}
+	return FMath::Lerp(cameraForward, toTarget, AimAssistStrength).GetSafeNormal();
+}
+// Show or hide the cable rope, the native tether shows itself while the weapon isn't Idle
+void APlayerCharacterBase::SetRopeVisibility(bool bVisible)
+{
+	if (!bUseNativeTether)
+	{
+		RopeComponent->SetVisibility(bVisible);
+	}
+}
+// Follow the server's throwing weapon state. The owning client only corrects what it predicted, everyone else plays it back
+void APlayerCharacterBase::OnRep_ThrowingWeaponNetState()
+{
+	PLAYER_CHARACTER_PROFILE_SCOPE(STAT_PlayerWeaponNetState);
+
+	if (DefaultThrowingWeaponReference == nullptr)
+	{
+		return;
+	}
+
+	const FThrowingWeaponNetState& netState = ThrowingWeaponNetState;
+	const ThrowingWeaponState state = netState.GetState();
+
+	// A throw that wasn't started here (another player's, or the launch arrived together with a later state)
+	if (state != ThrowingWeaponState::Idle && netState.Sequence != AppliedThrowSequence)
+	{
+		if (bIsThrowingWeaponLaunched)
+		{
+			CatchThrowingWeapon();
+		}
+
+		if (state == ThrowingWeaponState::Launched)
+		{
+			PerformThrow(netState);
+		}
+		else
+		{
+			SetRopeVisibility(true);
+			DefaultThrowingWeaponReference->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+
+			AppliedThrowSequence = netState.Sequence;
+			bIsThrowingWeaponLaunched = true;
+		}
+	}
+
+	switch (state)
+	{
+	case ThrowingWeaponState::Lodged:
+		DefaultThrowingWeaponReference->ReconcileLodge(netState.Location, netState.Rotation);
+		break;
+
+	case ThrowingWeaponState::Wiggle:
+	case ThrowingWeaponState::Returning:
+		if (DoOnce.Execute())
+		{
+			DefaultThrowingWeaponReference->RecallThrowingWeapon();
+		}
+		break;
+
+	case ThrowingWeaponState::Idle:
+		if (bIsThrowingWeaponLaunched)
+		{
+			CatchThrowingWeapon();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
 
 
+// Start or stop recording with Player.Replay.Record and end the recorded frame
+void APlayerCharacterBase::UpdateReplayRecording(float deltaTime)
+{
+	const bool bShouldRecord = GPlayerCharacterReplayRecord != 0 && !bIsReplayPlaying && IsLocallyControlled();
+
+	if (bShouldRecord && !ReplayWriter.IsValid())
+	{
+		FPlayerReplayHeader header;
+		header.MapName = GetWorld()->GetMapName();
+		header.Location = GetActorLocation();
+		header.Rotation = GetActorRotation();
+		header.ControlRotation = GetControlRotation();
+
+		const FString path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"), FString::Printf(TEXT("%s-%s.preplay"), *header.MapName, *FDateTime::Now().ToString()));
+
+		ReplayWriter = MakeShared<FPlayerCharacterReplayWriter>();
+		if (ReplayWriter->Open(path, header))
+		{
+			UE_LOG(LogTemp, Display, TEXT("Player.Replay: recording to %s"), *path);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Player.Replay: could not create %s, not recording"), *path);
+			GPlayerCharacterReplayRecord = 0;
+			ReplayWriter.Reset();
+		}
+		return;
+	}
+
+	if (!bShouldRecord && ReplayWriter.IsValid())
+	{
+		ReplayWriter->Close();
+		UE_LOG(LogTemp, Display, TEXT("Player.Replay: recorded %lld frames in %lld bytes to %s"), ReplayWriter->GetNumFrames(), ReplayWriter->GetNumBytes(), *ReplayWriter->GetPath());
+		ReplayWriter.Reset();
+		return;
+	}
+
+	if (ReplayWriter.IsValid())
+	{
+		ReplayWriter->EndFrame(deltaTime);
+	}
+}
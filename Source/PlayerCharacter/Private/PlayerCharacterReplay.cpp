@@ -0,0 +1,339 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerCharacterReplay.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+namespace PlayerReplay
+{
+	// Fixed size values of the header, stored as they are in memory
+	template <typename T>
+	void WriteRaw(TArray<uint8>& buffer, const T& value)
+	{
+		buffer.Append(reinterpret_cast<const uint8*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool ReadRaw(const uint8*& cursor, const uint8* end, T& outValue)
+	{
+		if (end - cursor < static_cast<int64>(sizeof(T)))
+		{
+			return false;
+		}
+		FMemory::Memcpy(&outValue, cursor, sizeof(T));
+		cursor += sizeof(T);
+		return true;
+	}
+
+	// Move uses the first slot of the previous axis values, Look the second
+	int32 GetAxisSlot(EPlayerReplayEvent type)
+	{
+		return type == EPlayerReplayEvent::Move ? 0 : 1;
+	}
+}
+
+// 7 bits per byte, high bit set while more bytes follow
+void FPlayerReplayFormat::WriteVarUInt(TArray<uint8>& buffer, uint64 value)
+{
+	while (value >= 0x80)
+	{
+		buffer.Add(static_cast<uint8>(value) | 0x80);
+		value >>= 7;
+	}
+	buffer.Add(static_cast<uint8>(value));
+}
+// Zigzag, so small negative deltas stay small
+void FPlayerReplayFormat::WriteVarInt(TArray<uint8>& buffer, int64 value)
+{
+	WriteVarUInt(buffer, (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63));
+}
+// False if the stream ends inside the value
+bool FPlayerReplayFormat::ReadVarUInt(const uint8*& cursor, const uint8* end, uint64& outValue)
+{
+	outValue = 0;
+	for (int32 shift = 0; shift < 64; shift += 7)
+	{
+		if (cursor >= end)
+		{
+			return false;
+		}
+
+		const uint8 byte = *cursor++;
+		outValue |= static_cast<uint64>(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FPlayerReplayFormat::ReadVarInt(const uint8*& cursor, const uint8* end, int64& outValue)
+{
+	uint64 zigzag = 0;
+	if (!ReadVarUInt(cursor, end, zigzag))
+	{
+		return false;
+	}
+	outValue = static_cast<int64>(zigzag >> 1) ^ -static_cast<int64>(zigzag & 1);
+	return true;
+}
+
+FPlayerCharacterReplayWriter::~FPlayerCharacterReplayWriter()
+{
+	Close();
+}
+// Create the file and write the header
+bool FPlayerCharacterReplayWriter::Open(const FString& path, const FPlayerReplayHeader& header)
+{
+	Close();
+
+	FileWriter.Reset(IFileManager::Get().CreateFileWriter(*path));
+	if (!FileWriter.IsValid())
+	{
+		return false;
+	}
+
+	Path = path;
+	Buffer.Reset();
+	FrameEvents.Reset();
+	PreviousFrameMicroseconds = 0;
+	PreviousAxis[0] = PreviousAxis[1] = FIntPoint::ZeroValue;
+	NumFrames = 0;
+	NumBytesFlushed = 0;
+
+	PlayerReplay::WriteRaw(Buffer, FPlayerReplayFormat::Magic);
+	PlayerReplay::WriteRaw(Buffer, FPlayerReplayFormat::Version);
+
+	const FTCHARToUTF8 mapName(*header.MapName);
+	FPlayerReplayFormat::WriteVarUInt(Buffer, mapName.Length());
+	Buffer.Append(reinterpret_cast<const uint8*>(mapName.Get()), mapName.Length());
+
+	PlayerReplay::WriteRaw(Buffer, header.Location);
+	PlayerReplay::WriteRaw(Buffer, header.Rotation);
+	PlayerReplay::WriteRaw(Buffer, header.ControlRotation);
+
+	// The header goes out right away, so even a recording that crashes on its first frame can be identified
+	Flush();
+	return true;
+}
+// Write the last frame and chunk
+void FPlayerCharacterReplayWriter::Close()
+{
+	if (!FileWriter.IsValid())
+	{
+		return;
+	}
+
+	// Events after the last frame ended belong to a frame that never finished, it gets the previous frame's time
+	if (FrameEvents.Num() > 0)
+	{
+		EndFrame(PreviousFrameMicroseconds / 1000000.0f);
+	}
+
+	Flush();
+	FileWriter->Close();
+	FileWriter.Reset();
+}
+// Move or Look
+void FPlayerCharacterReplayWriter::RecordAxis(EPlayerReplayEvent type, const FVector2D& axis)
+{
+	FPlayerReplayEvent& event = FrameEvents.AddDefaulted_GetRef();
+	event.Type = type;
+	event.Axis = axis;
+}
+// Aim, StopAim, LaunchThrowingWeapon or RecallThrowingWeapon
+void FPlayerCharacterReplayWriter::RecordEvent(EPlayerReplayEvent type)
+{
+	FrameEvents.AddDefaulted_GetRef().Type = type;
+}
+
+void FPlayerCharacterReplayWriter::RecordWeaponState(ThrowingWeaponState state)
+{
+	FPlayerReplayEvent& event = FrameEvents.AddDefaulted_GetRef();
+	event.Type = EPlayerReplayEvent::WeaponState;
+	event.State = state;
+}
+// Encode this frame's events
+void FPlayerCharacterReplayWriter::EndFrame(float deltaTime)
+{
+	if (!FileWriter.IsValid())
+	{
+		return;
+	}
+
+	const int64 frameMicroseconds = FMath::RoundToInt64(deltaTime * 1000000.0);
+	FPlayerReplayFormat::WriteVarInt(Buffer, frameMicroseconds - PreviousFrameMicroseconds);
+	PreviousFrameMicroseconds = frameMicroseconds;
+
+	FPlayerReplayFormat::WriteVarUInt(Buffer, FrameEvents.Num());
+
+	for (const FPlayerReplayEvent& event : FrameEvents)
+	{
+		Buffer.Add(static_cast<uint8>(event.Type));
+
+		switch (event.Type)
+		{
+		case EPlayerReplayEvent::Move:
+		case EPlayerReplayEvent::Look:
+		{
+			FIntPoint& previousAxis = PreviousAxis[PlayerReplay::GetAxisSlot(event.Type)];
+			const FIntPoint axis(FPlayerReplayFormat::QuantizeAxis(event.Axis.X), FPlayerReplayFormat::QuantizeAxis(event.Axis.Y));
+
+			FPlayerReplayFormat::WriteVarInt(Buffer, axis.X - previousAxis.X);
+			FPlayerReplayFormat::WriteVarInt(Buffer, axis.Y - previousAxis.Y);
+			previousAxis = axis;
+			break;
+		}
+
+		case EPlayerReplayEvent::WeaponState:
+			Buffer.Add(static_cast<uint8>(event.State));
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	FrameEvents.Reset();
+	NumFrames++;
+
+	if (Buffer.Num() >= FlushBytes)
+	{
+		Flush();
+	}
+}
+// Append the encoded chunk to the file
+void FPlayerCharacterReplayWriter::Flush()
+{
+	if (FileWriter.IsValid() && Buffer.Num() > 0)
+	{
+		FileWriter->Serialize(Buffer.GetData(), Buffer.Num());
+		FileWriter->Flush();
+
+		NumBytesFlushed += Buffer.Num();
+		Buffer.Reset();
+	}
+}
+
+FPlayerCharacterReplayReader::~FPlayerCharacterReplayReader()
+{
+	// The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+// Map the file and read the header
+bool FPlayerCharacterReplayReader::Open(const FString& path)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Reset();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*path));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+
+	if (MappedRegion.IsValid())
+	{
+		Begin = MappedRegion->GetMappedPtr();
+		End = Begin + MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		MappedFile.Reset();
+		if (!FFileHelper::LoadFileToArray(LoadedFile, *path, FILEREAD_Silent))
+		{
+			return false;
+		}
+		Begin = LoadedFile.GetData();
+		End = Begin + LoadedFile.Num();
+	}
+
+	Cursor = Begin;
+	PreviousFrameMicroseconds = 0;
+	PreviousAxis[0] = PreviousAxis[1] = FIntPoint::ZeroValue;
+
+	uint32 magic = 0;
+	uint16 version = 0;
+	if (!PlayerReplay::ReadRaw(Cursor, End, magic) || magic != FPlayerReplayFormat::Magic || !PlayerReplay::ReadRaw(Cursor, End, version) || version != FPlayerReplayFormat::Version)
+	{
+		return false;
+	}
+
+	uint64 mapNameLength = 0;
+	if (!FPlayerReplayFormat::ReadVarUInt(Cursor, End, mapNameLength) || static_cast<uint64>(End - Cursor) < mapNameLength)
+	{
+		return false;
+	}
+	Header.MapName = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Cursor), static_cast<int32>(mapNameLength)));
+	Cursor += mapNameLength;
+
+	return PlayerReplay::ReadRaw(Cursor, End, Header.Location) && PlayerReplay::ReadRaw(Cursor, End, Header.Rotation) && PlayerReplay::ReadRaw(Cursor, End, Header.ControlRotation);
+}
+// Next frame, false at the end of the stream (or where a crashed recording was cut off)
+bool FPlayerCharacterReplayReader::ReadFrame(float& outDeltaTime, TArray<FPlayerReplayEvent>& outEvents)
+{
+	outEvents.Reset();
+
+	int64 frameMicrosecondsDelta = 0;
+	uint64 numEvents = 0;
+	if (!FPlayerReplayFormat::ReadVarInt(Cursor, End, frameMicrosecondsDelta) || !FPlayerReplayFormat::ReadVarUInt(Cursor, End, numEvents))
+	{
+		return false;
+	}
+
+	PreviousFrameMicroseconds += frameMicrosecondsDelta;
+	outDeltaTime = PreviousFrameMicroseconds / 1000000.0f;
+
+	for (uint64 i = 0; i < numEvents; i++)
+	{
+		uint8 type = 0;
+		if (!PlayerReplay::ReadRaw(Cursor, End, type) || type >= static_cast<uint8>(EPlayerReplayEvent::Num))
+		{
+			return false;
+		}
+
+		FPlayerReplayEvent& event = outEvents.AddDefaulted_GetRef();
+		event.Type = static_cast<EPlayerReplayEvent>(type);
+
+		switch (event.Type)
+		{
+		case EPlayerReplayEvent::Move:
+		case EPlayerReplayEvent::Look:
+		{
+			int64 deltaX = 0;
+			int64 deltaY = 0;
+			if (!FPlayerReplayFormat::ReadVarInt(Cursor, End, deltaX) || !FPlayerReplayFormat::ReadVarInt(Cursor, End, deltaY))
+			{
+				return false;
+			}
+
+			FIntPoint& previousAxis = PreviousAxis[PlayerReplay::GetAxisSlot(event.Type)];
+			previousAxis += FIntPoint(static_cast<int32>(deltaX), static_cast<int32>(deltaY));
+			event.Axis = FVector2D(previousAxis.X / FPlayerReplayFormat::AxisScale, previousAxis.Y / FPlayerReplayFormat::AxisScale);
+			break;
+		}
+
+		case EPlayerReplayEvent::WeaponState:
+		{
+			uint8 state = 0;
+			if (!PlayerReplay::ReadRaw(Cursor, End, state))
+			{
+				return false;
+			}
+			event.State = static_cast<ThrowingWeaponState>(state);
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,384 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "PlayerCharacterBase.h"
+#include "PlayerCharacterReplay.h"
+#include "Weapon/public/DefaultThrowingWeapon.h"
+#include "Containers/Ticker.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "InputActionValue.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+
+/// <summary>
+/// Player.Replay.Play: drives the local player with a session recorded by Player.Replay.Record. Every recorded frame runs
+/// with its recorded frame time on a fixed time step and gets its recorded input, so the same file always plays the same
+/// session and can be used as a benchmark. Logs and writes a JSON report with game thread frame times, the slowest frames
+/// and whether the throwing weapon went through the recorded states within MaxFrameOffset frames. Works headless
+/// (-nullrhi -ExecCmds="Player.Replay.Play File=<replay> -Quit")
+/// </summary>
+struct FPlayerCharacterReplayPlayback
+{
+	struct FWeaponStateChange
+	{
+		int64 Frame = 0;
+		ThrowingWeaponState State = ThrowingWeaponState::Idle;
+	};
+
+	TWeakObjectPtr<APlayerCharacterBase> Character;
+	TWeakObjectPtr<APlayerController> PlayerController;
+	FPlayerCharacterReplayReader Reader;
+	FString ReplayPath;
+	FString ReportPath;
+	bool bQuitWhenFinished = false; // Exit the process with the result (0 same weapon states as recorded, 1 diverged or too far apart)
+	int64 MaxStateFrameOffset = 2; // Most frames a played weapon state may be from the recorded one before the run fails
+	bool bStopRequested = false;
+
+	TArray<FPlayerReplayEvent> FrameEvents; // Input of the frame that is about to be played
+	float FrameDeltaTime = 0;
+	bool bHasFrame = false;
+	int64 Frame = 0;
+
+	TArray<float> FrameMilliseconds; // Game thread time of every played frame
+	TArray<FWeaponStateChange> RecordedStates;
+	TArray<FWeaponStateChange> PlayedStates;
+	FDelegateHandle WeaponStateChangedHandle;
+
+	bool bWasUsingFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0;
+
+	static TWeakPtr<FPlayerCharacterReplayPlayback> Active; // The running playback, Player.Replay.Stop ends it
+
+	bool Tick(float deltaTime); // Play one recorded frame, false once the replay is finished
+
+	void ReadNextFrame(); // Read the frame the next tick applies
+
+	void ApplyInput(APlayerCharacterBase& character); // Call the input handlers with this frame's recorded input
+
+	void WeaponStateChanged(AThrowingWeaponBase* throwingWeapon, ThrowingWeaponState newState);
+
+	void Finish();
+	bool HasPassed(int32 numDivergedStates, int64 maxStateFrameOffset) const { return numDivergedStates == 0 && maxStateFrameOffset <= MaxStateFrameOffset; }
+	bool WriteReport(float medianMs, float p90Ms, float p99Ms, float maxMs, int32 numDivergedStates, int64 maxStateFrameOffset) const;
+
+	static float GetPercentile(const TArray<float>& sortedValues, float percentile);
+
+	static void Run(const TArray<FString>& args, UWorld* world); // Player.Replay.Play console command
+	static void Stop(); // Player.Replay.Stop console command
+};
+
+TWeakPtr<FPlayerCharacterReplayPlayback> FPlayerCharacterReplayPlayback::Active;
+
+// Read the frame the next tick applies
+void FPlayerCharacterReplayPlayback::ReadNextFrame()
+{
+	bHasFrame = Reader.ReadFrame(FrameDeltaTime, FrameEvents);
+
+	if (bHasFrame)
+	{
+		// Only the input is played back, the weapon states are what the session should do with it. They are stamped with
+		// the frame count they are played at, the count goes up when this frame's input is applied
+		for (const FPlayerReplayEvent& event : FrameEvents)
+		{
+			if (event.Type == EPlayerReplayEvent::WeaponState)
+			{
+				RecordedStates.Add({ Frame + 1, event.State });
+			}
+		}
+	}
+}
+// Call the input handlers with this frame's recorded input
+void FPlayerCharacterReplayPlayback::ApplyInput(APlayerCharacterBase& character)
+{
+	for (const FPlayerReplayEvent& event : FrameEvents)
+	{
+		switch (event.Type)
+		{
+		case EPlayerReplayEvent::Move:
+			character.Move(FInputActionValue(event.Axis));
+			break;
+
+		case EPlayerReplayEvent::Look:
+			character.Look(FInputActionValue(event.Axis));
+			break;
+
+		case EPlayerReplayEvent::Aim:
+			character.Aim();
+			break;
+
+		case EPlayerReplayEvent::StopAim:
+			character.StopAim();
+			break;
+
+		case EPlayerReplayEvent::LaunchThrowingWeapon:
+			character.LaunchThrowingWeapon();
+			break;
+
+		case EPlayerReplayEvent::RecallThrowingWeapon:
+			character.RecallThrowingWeapon();
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void FPlayerCharacterReplayPlayback::WeaponStateChanged(AThrowingWeaponBase* throwingWeapon, ThrowingWeaponState newState)
+{
+	PlayedStates.Add({ Frame, newState });
+}
+// Play one recorded frame per engine frame, false once the replay is finished
+bool FPlayerCharacterReplayPlayback::Tick(float deltaTime)
+{
+	APlayerCharacterBase* character = Character.Get();
+	if (character == nullptr || character->GetDefaultThrowingWeapon() == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay stopped, the player character or its weapon is gone"));
+		Finish();
+		return false;
+	}
+
+	// GGameThreadTime is the previous frame, which ran the previous recorded frame
+	if (Frame > 0)
+	{
+		FrameMilliseconds.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+	}
+
+	if (!bHasFrame || bStopRequested)
+	{
+		Finish();
+		return false;
+	}
+
+	// The core ticker runs after the world, so this input is handled by the next engine frame. That frame gets the time
+	// the input was recorded with, the same as the world step it was recorded in
+	ApplyInput(*character);
+	FApp::SetFixedDeltaTime(FMath::Max(FrameDeltaTime, 0.0001f));
+
+	Frame++;
+	ReadNextFrame();
+	return true;
+}
+
+float FPlayerCharacterReplayPlayback::GetPercentile(const TArray<float>& sortedValues, float percentile)
+{
+	if (sortedValues.Num() == 0)
+	{
+		return 0;
+	}
+	return sortedValues[FMath::Clamp(FMath::CeilToInt(percentile * sortedValues.Num()) - 1, 0, sortedValues.Num() - 1)];
+}
+// Compare the weapon states with the recording, log, write the report and give the player back its input
+void FPlayerCharacterReplayPlayback::Finish()
+{
+	FApp::SetUseFixedTimeStep(bWasUsingFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	if (APlayerCharacterBase* character = Character.Get())
+	{
+		character->bIsReplayPlaying = false;
+
+		if (character->GetDefaultThrowingWeapon() != nullptr)
+		{
+			character->GetDefaultThrowingWeapon()->OnThrowingWeaponStateChanged.Remove(WeaponStateChangedHandle);
+		}
+		if (APlayerController* playerController = PlayerController.Get())
+		{
+			character->EnableInput(playerController);
+		}
+	}
+
+	// The same input has to take the weapon through the same states, at most MaxStateFrameOffset frames apart
+	int32 numDivergedStates = FMath::Abs(RecordedStates.Num() - PlayedStates.Num());
+	int64 maxStateFrameOffset = 0;
+	for (int32 i = 0; i < FMath::Min(RecordedStates.Num(), PlayedStates.Num()); i++)
+	{
+		numDivergedStates += RecordedStates[i].State != PlayedStates[i].State ? 1 : 0;
+		maxStateFrameOffset = FMath::Max(maxStateFrameOffset, FMath::Abs(RecordedStates[i].Frame - PlayedStates[i].Frame));
+	}
+
+	TArray<float> sortedMilliseconds = FrameMilliseconds;
+	sortedMilliseconds.Sort();
+
+	const float medianMs = GetPercentile(sortedMilliseconds, 0.5f);
+	const float p90Ms = GetPercentile(sortedMilliseconds, 0.9f);
+	const float p99Ms = GetPercentile(sortedMilliseconds, 0.99f);
+	const float maxMs = sortedMilliseconds.Num() > 0 ? sortedMilliseconds.Last() : 0;
+
+	UE_LOG(LogTemp, Display, TEXT("Player.Replay: %lld frames of %s (%s): median %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms, %d/%d weapon states diverged (max %lld frames apart)"),
+		Frame, *ReplayPath, Reader.IsMemoryMapped() ? TEXT("memory mapped") : TEXT("loaded"),
+		medianMs, p90Ms, p99Ms, maxMs, numDivergedStates, RecordedStates.Num(), maxStateFrameOffset);
+
+	if (numDivergedStates > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay: the weapon didn't go through the recorded states, the session isn't the one that was recorded (different map, build or start)"));
+	}
+	else if (maxStateFrameOffset > MaxStateFrameOffset)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay: the weapon states are up to %lld frames from the recording (%lld allowed), the playback isn't deterministic"), maxStateFrameOffset, MaxStateFrameOffset);
+	}
+
+	if (!WriteReport(medianMs, p90Ms, p99Ms, maxMs, numDivergedStates, maxStateFrameOffset))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write the replay report to %s"), *ReportPath);
+	}
+
+	if (bQuitWhenFinished)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, HasPassed(numDivergedStates, maxStateFrameOffset) ? 0 : 1);
+	}
+}
+// Settings, frame time percentiles, the slowest frames and the weapon state comparison
+bool FPlayerCharacterReplayPlayback::WriteReport(float medianMs, float p90Ms, float p99Ms, float maxMs, int32 numDivergedStates, int64 maxStateFrameOffset) const
+{
+	// Frame i of FrameMilliseconds played recorded frame i, so a spike can be found in the recording
+	TArray<int32> slowestFrames;
+	for (int32 i = 0; i < FrameMilliseconds.Num(); i++)
+	{
+		slowestFrames.Add(i);
+	}
+	slowestFrames.Sort([this](int32 a, int32 b) { return FrameMilliseconds[a] > FrameMilliseconds[b]; });
+	slowestFrames.SetNum(FMath::Min(slowestFrames.Num(), 10));
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+
+	writer->WriteObjectStart();
+	writer->WriteValue(TEXT("replay"), ReplayPath);
+	writer->WriteValue(TEXT("recordedMap"), Reader.GetHeader().MapName);
+	writer->WriteValue(TEXT("map"), Character.IsValid() ? Character->GetWorld()->GetMapName() : FString());
+	writer->WriteValue(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	writer->WriteValue(TEXT("bytes"), Reader.GetNumBytes());
+	writer->WriteValue(TEXT("memoryMapped"), Reader.IsMemoryMapped());
+	writer->WriteValue(TEXT("frames"), Frame);
+	writer->WriteValue(TEXT("medianMs"), medianMs);
+	writer->WriteValue(TEXT("p90Ms"), p90Ms);
+	writer->WriteValue(TEXT("p99Ms"), p99Ms);
+	writer->WriteValue(TEXT("maxMs"), maxMs);
+
+	writer->WriteArrayStart(TEXT("slowestFrames"));
+	for (int32 frame : slowestFrames)
+	{
+		writer->WriteObjectStart();
+		writer->WriteValue(TEXT("frame"), frame);
+		writer->WriteValue(TEXT("ms"), FrameMilliseconds[frame]);
+		writer->WriteObjectEnd();
+	}
+	writer->WriteArrayEnd();
+
+	writer->WriteValue(TEXT("recordedWeaponStates"), RecordedStates.Num());
+	writer->WriteValue(TEXT("playedWeaponStates"), PlayedStates.Num());
+	writer->WriteValue(TEXT("divergedWeaponStates"), numDivergedStates);
+	writer->WriteValue(TEXT("maxWeaponStateFrameOffset"), maxStateFrameOffset);
+	writer->WriteValue(TEXT("maxAllowedWeaponStateFrameOffset"), MaxStateFrameOffset);
+	writer->WriteValue(TEXT("passed"), HasPassed(numDivergedStates, maxStateFrameOffset));
+
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	return FFileHelper::SaveStringToFile(json, *ReportPath);
+}
+// Player.Replay.Play console command
+void FPlayerCharacterReplayPlayback::Run(const TArray<FString>& args, UWorld* world)
+{
+	if (Active.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay is already playing, Player.Replay.Stop ends it"));
+		return;
+	}
+
+	APlayerController* playerController = world != nullptr ? world->GetFirstPlayerController() : nullptr;
+	APlayerCharacterBase* character = playerController != nullptr ? Cast<APlayerCharacterBase>(playerController->GetPawn()) : nullptr;
+
+	if (character == nullptr || character->GetDefaultThrowingWeapon() == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay needs a game with a local player character holding its throwing weapon"));
+		return;
+	}
+
+	const FString arguments = FString::Join(args, TEXT(" "));
+
+	TSharedRef<FPlayerCharacterReplayPlayback> playback = MakeShared<FPlayerCharacterReplayPlayback>();
+	playback->Character = character;
+	playback->PlayerController = playerController;
+
+	FParse::Value(*arguments, TEXT("File="), playback->ReplayPath);
+	playback->ReplayPath = FPaths::IsRelative(playback->ReplayPath) ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"), playback->ReplayPath) : playback->ReplayPath;
+
+	if (!playback->Reader.Open(playback->ReplayPath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay: %s isn't a replay recorded by Player.Replay.Record"), *playback->ReplayPath);
+		return;
+	}
+
+	const FPlayerReplayHeader& header = playback->Reader.GetHeader();
+	if (header.MapName != world->GetMapName())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Replay: recorded on %s, playing on %s"), *header.MapName, *world->GetMapName());
+	}
+
+	FString reportName = FString::Printf(TEXT("PlayerReplay-%s.json"), *FDateTime::Now().ToString());
+	FParse::Value(*arguments, TEXT("Report="), reportName);
+	playback->ReportPath = FPaths::IsRelative(reportName) ? FPaths::Combine(FPaths::ProfilingDir(), reportName) : reportName;
+	playback->bQuitWhenFinished = FParse::Param(*arguments, TEXT("Quit"));
+	FParse::Value(*arguments, TEXT("MaxFrameOffset="), playback->MaxStateFrameOffset);
+
+	// Start where the recording started, with the weapon in the hand and only the replay controlling the player
+	if (character->bIsThrowingWeaponLaunched)
+	{
+		character->CatchThrowingWeapon();
+	}
+	character->StopAim();
+	character->SetActorLocationAndRotation(header.Location, header.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	playerController->SetControlRotation(header.ControlRotation);
+	character->DisableInput(playerController);
+	character->bIsReplayPlaying = true;
+
+	playback->WeaponStateChangedHandle = character->GetDefaultThrowingWeapon()->OnThrowingWeaponStateChanged.AddRaw(&playback.Get(), &FPlayerCharacterReplayPlayback::WeaponStateChanged);
+
+	playback->bWasUsingFixedTimeStep = FApp::UseFixedTimeStep();
+	playback->PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	playback->ReadNextFrame();
+
+	UE_LOG(LogTemp, Display, TEXT("Player.Replay: playing %s (%lld bytes, %s), report %s"), *playback->ReplayPath, playback->Reader.GetNumBytes(),
+		playback->Reader.IsMemoryMapped() ? TEXT("memory mapped") : TEXT("loaded"), *playback->ReportPath);
+
+	Active = playback;
+
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([playback](float deltaTime)
+	{
+		return playback->Tick(deltaTime);
+	}));
+}
+// Player.Replay.Stop console command, the playback finishes on the next frame
+void FPlayerCharacterReplayPlayback::Stop()
+{
+	if (TSharedPtr<FPlayerCharacterReplayPlayback> playback = Active.Pin())
+	{
+		playback->bStopRequested = true;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdPlayerCharacterReplayPlay(
+	TEXT("Player.Replay.Play"),
+	TEXT("Drive the local player with a Player.Replay.Record session on a fixed time step and write a JSON report of game thread frame times and weapon state divergence. ")
+	TEXT("Arguments: File=<replay, relative to Saved/Replays> Report=<file> MaxFrameOffset=<frames a weapon state may be off, 2> -Quit (exit with 0 same weapon states, 1 diverged)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FPlayerCharacterReplayPlayback::Run));
+
+static FAutoConsoleCommand CmdPlayerCharacterReplayStop(
+	TEXT("Player.Replay.Stop"),
+	TEXT("Finish the running Player.Replay.Play and write its report"),
+	FConsoleCommandDelegate::CreateStatic(&FPlayerCharacterReplayPlayback::Stop));
+
+#endif
@@ -0,0 +1,382 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerCharacterSessionSoak.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "PlayerCharacterBase.h"
+#include "Weapon/public/DefaultThrowingWeapon.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "TimerManager.h"
+#include "UObject/UObjectArray.h"
+
+TWeakPtr<FPlayerCharacterSessionSoak> FPlayerCharacterSessionSoak::Active;
+
+/// <summary>
+/// Reads the total out of FTimerManager::ListTimers, the timer manager has no public count
+/// </summary>
+class FTimerCountOutputDevice : public FOutputDevice
+{
+public:
+	int64 NumTimers = -1;
+
+	virtual void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override
+	{
+		const FString line(V);
+		if (line.Contains(TEXT("Total Timers")))
+		{
+			NumTimers = FCString::Atoi64(*line.Replace(TEXT("-"), TEXT("")).TrimStart());
+		}
+	}
+};
+
+// Active, paused and pending timers of the world's timer manager, -1 if the count couldn't be read
+int64 FPlayerCharacterSessionSoak::CountTimers(UWorld* world)
+{
+	if (world == nullptr)
+	{
+		return -1;
+	}
+
+	FTimerCountOutputDevice timerCount;
+	GLog->AddOutputDevice(&timerCount);
+	world->GetTimerManager().ListTimers();
+	GLog->RemoveOutputDevice(&timerCount);
+
+	return timerCount.NumTimers;
+}
+// Every component attached below the actor's root, the weapon is attached to the player while it is caught
+int64 FPlayerCharacterSessionSoak::CountAttachedComponents(const AActor* actor)
+{
+	if (actor == nullptr || actor->GetRootComponent() == nullptr)
+	{
+		return 0;
+	}
+
+	TArray<USceneComponent*> children;
+	actor->GetRootComponent()->GetChildrenComponents(true, children);
+	return children.Num();
+}
+// Aim somewhere new (down at the ground so the weapon lodges) and start aiming
+void FPlayerCharacterSessionSoak::StartCycle(APlayerCharacterBase& character)
+{
+	if (AController* controller = character.GetController())
+	{
+		controller->SetControlRotation(FRotator(-25, Cycles * 47.0f, 0));
+	}
+
+	character.Aim();
+
+	Phase = EPhase::Aim;
+	PhaseSeconds = 0;
+}
+
+void FPlayerCharacterSessionSoak::TakeSample(const APlayerCharacterBase& character)
+{
+	const FPlatformMemoryStats memoryStats = FPlatformMemory::GetStats();
+
+	FSample& sample = Samples.AddDefaulted_GetRef();
+	sample.Seconds = ElapsedSeconds;
+	sample.Cycles = Cycles;
+	sample.UsedPhysicalMB = memoryStats.UsedPhysical / (1024.0 * 1024.0);
+	sample.UsedVirtualMB = memoryStats.UsedVirtual / (1024.0 * 1024.0);
+	sample.NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	sample.NumTimers = CountTimers(character.GetWorld());
+	sample.NumAttachedComponents = CountAttachedComponents(&character) + (character.GetDefaultThrowingWeapon() != nullptr && character.bIsThrowingWeaponLaunched ? CountAttachedComponents(character.GetDefaultThrowingWeapon()) : 0);
+
+	UE_LOG(LogTemp, Display, TEXT("Player.Soak: %.0f s, %d cycles, %.1f MB physical, %.1f MB virtual, %lld UObjects, %lld timers, %lld attached components"),
+		sample.Seconds, sample.Cycles, sample.UsedPhysicalMB, sample.UsedVirtualMB, sample.NumObjects, sample.NumTimers, sample.NumAttachedComponents);
+
+	// Written every sample so a crash or a killed process still leaves the trend so far
+	WriteReport(false, nullptr);
+}
+// Step the soak once per engine frame, false once it is finished
+bool FPlayerCharacterSessionSoak::Tick(float deltaTime)
+{
+	APlayerCharacterBase* character = Character.Get();
+	if (character == nullptr || character->GetDefaultThrowingWeapon() == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Soak stopped, the player character or its weapon is gone"));
+		Finish();
+		return false;
+	}
+
+	ElapsedSeconds += deltaTime;
+	PhaseSeconds += deltaTime;
+
+	const ThrowingWeaponState weaponState = character->GetDefaultThrowingWeapon()->CurrentThrowingWeaponState;
+
+	switch (Phase)
+	{
+	case EPhase::Aim:
+		character->Aim(); // Triggered every frame while held
+		if (PhaseSeconds >= 0.3)
+		{
+			character->LaunchThrowingWeapon();
+			Phase = EPhase::Flight;
+			PhaseSeconds = 0;
+		}
+		break;
+
+	case EPhase::Flight:
+		if (weaponState == ThrowingWeaponState::Lodged || PhaseSeconds >= MaxPhaseSeconds)
+		{
+			MissedLodges += weaponState != ThrowingWeaponState::Lodged ? 1 : 0;
+			character->RecallThrowingWeapon();
+			Phase = EPhase::Return;
+			PhaseSeconds = 0;
+		}
+		break;
+
+	case EPhase::Return:
+		if (!character->bIsThrowingWeaponLaunched || PhaseSeconds >= MaxPhaseSeconds)
+		{
+			if (character->bIsThrowingWeaponLaunched)
+			{
+				ForcedCatches++;
+				character->CatchThrowingWeapon();
+			}
+
+			character->StopAim();
+			Cycles++;
+
+			if (ElapsedSeconds >= NextSampleSeconds)
+			{
+				TakeSample(*character);
+				NextSampleSeconds += SampleSeconds;
+			}
+
+			if (bStopRequested || ElapsedSeconds >= DurationSeconds)
+			{
+				Finish();
+				return false;
+			}
+
+			StartCycle(*character);
+		}
+		break;
+	}
+	return true;
+}
+// Write the final report and log every value that only ever grew
+void FPlayerCharacterSessionSoak::Finish()
+{
+	GrowingMetrics.Reset();
+	const bool bWritten = WriteReport(true, &GrowingMetrics);
+	const bool bPassed = GrowingMetrics.Num() == 0;
+
+	for (const FString& metric : GrowingMetrics)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Player.Soak: %s grew monotonically over the session"), *metric);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Player.Soak: %d cycles in %.0f s, %d samples, %d missed lodges, %d forced catches, %s"),
+		Cycles, ElapsedSeconds, Samples.Num(), MissedLodges, ForcedCatches, bPassed ? TEXT("flat") : TEXT("GROWTH FLAGGED"));
+
+	if (!bWritten)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write the soak report to %s"), *ReportPath);
+	}
+
+	if (bQuitWhenFinished)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+// Settings, every sample and per metric trend (least squares slope per hour and whether it never went down)
+bool FPlayerCharacterSessionSoak::WriteReport(bool bFinished, TArray<FString>* outGrowingMetrics) const
+{
+	struct FMetric
+	{
+		const TCHAR* Name;
+		double (*Get)(const FSample&);
+		double MinGrowth; // Net growth below this is noise, not a leak
+	};
+
+	const FMetric metrics[] =
+	{
+		{ TEXT("usedPhysicalMB"), [](const FSample& sample) { return sample.UsedPhysicalMB; }, 1.0 },
+		{ TEXT("usedVirtualMB"), [](const FSample& sample) { return sample.UsedVirtualMB; }, 1.0 },
+		{ TEXT("uobjects"), [](const FSample& sample) { return static_cast<double>(sample.NumObjects); }, 0.5 },
+		{ TEXT("timers"), [](const FSample& sample) { return static_cast<double>(sample.NumTimers); }, 0.5 },
+		{ TEXT("attachedComponents"), [](const FSample& sample) { return static_cast<double>(sample.NumAttachedComponents); }, 0.5 },
+	};
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+
+	writer->WriteObjectStart();
+	writer->WriteValue(TEXT("map"), Character.IsValid() ? Character->GetWorld()->GetMapName() : FString());
+	writer->WriteValue(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	writer->WriteValue(TEXT("finished"), bFinished);
+	writer->WriteValue(TEXT("seconds"), ElapsedSeconds);
+	writer->WriteValue(TEXT("cycles"), Cycles);
+	writer->WriteValue(TEXT("missedLodges"), MissedLodges);
+	writer->WriteValue(TEXT("forcedCatches"), ForcedCatches);
+	writer->WriteValue(TEXT("sampleSeconds"), SampleSeconds);
+	writer->WriteValue(TEXT("warmupSamples"), NumWarmupSamples);
+
+	bool bPassed = true;
+	const int32 firstTrendSample = FMath::Min(NumWarmupSamples, Samples.Num());
+	const int32 numTrendSamples = Samples.Num() - firstTrendSample;
+
+	writer->WriteObjectStart(TEXT("trends"));
+	for (const FMetric& metric : metrics)
+	{
+		// Least squares slope over time, in units per hour
+		double meanSeconds = 0;
+		double meanValue = 0;
+		for (int32 i = firstTrendSample; i < Samples.Num(); i++)
+		{
+			meanSeconds += Samples[i].Seconds;
+			meanValue += metric.Get(Samples[i]);
+		}
+		meanSeconds /= FMath::Max(1, numTrendSamples);
+		meanValue /= FMath::Max(1, numTrendSamples);
+
+		double covariance = 0;
+		double variance = 0;
+		bool bNeverDecreased = true;
+		for (int32 i = firstTrendSample; i < Samples.Num(); i++)
+		{
+			const double value = metric.Get(Samples[i]);
+			covariance += (Samples[i].Seconds - meanSeconds) * (value - meanValue);
+			variance += FMath::Square(Samples[i].Seconds - meanSeconds);
+			bNeverDecreased &= i == firstTrendSample || value >= metric.Get(Samples[i - 1]);
+		}
+
+		const double slopePerHour = variance > 0 ? covariance / variance * 3600 : 0;
+		const double growth = numTrendSamples > 0 ? metric.Get(Samples.Last()) - metric.Get(Samples[firstTrendSample]) : 0;
+
+		// A few samples can't tell a leak from a cache filling up
+		const bool bMonotonicGrowth = numTrendSamples >= 4 && bNeverDecreased && growth >= metric.MinGrowth;
+
+		if (bMonotonicGrowth)
+		{
+			bPassed = false;
+			if (outGrowingMetrics != nullptr)
+			{
+				outGrowingMetrics->Add(FString::Printf(TEXT("%s (%+.2f, %+.2f per hour)"), metric.Name, growth, slopePerHour));
+			}
+		}
+
+		writer->WriteObjectStart(metric.Name);
+		writer->WriteValue(TEXT("first"), numTrendSamples > 0 ? metric.Get(Samples[firstTrendSample]) : 0.0);
+		writer->WriteValue(TEXT("last"), numTrendSamples > 0 ? metric.Get(Samples.Last()) : 0.0);
+		writer->WriteValue(TEXT("growth"), growth);
+		writer->WriteValue(TEXT("slopePerHour"), slopePerHour);
+		writer->WriteValue(TEXT("monotonicGrowth"), bMonotonicGrowth);
+		writer->WriteObjectEnd();
+	}
+	writer->WriteObjectEnd();
+
+	writer->WriteValue(TEXT("passed"), bPassed);
+
+	writer->WriteArrayStart(TEXT("samples"));
+	for (const FSample& sample : Samples)
+	{
+		writer->WriteObjectStart();
+		writer->WriteValue(TEXT("seconds"), sample.Seconds);
+		writer->WriteValue(TEXT("cycles"), sample.Cycles);
+		for (const FMetric& metric : metrics)
+		{
+			writer->WriteValue(metric.Name, metric.Get(sample));
+		}
+		writer->WriteObjectEnd();
+	}
+	writer->WriteArrayEnd();
+
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	return FFileHelper::SaveStringToFile(json, *ReportPath);
+}
+// Take the first sample and start aiming, null without a ready player character
+TSharedPtr<FPlayerCharacterSessionSoak> FPlayerCharacterSessionSoak::Start(const FString& arguments, UWorld* world)
+{
+	if (Active.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Soak is already running, Player.Soak.Stop ends it"));
+		return nullptr;
+	}
+
+	APlayerController* playerController = world != nullptr ? world->GetFirstPlayerController() : nullptr;
+	APlayerCharacterBase* character = playerController != nullptr ? Cast<APlayerCharacterBase>(playerController->GetPawn()) : nullptr;
+
+	if (character == nullptr || character->GetDefaultThrowingWeapon() == nullptr || character->bIsThrowingWeaponLaunched)
+	{
+		return nullptr;
+	}
+
+	TSharedRef<FPlayerCharacterSessionSoak> soak = MakeShared<FPlayerCharacterSessionSoak>();
+	soak->Character = character;
+
+	double hours = 4;
+	FParse::Value(*arguments, TEXT("Hours="), hours);
+	FParse::Value(*arguments, TEXT("SampleSeconds="), soak->SampleSeconds);
+	FParse::Value(*arguments, TEXT("MaxPhaseSeconds="), soak->MaxPhaseSeconds);
+	FParse::Value(*arguments, TEXT("WarmupSamples="), soak->NumWarmupSamples);
+	soak->bQuitWhenFinished = FParse::Param(*arguments, TEXT("Quit"));
+	soak->DurationSeconds = FMath::Max(0.0, hours) * 3600;
+	soak->SampleSeconds = FMath::Max(1.0, soak->SampleSeconds);
+	soak->NumWarmupSamples = FMath::Max(0, soak->NumWarmupSamples);
+
+	FString reportName = FString::Printf(TEXT("PlayerSoak-%s.json"), *FDateTime::Now().ToString());
+	FParse::Value(*arguments, TEXT("Report="), reportName);
+	soak->ReportPath = FPaths::IsRelative(reportName) ? FPaths::Combine(FPaths::ProfilingDir(), reportName) : reportName;
+
+	UE_LOG(LogTemp, Display, TEXT("Player.Soak: running for %.2f hours, a sample every %.0f s, report %s"), hours, soak->SampleSeconds, *soak->ReportPath);
+
+	soak->TakeSample(*character);
+	soak->NextSampleSeconds = soak->SampleSeconds;
+	soak->StartCycle(*character);
+
+	Active = soak;
+	return soak;
+}
+// Player.Soak.Run console command
+void FPlayerCharacterSessionSoak::Run(const TArray<FString>& args, UWorld* world)
+{
+	const TSharedPtr<FPlayerCharacterSessionSoak> soak = Start(FString::Join(args, TEXT(" ")), world);
+	if (!soak.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Player.Soak needs a game with a local player character holding its throwing weapon, and only one soak at a time"));
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([soak](float deltaTime)
+	{
+		return soak->Tick(deltaTime);
+	}));
+}
+// Player.Soak.Stop console command, the soak finishes after the current cycle
+void FPlayerCharacterSessionSoak::Stop()
+{
+	if (TSharedPtr<FPlayerCharacterSessionSoak> soak = Active.Pin())
+	{
+		soak->bStopRequested = true;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdPlayerCharacterSessionSoakRun(
+	TEXT("Player.Soak.Run"),
+	TEXT("Throw/lodge/recall/catch with the local player in real time and write a JSON trend report of memory, UObjects, timers and attached components. ")
+	TEXT("Arguments: Hours=4 SampleSeconds=60 MaxPhaseSeconds=5 WarmupSamples=2 Report=<file> -Quit (exit with 0 flat, 1 growth flagged)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FPlayerCharacterSessionSoak::Run));
+
+static FAutoConsoleCommand CmdPlayerCharacterSessionSoakStop(
+	TEXT("Player.Soak.Stop"),
+	TEXT("Finish the running Player.Soak.Run after the current cycle and write its report"),
+	FConsoleCommandDelegate::CreateStatic(&FPlayerCharacterSessionSoak::Stop));
+
+#endif
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class AActor;
+class APlayerCharacterBase;
+class UWorld;
+
+/// <summary>
+/// Player.Soak.Run: drives the local player through aim, throw, lodge, recall, wiggle, return and catch in real time for
+/// hours, samples memory, UObjects, timers and attached components at an interval and writes a JSON trend report that
+/// flags every value that only ever grew. Works headless (-nullrhi -ExecCmds="Player.Soak.Run Hours=8 -Quit"). The
+/// Player.Soak.Session automation test runs it for a few minutes and fails on any flagged growth
+/// </summary>
+struct FPlayerCharacterSessionSoak
+{
+	enum class EPhase : uint8
+	{
+		Aim, // Aiming before the throw
+		Flight, // Thrown, waiting for the weapon to lodge
+		Return, // Recalled, waiting for the catch
+	};
+
+	struct FSample
+	{
+		double Seconds = 0; // Since the soak started
+		int32 Cycles = 0;
+		double UsedPhysicalMB = 0;
+		double UsedVirtualMB = 0;
+		int64 NumObjects = 0;
+		int64 NumTimers = 0; // Active, paused and pending timers of the world's timer manager
+		int64 NumAttachedComponents = 0; // Components attached under the player and its weapon, grows if a reattach leaks
+	};
+
+	TWeakObjectPtr<APlayerCharacterBase> Character;
+
+	double DurationSeconds = 4 * 3600;
+	double SampleSeconds = 60;
+	double MaxPhaseSeconds = 5; // A throw or return that takes longer is cut short (and counted)
+	int32 NumWarmupSamples = 2; // Samples before the pools and caches are warm, left out of the trend
+	bool bQuitWhenFinished = false; // Exit the process with the result (0 flat, 1 growth flagged)
+	FString ReportPath;
+
+	EPhase Phase = EPhase::Aim;
+	double PhaseSeconds = 0;
+	double ElapsedSeconds = 0;
+	double NextSampleSeconds = 0;
+	int32 Cycles = 0;
+	int32 MissedLodges = 0; // Throws recalled out of the air
+	int32 ForcedCatches = 0; // Returns that never arrived
+	bool bStopRequested = false;
+
+	TArray<FSample> Samples;
+	TArray<FString> GrowingMetrics; // Values that only ever grew, set by Finish
+
+	static TWeakPtr<FPlayerCharacterSessionSoak> Active; // The running soak, Player.Soak.Stop ends it
+
+	bool Tick(float deltaTime); // Step the soak, false once it is finished
+
+	void StartCycle(APlayerCharacterBase& character);
+	void TakeSample(const APlayerCharacterBase& character);
+	void Finish();
+	bool WriteReport(bool bFinished, TArray<FString>* outGrowingMetrics) const;
+
+	static int64 CountTimers(UWorld* world);
+	static int64 CountAttachedComponents(const AActor* actor);
+
+	static TSharedPtr<FPlayerCharacterSessionSoak> Start(const FString& arguments, UWorld* world); // Take the first sample and start aiming, null without a ready player character
+
+	static void Run(const TArray<FString>& args, UWorld* world); // Player.Soak.Run console command
+	static void Stop(); // Player.Soak.Stop console command
+};
+
+#endif
@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerCharacterStats.h"
+
+#if WITH_PLAYER_CHARACTER_PROFILING
+UE_TRACE_CHANNEL_DEFINE(PlayerCharacterChannel);
+#endif
+
+DEFINE_STAT(STAT_PlayerRangedCamera);
+DEFINE_STAT(STAT_PlayerRotation);
+DEFINE_STAT(STAT_PlayerAttachWeapon);
+DEFINE_STAT(STAT_PlayerDetachWeapon);
+DEFINE_STAT(STAT_PlayerWeaponStateChanged);
+DEFINE_STAT(STAT_PlayerWeaponNetState);
+DEFINE_STAT(STAT_PlayerThrowPreview);
+DEFINE_STAT(STAT_PlayerRopeUpdate);
+DEFINE_STAT(STAT_PlayerRopeUpdates);
+DEFINE_STAT(STAT_PlayerAimAssist);
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerCharacterSessionSoak.h"
+#include "Struct/public/LatentWorldTest.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlayerCharacterSessionSoakTest, "Player.Soak.Session", EAutomationTestFlags::ClientContext | EAutomationTestFlags::StressFilter)
+
+// Soak the test level's player character for a few minutes and check its trends at the end
+bool FPlayerCharacterSessionSoakTest::RunTest(const FString& Parameters)
+{
+	FLatentWorldTestCommand::Run(*this, TEXT("No local player character holding its throwing weapon to soak"), [this](UWorld& world) -> FLatentWorldTestCommand::FTick
+	{
+		// Three minutes: 18 samples, 16 of them after the warmup, enough for the trend to tell growth from noise
+		const TSharedPtr<FPlayerCharacterSessionSoak> soak = FPlayerCharacterSessionSoak::Start(TEXT("Hours=0.05 SampleSeconds=10 WarmupSamples=2 Report=PlayerSoak-Automation.json"), &world);
+		if (!soak.IsValid())
+		{
+			return nullptr;
+		}
+
+		return [this, soak](float deltaTime)
+		{
+			if (soak->Tick(deltaTime))
+			{
+				return true;
+			}
+
+			TestTrue(FString::Printf(TEXT("Ran throw cycles (%d)"), soak->Cycles), soak->Cycles > 0);
+			TestEqual(TEXT("Throws recalled out of the air"), soak->MissedLodges, 0);
+			TestEqual(TEXT("Returns that never arrived"), soak->ForcedCatches, 0);
+
+			for (const FString& metric : soak->GrowingMetrics)
+			{
+				AddError(FString::Printf(TEXT("%s grew monotonically over the session"), *metric));
+			}
+			return false;
+		};
+	});
+	return true;
+}
+
+#endif
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "PlayerCharacterBase.h"
+#include "Struct/public/LatentWorldTest.h"
+#include "Weapon/public/DefaultThrowingWeapon.h"
+#include "Components/TimelineComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformMemory.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectArray.h"
+
+/// <summary>
+/// Player.Timeline.Soak automation test: runs aim/throw/recall/catch cycles on the local player in one go and checks that
+/// the timelines (tracks included), the UObject count and memory stay flat between a warmup snapshot and the end.
+/// Runs in the test level: -game -nullrhi -ExecCmds="Automation RunTests Player.Timeline.Soak"
+/// </summary>
+struct FPlayerCharacterTimelineSoak
+{
+	struct FSnapshot
+	{
+		int32 NumTimelines = 0; // Timeline components on the player and its weapon
+		int64 TimelineBytes = 0; // Serialized size of those timelines, grows with every track added
+		int32 NumObjects = 0;
+		uint64 UsedPhysical = 0;
+	};
+
+	static FSnapshot TakeSnapshot(const APlayerCharacterBase& character);
+
+	static void RunCycle(APlayerCharacterBase& character); // Aim, throw, recall, catch and stop aiming
+
+	static constexpr int32 NumCycles = 10000;
+	static constexpr int32 NumWarmupCycles = 1000;
+	static constexpr double MemoryToleranceMB = 4;
+
+	static void Run(FAutomationTestBase& test, APlayerCharacterBase& character); // Warm up, run the cycles and check the snapshots
+};
+
+FPlayerCharacterTimelineSoak::FSnapshot FPlayerCharacterTimelineSoak::TakeSnapshot(const APlayerCharacterBase& character)
+{
+	FSnapshot snapshot;
+
+	TArray<UTimelineComponent*> timelines;
+	character.GetComponents(timelines);
+
+	if (const ADefaultThrowingWeapon* weapon = character.GetDefaultThrowingWeapon())
+	{
+		TArray<UTimelineComponent*> weaponTimelines;
+		weapon->GetComponents(weaponTimelines);
+		timelines.Append(weaponTimelines);
+	}
+
+	snapshot.NumTimelines = timelines.Num();
+
+	for (UTimelineComponent* timeline : timelines)
+	{
+		FArchiveCountMem countMem(timeline);
+		snapshot.TimelineBytes += countMem.GetNum();
+	}
+
+	snapshot.NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	snapshot.UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	return snapshot;
+}
+// Aim, throw, recall, catch and stop aiming
+void FPlayerCharacterTimelineSoak::RunCycle(APlayerCharacterBase& character)
+{
+	character.Aim();
+	character.Aim(); // Triggered again while held
+	character.LaunchThrowingWeapon();
+	character.RecallThrowingWeapon();
+	character.CatchThrowingWeapon();
+	character.StopAim();
+}
+// Warm up, run the cycles and check the snapshots
+void FPlayerCharacterTimelineSoak::Run(FAutomationTestBase& test, APlayerCharacterBase& character)
+{
+	// The first cycles allocate what is reused afterwards (trace diagnostics, pools, ...)
+	for (int32 i = 0; i < NumWarmupCycles; i++)
+	{
+		RunCycle(character);
+	}
+
+	const FSnapshot before = TakeSnapshot(character);
+	const double startSeconds = FPlatformTime::Seconds();
+
+	for (int32 i = 0; i < NumCycles; i++)
+	{
+		RunCycle(character);
+	}
+
+	const double elapsedSeconds = FPlatformTime::Seconds() - startSeconds;
+	const FSnapshot after = TakeSnapshot(character);
+
+	const double memoryGrowthMB = (static_cast<double>(after.UsedPhysical) - static_cast<double>(before.UsedPhysical)) / (1024.0 * 1024.0);
+
+	test.TestEqual(TEXT("Timeline components"), after.NumTimelines, before.NumTimelines);
+	test.TestEqual(TEXT("Timeline bytes (grow with every track added)"), after.TimelineBytes, before.TimelineBytes);
+	test.TestTrue(FString::Printf(TEXT("UObjects stay flat (%d before, %d after)"), before.NumObjects, after.NumObjects), after.NumObjects <= before.NumObjects);
+	test.TestTrue(FString::Printf(TEXT("Used physical memory grows by at most %.1f MB (%+.2f MB)"), MemoryToleranceMB, memoryGrowthMB), memoryGrowthMB <= MemoryToleranceMB);
+
+	// Once the aimed camera is reached the timeline stops, holding aim must not start it again
+	character.Aim();
+	character.TLRangedCameraComponent->SetNewTime(character.TLRangedCameraComponent->GetTimelineLength());
+	character.TLRangedCameraComponent->Stop();
+	character.Aim();
+	test.TestFalse(TEXT("Held aim leaves the finished ranged camera timeline alone"), character.TLRangedCameraComponent->IsPlaying());
+	character.StopAim();
+
+	test.AddInfo(FString::Printf(TEXT("%d cycles in %.2f s (%.2f us/cycle), %d timelines (%lld bytes), %d UObjects, memory %+.2f MB"),
+		NumCycles, elapsedSeconds, elapsedSeconds * 1000000 / NumCycles, after.NumTimelines, after.TimelineBytes, after.NumObjects, memoryGrowthMB));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlayerCharacterTimelineSoakTest, "Player.Timeline.Soak", EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+// Wait for the test level's local player character to spawn with its weapon, then soak it
+bool FPlayerCharacterTimelineSoakTest::RunTest(const FString& Parameters)
+{
+	FLatentWorldTestCommand::Run(*this, TEXT("No local player character with a throwing weapon on the server, the soak needs a standalone or listen server game"),
+		[this](UWorld& world) -> FLatentWorldTestCommand::FTick
+	{
+		APlayerController* playerController = world.GetFirstPlayerController();
+		APlayerCharacterBase* character = playerController != nullptr ? Cast<APlayerCharacterBase>(playerController->GetPawn()) : nullptr;
+
+		if (character == nullptr || character->GetDefaultThrowingWeapon() == nullptr || !character->HasAuthority())
+		{
+			return nullptr;
+		}
+
+		TWeakObjectPtr<APlayerCharacterBase> weakCharacter = character;
+		return [this, weakCharacter](float deltaTime)
+		{
+			if (APlayerCharacterBase* soakedCharacter = weakCharacter.Get())
+			{
+				FPlayerCharacterTimelineSoak::Run(*this, *soakedCharacter);
+			}
+			else
+			{
+				AddError(TEXT("The player character was destroyed before the soak started"));
+			}
+			return false;
+		};
+	});
+	return true;
+}
+
+#endif
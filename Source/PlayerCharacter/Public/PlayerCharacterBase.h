@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Struct/public/DoOnce.h"
+#include "Struct/public/BakedCurve.h"
+#include "Struct/public/SocketTransformCache.h"
+#include "Weapon/public/ThrowingWeaponNetState.h"
+#include "Weapon/public/ThrowingWeaponTrajectoryPreview.h"
 #include "InputActionValue.h"
 #include "Runtime/Engine/Classes/Components/TimelineComponent.h"
 #include "PlayerCharacterBase.generated.h"
@@ -15,6 +19,11 @@ class ADefaultThrowingWeapon;
 class UInputAction;
 class UCameraComponent;
 class UCableComponent;
+class UThrowingWeaponTetherComponent;
+class ULineBatchComponent;
+class UThrowTargetComponent;
+struct FStreamableHandle;
+class FPlayerCharacterReplayWriter;
 
 
 UCLASS()
@@ -22,6 +31,11 @@ class PLAYERCHARACTER_API APlayerCharacterBase : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend struct FPlayerCharacterSessionSoak; // Drives the same cycle in real time for hours
+	friend struct FPlayerCharacterTimelineSoak; // Drives aim, throw, recall and catch directly
+	friend class UThrowingWeaponSignificanceSubsystem; // Only aiming characters have anything to tick
+	friend struct FPlayerCharacterReplayPlayback; // Calls the input handlers with recorded input
+
 public:
 	// Sets default values for this character's properties
 	APlayerCharacterBase();
@@ -30,6 +44,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the player is destroyed or the level ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -37,9 +54,17 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	// Replicated properties
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoomComponent; }
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCameraComponent; }
 
+	FORCEINLINE ADefaultThrowingWeapon* GetDefaultThrowingWeapon() const { return DefaultThrowingWeaponReference; }
+
+	// WeaponGripPoint in world space as of the last pose update or mesh move
+	FORCEINLINE const FTransform& GetWeaponGripPointTransform() const { return SocketTransformCache.GetTransform(WeaponGripPointSocketHandle); }
+
 #pragma region COMPONENTS
 
 public:
@@ -64,6 +89,14 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (AllowPrivateAccess = true))
 		UCableComponent* RopeComponent;
 
+	// Native rope used instead of RopeComponent when bUseNativeTether is set, it copies the look of RopeComponent
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (AllowPrivateAccess = true))
+		UThrowingWeaponTetherComponent* TetherComponent;
+
+	// Draws the predicted throw arc while aiming
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (AllowPrivateAccess = true))
+		ULineBatchComponent* ThrowPreviewComponent;
+
 	// Timeline that handles lerping between aim camera and no aim camera
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
 		UTimelineComponent* TLRangedCameraComponent;
@@ -132,6 +165,11 @@ private:
 	UFUNCTION()
 		void TLRangedCameraUpdate(float value); // Update camera position when aiming
 
+	UFUNCTION()
+		void TLRangedCameraPostUpdate(); // Evaluate the baked ranged camera curve at the timeline position
+
+	void RangedCameraCurveLoaded(); // Bake the camera curve once it is in memory and fit the timeline to it
+
 	UFUNCTION()
 		void TLRangedCameraFinished(); // Handles idle aim camera
 
@@ -139,23 +177,58 @@ private:
 		void LerpCameraPosition(float boomLengthIdle, float boomLengthAimed, float alpha); // Lerp between aimed camera and idle aim camera for smooth transition
 
 	UFUNCTION()
-		void UpdateRangedCamera(); // Handle the logic for camera
+		void UpdateRangedCamera(); // Start the timeline towards the aimed camera, only if it isn't already heading there
 
 	UFUNCTION()
 		void CharacterRotation(float DeltaTime); // Handle character rotation properly
 
+	UFUNCTION()
+		void RefreshSocketTransformCache(); // Read the cached sockets from the new pose and move the rope start with it
+
+	void MeshTransformUpdated(USceneComponent* updatedComponent, EUpdateTransformFlags updateTransformFlags, ETeleportType teleport); // The mesh moved, refresh the cached world transforms
+
 	UFUNCTION()
 		void Aim(); // Aiming function for all the weapons
 
 	UFUNCTION()
 		void StopAim(); // Stop the aiming for all the weapons
 
+	void RefreshSignificance(); // Score the tick rate again after aiming started or stopped
+
 	UFUNCTION()
 		void LaunchThrowingWeapon(); // Throw the throwing weapon 
 
 	UFUNCTION()
 		void RecallThrowingWeapon(); // Make the throwing weapon go back to the player
 
+	UFUNCTION(Server, Reliable)
+		void ServerLaunchThrowingWeapon(const FThrowingWeaponNetState& launch); // Throw on the server with the launch the client predicted
+
+	UFUNCTION(Server, Reliable)
+		void ServerRecallThrowingWeapon(uint8 sequence); // Recall on the server after the client predicted it, sequence is the throw the client recalled
+
+	UFUNCTION()
+		void OnRep_ThrowingWeaponNetState(); // Follow the server's throwing weapon state, correcting the prediction
+
+	UFUNCTION()
+		void PerformThrow(const FThrowingWeaponNetState& launch); // Detach and throw the weapon with a launch
+
+	bool IsLaunchPlausible(const FThrowingWeaponNetState& launch) const; // Does a client's launch start at the server's grip point and point where the server's control rotation does?
+
+	void ThrowingWeaponStateChanged(AThrowingWeaponBase* throwingWeapon, ThrowingWeaponState newState); // Wake or sleep the rope, on the server put the new state in ThrowingWeaponNetState
+
+	void UpdateThrowPreview(); // Step the predicted throw arc while aiming and redraw it when it changed
+
+	void ClearThrowPreview(); // Hide the predicted throw arc
+
+	void UpdateAimAssistTarget(); // Pick the throw target in the aim cone from the target grid
+
+	FVector GetAimedThrowDirection() const; // Camera forward, pulled towards the throw that hits the aim assist target when there is one
+
+	void SetRopeVisibility(bool bVisible); // Show or hide the cable rope, the native tether shows itself while the weapon isn't Idle
+
+	void UpdateReplayRecording(float deltaTime); // Start or stop recording with Player.Replay.Record and end the recorded frame
+
 #pragma endregion
 
 #pragma region VARIABLES
@@ -176,7 +249,7 @@ private:
 
 	// The curve that handles lerping between aimed camera and idle camera
 	UPROPERTY(EditDefaultsOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UCurveFloat* TLRangedCamera_Curve;		
+		TSoftObjectPtr<UCurveFloat> TLRangedCamera_Curve;		
 
 	UPROPERTY()
 		FVector CameraVector;
@@ -211,15 +284,63 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement", meta = (AllowPrivateAccess = true))
 		float MaxWalkSpeedIdle;
 
+	// Simulate the rope with TetherComponent instead of RopeComponent
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (AllowPrivateAccess = true))
+		bool bUseNativeTether;
+
+	// Show the predicted throw arc and lodge point while aiming
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Preview", meta = (AllowPrivateAccess = true))
+		bool bShowThrowPreview;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Preview", meta = (AllowPrivateAccess = true))
+		FLinearColor ThrowPreviewColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Preview", meta = (AllowPrivateAccess = true))
+		float ThrowPreviewThickness;
+
+	// Lock throws on to the best UThrowTargetComponent inside the aim cone while aiming
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Aim Assist", meta = (AllowPrivateAccess = true))
+		bool bUseAimAssist;
+
+	// Half angle of the aim cone around the camera forward (degrees)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Aim Assist", meta = (AllowPrivateAccess = true, ClampMin = "0.0", ClampMax = "45.0"))
+		float AimAssistConeAngle;
+
+	// Targets further from the camera are ignored
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Aim Assist", meta = (AllowPrivateAccess = true))
+		float AimAssistMaxDistance;
+
+	// How far the throw turns from the camera forward to the target (0 none, 1 straight at it)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Aim Assist", meta = (AllowPrivateAccess = true, ClampMin = "0.0", ClampMax = "1.0"))
+		float AimAssistStrength;
+
 	// Throwing weapon velocity when thrown
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (AllowPrivateAccess = true))
 		float WeaponThrowSpeed;	
 
+	// How far a client's throw may start from the server's grip point before the server throws from its own
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Network", meta = (AllowPrivateAccess = true, ClampMin = "0.0"))
+		float LaunchLocationTolerance;
+
+	// How far a client's throw direction may turn from the server's control rotation before the server throws its own (degrees, leaves room for aim assist)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Network", meta = (AllowPrivateAccess = true, ClampMin = "0.0", ClampMax = "180.0"))
+		float LaunchDirectionTolerance;
+
 	UPROPERTY()
 		bool bIsAiming;	// Is player aiming?
 
+	UPROPERTY()
+		bool bIsRangedCameraAimed; // Has the ranged camera timeline been started towards the aimed camera since the last StopAim?
+
 	UPROPERTY()
 		bool bIsThrowingWeaponLaunched; // Is the throwing weapon launched?
+
+	// Server state of the throwing weapon, replicated to every client
+	UPROPERTY(ReplicatedUsing = OnRep_ThrowingWeaponNetState)
+		FThrowingWeaponNetState ThrowingWeaponNetState;
+
+	UPROPERTY()
+		int32 AppliedThrowSequence; // Sequence of the last throw started here (predicted or replicated), INDEX_NONE before the first
 	
 #pragma endregion
 
@@ -231,8 +352,25 @@ protected:
 
 private:
 
-	FOnTimelineFloat RangedCameraInterpFunction{}; // Delegate to track time for update ranged camera
 	FOnTimelineEvent RangedCameraTimelineFinished; // Delegate to track time for ranged camera finished
+	FOnTimelineEvent RangedCameraTimelinePostUpdate; // Delegate called every time the ranged camera timeline moves
+
+	TSharedPtr<const FBakedCurve> RangedCameraCurveTable; // Baked TLRangedCamera_Curve
+
+	TSharedPtr<FStreamableHandle> RangedCameraCurveHandle; // Pending background load of TLRangedCamera_Curve
+
+	FSocketTransformCache SocketTransformCache; // Mesh sockets read every frame by the throwing weapon and rope
+	int32 WeaponGripPointSocketHandle; // WeaponGripPoint in SocketTransformCache
+	int32 RopeSocketHandle; // RopeSocket in SocketTransformCache
+	FTransform RopeRelativeTransform; // Rope offset from RopeSocket
+
+	FThrowingWeaponTrajectoryPreview ThrowPreview; // Predicted throw arc while aiming
+	bool bIsThrowPreviewDrawn; // Does ThrowPreviewComponent show an arc?
+
+	TWeakObjectPtr<UThrowTargetComponent> AimAssistTarget; // Best target in the aim cone this frame
+
+	TSharedPtr<FPlayerCharacterReplayWriter> ReplayWriter; // Recording of this session while Player.Replay.Record is on
+	bool bIsReplayPlaying; // Input comes from Player.Replay.Play, nothing is recorded
 
 #pragma endregion
 
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Weapon/public/ThrowingWeaponBase.h"
+
+class FArchive;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/// <summary>
+/// What a replay frame can contain. Inputs are played back, weapon states are only compared against
+/// </summary>
+enum class EPlayerReplayEvent : uint8
+{
+	Move, // PlayerMovementAction, 2D axis
+	Look, // PlayerLookAction, 2D axis
+	Aim, // PlayerAimAction triggered
+	StopAim, // PlayerAimAction completed
+	LaunchThrowingWeapon, // LaunchThrowingWeaponAction triggered
+	RecallThrowingWeapon, // ThrowingWeaponRecallAction triggered
+	WeaponState, // The player's throwing weapon changed state
+
+	Num
+};
+
+/// <summary>
+/// One recorded event, Axis is only used by Move and Look, State only by WeaponState
+/// </summary>
+struct FPlayerReplayEvent
+{
+	EPlayerReplayEvent Type = EPlayerReplayEvent::Num;
+	FVector2D Axis = FVector2D::ZeroVector;
+	ThrowingWeaponState State = ThrowingWeaponState::Idle;
+};
+
+/// <summary>
+/// Where the recording started, restored before playback so the same inputs lead to the same session
+/// </summary>
+struct FPlayerReplayHeader
+{
+	FString MapName;
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FRotator ControlRotation = FRotator::ZeroRotator;
+};
+
+/// <summary>
+/// Shared format of the replay stream. After the header every engine frame is one record:
+/// zigzag varint delta of the frame time in microseconds to the previous frame, varint event count, then per event its type
+/// byte and payload. Move and Look store the zigzag varint delta of each quantized axis to the previous value of the same
+/// action, so a held stick or a still mouse costs a byte per axis and an idle frame costs two bytes
+/// </summary>
+struct PLAYERCHARACTER_API FPlayerReplayFormat
+{
+	static constexpr uint32 Magic = 0x4C505250; // "PRPL"
+	static constexpr uint16 Version = 1;
+	static constexpr float AxisScale = 4096; // Axis values are stored in 1/4096 steps
+
+	static void WriteVarUInt(TArray<uint8>& buffer, uint64 value); // 7 bits per byte, high bit set while more bytes follow
+
+	static void WriteVarInt(TArray<uint8>& buffer, int64 value); // Zigzag, so small negative deltas stay small
+
+	static bool ReadVarUInt(const uint8*& cursor, const uint8* end, uint64& outValue); // False if the stream ends inside the value
+
+	static bool ReadVarInt(const uint8*& cursor, const uint8* end, int64& outValue);
+
+	static int32 QuantizeAxis(float value) { return FMath::RoundToInt(value * AxisScale); }
+};
+
+/// <summary>
+/// Encodes the local player's session into a replay file. Events are collected during the frame and written as one record
+/// when the frame ends, the encoded stream is appended to the file in FlushBytes chunks so a recording costs one small
+/// write every few seconds and a crash loses at most the last chunk
+/// </summary>
+class PLAYERCHARACTER_API FPlayerCharacterReplayWriter
+{
+public:
+
+	~FPlayerCharacterReplayWriter();
+
+	bool Open(const FString& path, const FPlayerReplayHeader& header); // Create the file and write the header
+
+	void Close(); // Write the last frame and chunk
+
+	void RecordAxis(EPlayerReplayEvent type, const FVector2D& axis); // Move or Look
+
+	void RecordEvent(EPlayerReplayEvent type); // Aim, StopAim, LaunchThrowingWeapon or RecallThrowingWeapon
+
+	void RecordWeaponState(ThrowingWeaponState state);
+
+	void EndFrame(float deltaTime); // Encode this frame's events
+
+	bool IsOpen() const { return FileWriter.IsValid(); }
+
+	int64 GetNumFrames() const { return NumFrames; }
+
+	int64 GetNumBytes() const { return NumBytesFlushed + Buffer.Num(); }
+
+	const FString& GetPath() const { return Path; }
+
+private:
+
+	void Flush(); // Append the encoded chunk to the file
+
+	static constexpr int32 FlushBytes = 64 * 1024;
+
+	TUniquePtr<FArchive> FileWriter;
+	FString Path;
+
+	TArray<uint8> Buffer; // Encoded, not yet written
+	TArray<FPlayerReplayEvent> FrameEvents; // Recorded since the last EndFrame
+
+	int64 PreviousFrameMicroseconds = 0;
+	FIntPoint PreviousAxis[2] = { FIntPoint::ZeroValue, FIntPoint::ZeroValue }; // Last quantized Move and Look
+	int64 NumFrames = 0;
+	int64 NumBytesFlushed = 0;
+};
+
+/// <summary>
+/// Decodes a replay file frame by frame. The file is memory mapped where the platform supports it, so a long session is
+/// played back without loading it, and read into memory otherwise
+/// </summary>
+class PLAYERCHARACTER_API FPlayerCharacterReplayReader
+{
+public:
+
+	~FPlayerCharacterReplayReader();
+
+	bool Open(const FString& path); // Map the file and read the header
+
+	bool ReadFrame(float& outDeltaTime, TArray<FPlayerReplayEvent>& outEvents); // Next frame, false at the end of the stream (or where a crashed recording was cut off)
+
+	const FPlayerReplayHeader& GetHeader() const { return Header; }
+
+	bool IsMemoryMapped() const { return MappedRegion.IsValid(); }
+
+	int64 GetNumBytes() const { return End - Begin; }
+
+private:
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedFile; // Used when the file couldn't be mapped
+
+	const uint8* Begin = nullptr;
+	const uint8* Cursor = nullptr;
+	const uint8* End = nullptr;
+
+	FPlayerReplayHeader Header;
+
+	int64 PreviousFrameMicroseconds = 0;
+	FIntPoint PreviousAxis[2] = { FIntPoint::ZeroValue, FIntPoint::ZeroValue };
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/// <summary>
+/// Stats of the PlayerCharacter module, shown with "stat PlayerCharacter". The same scopes go to Unreal Insights on the
+/// PlayerCharacter trace channel ("Trace.Enable PlayerCharacter"). Both compile out in Shipping
+/// </summary>
+DECLARE_STATS_GROUP(TEXT("PlayerCharacter"), STATGROUP_PlayerCharacter, STATCAT_Advanced);
+
+#define WITH_PLAYER_CHARACTER_PROFILING !UE_BUILD_SHIPPING
+
+#if WITH_PLAYER_CHARACTER_PROFILING
+
+UE_TRACE_CHANNEL_EXTERN(PlayerCharacterChannel, PLAYERCHARACTER_API);
+
+// Cycle stat and Insights CPU scope under the stat's name
+#define PLAYER_CHARACTER_PROFILE_SCOPE(Stat) SCOPE_CYCLE_COUNTER(Stat); TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, PlayerCharacterChannel)
+
+#else
+
+#define PLAYER_CHARACTER_PROFILE_SCOPE(Stat)
+
+#endif
+
+// Camera
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ranged camera timeline"), STAT_PlayerRangedCamera, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character rotation"), STAT_PlayerRotation, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+
+// Throwing weapon
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Attach weapon"), STAT_PlayerAttachWeapon, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Detach weapon"), STAT_PlayerDetachWeapon, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon state changed"), STAT_PlayerWeaponStateChanged, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon net state"), STAT_PlayerWeaponNetState, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw preview"), STAT_PlayerThrowPreview, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+
+// Rope
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Rope update"), STAT_PlayerRopeUpdate, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rope updates"), STAT_PlayerRopeUpdates, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
+
+// Aim assist
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Aim assist"), STAT_PlayerAimAssist, STATGROUP_PlayerCharacter, PLAYERCHARACTER_API);
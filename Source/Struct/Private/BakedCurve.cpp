@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakedCurve.h"
+#include "Curves/CurveFloat.h"
+#include "Curves/RichCurve.h"
+
+TMap<TWeakObjectPtr<const UCurveFloat>, TSharedRef<const FBakedCurve>> FBakedCurve::BakedCurves;
+
+FBakedCurve::FBakedCurve() : FBakedCurve(0)
+{}
+
+FBakedCurve::FBakedCurve(float constantValue)
+	: StartTime(0)
+	, EndTime(0)
+	, SamplesPerSecond(0)
+	, MaxBakeError(0)
+{
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		Samples[i] = constantValue;
+	}
+}
+// Sample the source curve and measure the error of the table against it
+void FBakedCurve::Bake(const FRichCurve& sourceCurve)
+{
+	sourceCurve.GetTimeRange(StartTime, EndTime);
+
+	const float duration = EndTime - StartTime;
+	SamplesPerSecond = duration > KINDA_SMALL_NUMBER ? (NumSamples - 1) / duration : 0;
+
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		Samples[i] = sourceCurve.Eval(StartTime + duration * i / (NumSamples - 1));
+	}
+
+	// The error is largest between samples, so check a few points inside every interval
+	const int32 checksPerSample = 4;
+	MaxBakeError = 0;
+
+	for (int32 i = 0; i < (NumSamples - 1) * checksPerSample; i++)
+	{
+		const float time = StartTime + duration * (i + 0.5f) / ((NumSamples - 1) * checksPerSample);
+		MaxBakeError = FMath::Max(MaxBakeError, FMath::Abs(sourceCurve.Eval(time) - Evaluate(time)));
+	}
+}
+// Evaluate many times at once, four per vector instruction
+void FBakedCurve::EvaluateBatch(const float* times, float* outValues, int32 count) const
+{
+	const VectorRegister4Float startTime = VectorSetFloat1(StartTime);
+	const VectorRegister4Float samplesPerSecond = VectorSetFloat1(SamplesPerSecond);
+	const VectorRegister4Float lastPosition = VectorSetFloat1(static_cast<float>(NumSamples - 1));
+
+	int32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const VectorRegister4Float position = VectorMin(VectorMax(VectorMultiply(VectorSubtract(VectorLoad(times + i), startTime), samplesPerSecond), GlobalVectorConstants::FloatZero), lastPosition);
+		const VectorRegister4Float sampleIndex = VectorTruncate(position);
+
+		float indices[4];
+		VectorStore(sampleIndex, indices);
+
+		int32 index[4];
+		for (int32 lane = 0; lane < 4; lane++)
+		{
+			index[lane] = FMath::Min(static_cast<int32>(indices[lane]), NumSamples - 2);
+		}
+
+		const VectorRegister4Float from = MakeVectorRegister(Samples[index[0]], Samples[index[1]], Samples[index[2]], Samples[index[3]]);
+		const VectorRegister4Float to = MakeVectorRegister(Samples[index[0] + 1], Samples[index[1] + 1], Samples[index[2] + 1], Samples[index[3] + 1]);
+		const VectorRegister4Float alpha = VectorSubtract(position, MakeVectorRegister(static_cast<float>(index[0]), static_cast<float>(index[1]), static_cast<float>(index[2]), static_cast<float>(index[3])));
+
+		VectorStore(VectorMultiplyAdd(VectorSubtract(to, from), alpha, from), outValues + i);
+	}
+
+	for (; i < count; i++)
+	{
+		outValues[i] = Evaluate(times[i]);
+	}
+}
+// Shared table for a curve asset, constant defaultValue without one
+TSharedRef<const FBakedCurve> FBakedCurve::FindOrBake(const UCurveFloat* curve, float defaultValue)
+{
+	if (curve == nullptr)
+	{
+		return MakeShared<FBakedCurve>(defaultValue);
+	}
+
+	if (const TSharedRef<const FBakedCurve>* bakedCurve = BakedCurves.Find(TWeakObjectPtr<const UCurveFloat>(curve)))
+	{
+		return *bakedCurve;
+	}
+
+	TSharedRef<FBakedCurve> newBakedCurve = MakeShared<FBakedCurve>();
+	newBakedCurve->Bake(curve->FloatCurve);
+
+	float minValue = 0;
+	float maxValue = 0;
+	curve->FloatCurve.GetValueRange(minValue, maxValue);
+
+	// One percent of the value range is where the table starts to visibly differ
+	if (newBakedCurve->GetMaxBakeError() > FMath::Max(maxValue - minValue, 1.f) * 0.01f)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Baked curve %s differs from its source by up to %f, it may need more samples"), *curve->GetName(), newBakedCurve->GetMaxBakeError());
+	}
+
+	// Forget tables of curves that have been unloaded
+	for (auto it = BakedCurves.CreateIterator(); it; ++it)
+	{
+		if (!it->Key.IsValid())
+		{
+			it.RemoveCurrent();
+		}
+	}
+
+	BakedCurves.Add(TWeakObjectPtr<const UCurveFloat>(curve), newBakedCurve);
+	return newBakedCurve;
+}
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LatentWorldTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "Tests/AutomationCommon.h"
+
+// Start the test once the game world is ready for it, then step it every frame until it is finished
+bool FLatentWorldTestCommand::Update()
+{
+	if (!Tick)
+	{
+		if (UWorld* world = AutomationCommon::GetAnyGameWorld())
+		{
+			Tick = Start(*world);
+		}
+
+		if (!Tick && GetCurrentRunTime() > StartTimeout)
+		{
+			Test->AddError(NotReadyError);
+			return true;
+		}
+
+		// The first step runs next frame, so it measures a whole frame of the started test
+		return false;
+	}
+
+	return !Tick(static_cast<float>(FApp::GetDeltaTime()));
+}
+// Open the test level and run the test in it. Headless: -game -nullrhi -ExecCmds="Automation RunTests <test>"
+void FLatentWorldTestCommand::Run(FAutomationTestBase& test, const FString& notReadyError, FStart start)
+{
+	AutomationOpenMap(TestLevel);
+	ADD_LATENT_AUTOMATION_COMMAND(FLatentWorldTestCommand(&test, notReadyError, MoveTemp(start)));
+}
+
+#endif
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SocketTransformCache.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMeshSocket.h"
+
+// Handle for GetTransform, the socket is resolved by the next Resolve
+int32 FSocketTransformCache::AddSocket(FName socketName)
+{
+	FCachedSocket socket;
+	socket.SocketName = socketName;
+	return Sockets.Add(socket);
+}
+// Find the bone and bone relative transform of every socket, the only name lookups the cache does
+void FSocketTransformCache::Resolve(const USkeletalMeshComponent* mesh)
+{
+	for (FCachedSocket& socket : Sockets)
+	{
+		socket.BoneIndex = INDEX_NONE;
+		socket.BoneRelativeTransform = FTransform::Identity;
+
+		if (mesh == nullptr)
+		{
+			continue;
+		}
+
+		// Same fallback as GetSocketTransform: a socket, then a bone with that name
+		if (const USkeletalMeshSocket* meshSocket = mesh->GetSocketByName(socket.SocketName))
+		{
+			socket.BoneIndex = mesh->GetBoneIndex(meshSocket->BoneName);
+			socket.BoneRelativeTransform = meshSocket->GetSocketLocalTransform();
+		}
+		else
+		{
+			socket.BoneIndex = mesh->GetBoneIndex(socket.SocketName);
+		}
+	}
+
+	RefreshPose(mesh);
+}
+// Read the sockets from the new pose
+void FSocketTransformCache::RefreshPose(const USkeletalMeshComponent* mesh)
+{
+	if (mesh == nullptr)
+	{
+		return;
+	}
+
+	const TArray<FTransform>& componentSpaceTransforms = mesh->GetComponentSpaceTransforms();
+
+	for (FCachedSocket& socket : Sockets)
+	{
+		socket.ComponentSpaceTransform = componentSpaceTransforms.IsValidIndex(socket.BoneIndex)
+			? socket.BoneRelativeTransform * componentSpaceTransforms[socket.BoneIndex]
+			: FTransform::Identity;
+	}
+
+	RefreshWorld(mesh);
+}
+// The mesh moved without a new pose, only the world transforms change
+void FSocketTransformCache::RefreshWorld(const USkeletalMeshComponent* mesh)
+{
+	if (mesh == nullptr)
+	{
+		return;
+	}
+
+	const FTransform& componentTransform = mesh->GetComponentTransform();
+
+	for (FCachedSocket& socket : Sockets)
+	{
+		socket.WorldTransform = socket.ComponentSpaceTransform * componentTransform;
+	}
+}
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakedCurve.h"
+#include "Curves/CurveFloat.h"
+#include "Curves/RichCurve.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BakedCurveTest
+{
+	// Smooth curves stay within h^2 / 8 * max|f''| of the source (h the sample spacing), which is 2e-4 for the cubic below
+	constexpr float SmoothTolerance = 1e-3f;
+
+	// Off-grid times checked per curve, odd so EvaluateBatch also runs its scalar tail
+	constexpr int32 NumChecks = 1001;
+
+	// A transient curve asset with the given keys
+	UCurveFloat* MakeCurve(const TArray<FRichCurveKey>& keys)
+	{
+		UCurveFloat* curve = NewObject<UCurveFloat>(GetTransientPackage());
+		curve->FloatCurve.SetKeys(keys);
+		return curve;
+	}
+
+	// A key that keeps the tangents it is given
+	FRichCurveKey MakeKey(float time, float value, ERichCurveInterpMode interpMode, float arriveTangent = 0, float leaveTangent = 0)
+	{
+		FRichCurveKey key(time, value, arriveTangent, leaveTangent, interpMode);
+		key.TangentMode = RCTM_User;
+		return key;
+	}
+
+	// Times spread over the key range and half a second past both ends, none of them on a sample
+	void MakeTimes(const FBakedCurve& bakedCurve, TArray<float>& outTimes)
+	{
+		const float startTime = bakedCurve.GetStartTime() - 0.5f;
+		const float duration = bakedCurve.GetEndTime() - bakedCurve.GetStartTime() + 1;
+
+		outTimes.SetNumUninitialized(NumChecks);
+		for (int32 i = 0; i < NumChecks; i++)
+		{
+			outTimes[i] = startTime + duration * (i + 0.37f) / NumChecks;
+		}
+	}
+
+	// Largest difference of Evaluate and EvaluateBatch to the source curve at the given times, skipping the times inside [skipFrom, skipTo]
+	float GetMaxError(const FBakedCurve& bakedCurve, const UCurveFloat* curve, TConstArrayView<float> times, float skipFrom = 1, float skipTo = 0)
+	{
+		TArray<float> batchValues;
+		batchValues.SetNumUninitialized(times.Num());
+		bakedCurve.EvaluateBatch(times.GetData(), batchValues.GetData(), times.Num());
+
+		float maxError = 0;
+		for (int32 i = 0; i < times.Num(); i++)
+		{
+			if (times[i] >= skipFrom && times[i] <= skipTo)
+			{
+				continue;
+			}
+
+			const float sourceValue = curve->GetFloatValue(times[i]);
+			maxError = FMath::Max(maxError, FMath::Abs(bakedCurve.Evaluate(times[i]) - sourceValue));
+			maxError = FMath::Max(maxError, FMath::Abs(batchValues[i] - sourceValue));
+		}
+		return maxError;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBakedCurveSmoothTest, "Struct.BakedCurve.Smooth", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Constant, linear and cubic curves match their source everywhere, batched or not
+bool FBakedCurveSmoothTest::RunTest(const FString& Parameters)
+{
+	using namespace BakedCurveTest;
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		UCurveFloat* Curve;
+	};
+
+	const FCase cases[] =
+	{
+		{ TEXT("Constant"), MakeCurve({ MakeKey(0.3f, 5, RCIM_Constant) }) },
+		{ TEXT("Linear"), MakeCurve({ MakeKey(0, -2, RCIM_Linear), MakeKey(2, 10, RCIM_Linear) }) },
+		{ TEXT("Cubic"), MakeCurve({ MakeKey(0, 0, RCIM_Cubic, 0, 0), MakeKey(1, 1, RCIM_Cubic, 3, 3) }) }, // Hermite form of t^3
+	};
+
+	TArray<float> times;
+	for (const FCase& testCase : cases)
+	{
+		const TSharedRef<const FBakedCurve> bakedCurve = FBakedCurve::FindOrBake(testCase.Curve, 0);
+		MakeTimes(*bakedCurve, times);
+
+		const float maxError = GetMaxError(*bakedCurve, testCase.Curve, times);
+		TestTrue(FString::Printf(TEXT("%s curve is within %g of its source (off by %g)"), testCase.Name, SmoothTolerance, maxError), maxError <= SmoothTolerance);
+		TestTrue(FString::Printf(TEXT("%s curve reports a bake error within %g"), testCase.Name, SmoothTolerance), bakedCurve->GetMaxBakeError() <= SmoothTolerance);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBakedCurveSteepStepTest, "Struct.BakedCurve.SteepStep", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// A step narrower than the sample spacing is reported, and the table stays exact away from it
+bool FBakedCurveSteepStepTest::RunTest(const FString& Parameters)
+{
+	using namespace BakedCurveTest;
+
+	const float stepFrom = 0.5f;
+	const float stepTo = 0.51f;
+	UCurveFloat* curve = MakeCurve({ MakeKey(0, 0, RCIM_Linear), MakeKey(stepFrom, 0, RCIM_Linear), MakeKey(stepTo, 1, RCIM_Linear), MakeKey(1, 1, RCIM_Linear) });
+
+	AddExpectedError(TEXT("differs from its source"), EAutomationExpectedErrorFlags::Contains, 1);
+	const TSharedRef<const FBakedCurve> bakedCurve = FBakedCurve::FindOrBake(curve, 0);
+
+	TestTrue(TEXT("Bake error of the step is above one percent of its range"), bakedCurve->GetMaxBakeError() > 0.01f);
+
+	// Only the two sample intervals around the step can be off
+	const float sampleSpacing = (bakedCurve->GetEndTime() - bakedCurve->GetStartTime()) / (FBakedCurve::NumSamples - 1);
+
+	TArray<float> times;
+	MakeTimes(*bakedCurve, times);
+
+	const float maxError = GetMaxError(*bakedCurve, curve, times, stepFrom - sampleSpacing, stepTo + sampleSpacing);
+	TestTrue(FString::Printf(TEXT("Step curve is within %g of its source away from the step (off by %g)"), SmoothTolerance, maxError), maxError <= SmoothTolerance);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class UCurveFloat;
+struct FRichCurve;
+
+/// <summary>
+/// A float curve sampled at a fixed resolution between its first and last key.
+/// Evaluation is a clamped lerp between two samples, without key search or branches.
+/// Outside of the key range the end values are held (constant extrapolation)
+/// </summary>
+struct STRUCT_API FBakedCurve
+{
+public:
+
+	// Samples between the first and last key (both included)
+	static constexpr int32 NumSamples = 64;
+
+	FBakedCurve();
+	explicit FBakedCurve(float constantValue); // A curve that always returns constantValue
+
+	void Bake(const FRichCurve& sourceCurve); // Sample the source curve and measure the error of the table against it
+
+	FORCEINLINE float Evaluate(float time) const
+	{
+		const float position = FMath::Clamp((time - StartTime) * SamplesPerSecond, 0.f, static_cast<float>(NumSamples - 1));
+		const int32 index = FMath::Min(static_cast<int32>(position), NumSamples - 2);
+		const float alpha = position - index;
+
+		return Samples[index] + (Samples[index + 1] - Samples[index]) * alpha;
+	}
+
+	void EvaluateBatch(const float* times, float* outValues, int32 count) const; // Evaluate many times at once, four per vector instruction
+
+	float GetStartTime() const { return StartTime; }
+	float GetEndTime() const { return EndTime; }
+	float GetMaxBakeError() const { return MaxBakeError; } // Largest difference to the source curve found while baking
+
+	static TSharedRef<const FBakedCurve> FindOrBake(const UCurveFloat* curve, float defaultValue); // Shared table for a curve asset, constant defaultValue without one
+
+private:
+
+	TStaticArray<float, NumSamples> Samples; // Uniformly spaced values from StartTime to EndTime
+
+	float StartTime; // Time of the first key
+	float EndTime; // Time of the last key
+	float SamplesPerSecond; // (NumSamples - 1) / (EndTime - StartTime), 0 for a constant curve
+	float MaxBakeError; // Largest difference to the source curve found while baking
+
+	static TMap<TWeakObjectPtr<const UCurveFloat>, TSharedRef<const FBakedCurve>> BakedCurves; // Tables shared by every user of a curve asset
+};
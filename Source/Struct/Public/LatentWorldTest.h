@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+class UWorld;
+
+/// <summary>
+/// Latent command of the automation tests that run in a game world over many frames (soaks, stress tests and benchmarks).
+/// Run opens the test level, the command starts the test once the level's game world is ready for it and steps it once
+/// per frame until it finished and checked its results
+/// </summary>
+class STRUCT_API FLatentWorldTestCommand : public IAutomationLatentCommand
+{
+public:
+
+	using FTick = TFunction<bool(float)>; // Step the running test with the frame time, false once it finished and checked its results
+	using FStart = TFunction<FTick(UWorld&)>; // Start the test in the game world, an empty FTick while the world isn't ready for it yet
+
+	static constexpr const TCHAR* TestLevel = TEXT("/Game/TestLevel");
+	static constexpr double StartTimeout = 10; // Seconds the world gets to be ready for the test before it fails
+
+	FLatentWorldTestCommand(FAutomationTestBase* test, const FString& notReadyError, FStart start)
+		: Test(test)
+		, NotReadyError(notReadyError)
+		, Start(MoveTemp(start))
+	{}
+
+	virtual bool Update() override;
+
+	static void Run(FAutomationTestBase& test, const FString& notReadyError, FStart start); // Open the test level and run the test in it
+
+private:
+
+	FAutomationTestBase* Test;
+	FString NotReadyError; // Reported when the world still isn't ready after StartTimeout
+	FStart Start;
+	FTick Tick; // Set once the test started
+};
+
+#endif
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USkeletalMeshComponent;
+
+/// <summary>
+/// World transforms of a few skeletal mesh sockets, refreshed once per pose update instead of looked up by name on every read.
+/// Sockets are added once and read back through the handle AddSocket returns
+/// </summary>
+struct STRUCT_API FSocketTransformCache
+{
+public:
+
+	int32 AddSocket(FName socketName); // Handle for GetTransform, the socket is resolved by the next Resolve
+
+	void Resolve(const USkeletalMeshComponent* mesh); // Find the bone and bone relative transform of every socket (BeginPlay or after the mesh changes)
+
+	void RefreshPose(const USkeletalMeshComponent* mesh); // Read the sockets from the new pose, call once the bone transforms are final
+
+	void RefreshWorld(const USkeletalMeshComponent* mesh); // The mesh moved without a new pose, only the world transforms change
+
+	FORCEINLINE const FTransform& GetTransform(int32 handle) const { return Sockets[handle].WorldTransform; }
+	FORCEINLINE const FTransform& GetComponentSpaceTransform(int32 handle) const { return Sockets[handle].ComponentSpaceTransform; }
+
+private:
+
+	struct FCachedSocket
+	{
+		FName SocketName;
+		int32 BoneIndex = INDEX_NONE; // INDEX_NONE when the mesh has no such socket or bone (the component transform is used)
+		FTransform BoneRelativeTransform = FTransform::Identity; // Socket offset from its bone
+		FTransform ComponentSpaceTransform = FTransform::Identity; // Socket in mesh component space as of the last pose
+		FTransform WorldTransform = FTransform::Identity; // Socket in world space as of the last pose or mesh move
+	};
+
+	TArray<FCachedSocket, TInlineAllocator<4>> Sockets;
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowTargetGridBenchmark.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowTargetGridMatchesFullScanTest, "Weapon.Targets.Grid.MatchesFullScan", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Cone queries on moving targets find exactly what testing every target finds
+bool FThrowTargetGridMatchesFullScanTest::RunTest(const FString& Parameters)
+{
+	const FThrowTargetGridBenchmark::FResult result = FThrowTargetGridBenchmark::Measure(5000, 500);
+
+	TestEqual(TEXT("Queries where the grid and the full scan disagree"), result.NumMismatches, 0);
+	TestTrue(TEXT("Targets spread over more than one cell"), result.NumCells > 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowTargetGridFasterThanFullScanTest, "Weapon.Targets.Grid.FasterThanFullScan", EAutomationTestFlags::PerfFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Cone queries on the grid beat testing every one of 5000 targets
+bool FThrowTargetGridFasterThanFullScanTest::RunTest(const FString& Parameters)
+{
+	const int32 numQueries = 1000;
+	const FThrowTargetGridBenchmark::FResult result = FThrowTargetGridBenchmark::Measure(5000, numQueries);
+
+	TestTrue(FString::Printf(TEXT("Grid query (%.2f us) is faster than the full scan (%.2f us)"), result.GridSeconds * 1000000 / numQueries, result.BruteForceSeconds * 1000000 / numQueries),
+		result.GridSeconds < result.BruteForceSeconds);
+	return true;
+}
+
+#endif
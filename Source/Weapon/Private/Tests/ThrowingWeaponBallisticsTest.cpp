@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponBallisticsChecks.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponBallisticsKnownAnswersTest, "Weapon.Ballistics.KnownAnswers", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Flat, out of reach, gravity free, straight up and leading throws against their closed form answers and a simulated flight
+bool FThrowingWeaponBallisticsKnownAnswersTest::RunTest(const FString& Parameters)
+{
+	const float speed = 2500;
+	const float gravityZ = -980;
+
+	// Flat throw: sin(2 * pitch) = g * x / s^2, the high arc is the complement of the low one
+	{
+		const FThrowingWeaponBallisticQuery flat{ FVector::ZeroVector, FVector(1000, 0, 0) };
+		FThrowingWeaponBallisticSolution low;
+		FThrowingWeaponBallisticSolution high;
+
+		TestTrue(TEXT("Flat low arc solved"), FThrowingWeaponBallistics::Solve(flat.Start, flat.Target, speed, gravityZ, EThrowingWeaponArc::Low, low));
+		TestTrue(TEXT("Flat high arc solved"), FThrowingWeaponBallistics::Solve(flat.Start, flat.Target, speed, gravityZ, EThrowingWeaponArc::High, high));
+
+		const double lowPitch = FMath::RadiansToDegrees(0.5 * FMath::Asin(-gravityZ * 1000.0 / (speed * speed)));
+		TestNearlyEqual(TEXT("Flat low arc pitch"), low.Direction.Rotation().Pitch, lowPitch, 0.01);
+		TestNearlyEqual(TEXT("Flat high arc pitch"), high.Direction.Rotation().Pitch, 90 - lowPitch, 0.01);
+		TestNearlyEqual(TEXT("Flat low arc miss"), FThrowingWeaponBallisticsChecks::GetMiss(flat, speed, gravityZ, low), 0.0, 0.01);
+		TestNearlyEqual(TEXT("Flat high arc miss"), FThrowingWeaponBallisticsChecks::GetMiss(flat, speed, gravityZ, high), 0.0, 0.01);
+		TestTrue(TEXT("Low arc lands first"), low.Time < high.Time);
+	}
+
+	// Beyond the widest throw s^2 / g
+	{
+		FThrowingWeaponBallisticSolution solution;
+		TestFalse(TEXT("Out of reach solved"), FThrowingWeaponBallistics::Solve(FVector::ZeroVector, FVector(speed * speed / -gravityZ + 100, 0, 0), speed, gravityZ, EThrowingWeaponArc::Low, solution));
+		TestFalse(TEXT("Out of reach solution valid"), solution.IsValid());
+	}
+
+	// Without gravity the throw goes straight at the target
+	{
+		FThrowingWeaponBallisticSolution solution;
+		FThrowingWeaponBallistics::Solve(FVector::ZeroVector, FVector(0, 3000, 400), speed, 0, EThrowingWeaponArc::High, solution);
+		TestNearlyEqual(TEXT("No gravity direction Y"), solution.Direction.Y, FVector(0, 3000, 400).GetSafeNormal().Y, 0.01);
+		TestNearlyEqual(TEXT("No gravity time"), static_cast<double>(solution.Time), FVector(0, 3000, 400).Size() / speed, 0.01);
+	}
+
+	// Straight up, 1000 = s * t + g * t^2 / 2
+	{
+		FThrowingWeaponBallisticSolution solution;
+		FThrowingWeaponBallistics::Solve(FVector::ZeroVector, FVector(0, 0, 1000), speed, gravityZ, EThrowingWeaponArc::Low, solution);
+		TestNearlyEqual(TEXT("Straight up direction Z"), solution.Direction.Z, 1.0, 0.01);
+		TestNearlyEqual(TEXT("Straight up time"), static_cast<double>(solution.Time), (speed - FMath::Sqrt(speed * speed + 2.0 * gravityZ * 1000)) / -gravityZ, 0.01);
+	}
+
+	// Leading a target that runs across the throw, both arcs meet it
+	{
+		const FThrowingWeaponBallisticQuery crossing{ FVector(0, 0, 100), FVector(1500, 0, 0), FVector(0, 300, 0) };
+
+		for (const EThrowingWeaponArc arc : { EThrowingWeaponArc::Low, EThrowingWeaponArc::High })
+		{
+			FThrowingWeaponBallisticSolution solution;
+			TestTrue(TEXT("Leading solved"), FThrowingWeaponBallistics::SolveLeading(crossing.Start, crossing.Target, crossing.TargetVelocity, speed, gravityZ, arc, solution));
+			TestNearlyEqual(TEXT("Leading miss"), FThrowingWeaponBallisticsChecks::GetMiss(crossing, speed, gravityZ, solution), 0.0, 0.01);
+			TestNearlyEqual(TEXT("Leading aim point Y"), solution.AimPoint.Y, 300.0 * solution.Time, 0.01);
+			TestTrue(TEXT("Leading leads"), solution.Direction.Y > 0);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponBallisticsRandomPairsTest, "Weapon.Ballistics.RandomPairs", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Every solution the batch finds for random moving pairs is a hit and matches the single solve
+bool FThrowingWeaponBallisticsRandomPairsTest::RunTest(const FString& Parameters)
+{
+	const float speed = 2500;
+	const float gravityZ = -980;
+
+	TArray<FThrowingWeaponBallisticQuery> queries;
+	FThrowingWeaponBallisticsChecks::MakeQueries(4096, true, queries);
+
+	TArray<FThrowingWeaponBallisticSolution> solutions;
+	solutions.SetNum(queries.Num());
+
+	for (const EThrowingWeaponArc arc : { EThrowingWeaponArc::Low, EThrowingWeaponArc::High })
+	{
+		const int32 numSolved = FThrowingWeaponBallistics::SolveBatch(queries, speed, gravityZ, arc, solutions);
+
+		int32 numMisses = 0;
+		int32 numMismatches = 0;
+		for (int32 i = 0; i < queries.Num(); i++)
+		{
+			FThrowingWeaponBallisticSolution single;
+			FThrowingWeaponBallistics::SolveLeading(queries[i].Start, queries[i].Target, queries[i].TargetVelocity, speed, gravityZ, arc, single);
+
+			numMismatches += single.IsValid() != solutions[i].IsValid() || !FMath::IsNearlyEqual(single.Time, solutions[i].Time, 0.0001f) ? 1 : 0;
+			numMisses += solutions[i].IsValid() && FThrowingWeaponBallisticsChecks::GetMiss(queries[i], speed, gravityZ, solutions[i]) > 0.5 ? 1 : 0;
+		}
+
+		const TCHAR* arcName = arc == EThrowingWeaponArc::Low ? TEXT("low") : TEXT("high");
+		TestTrue(FString::Printf(TEXT("Most %s arc pairs are in reach (%d of %d)"), arcName, numSolved, queries.Num()), numSolved > queries.Num() / 2);
+		TestEqual(FString::Printf(TEXT("Solved %s arc pairs that miss by more than 0.5 cm"), arcName), numMisses, 0);
+		TestEqual(FString::Printf(TEXT("Batched and single %s arc solves that disagree"), arcName), numMismatches, 0);
+	}
+
+	return true;
+}
+
+#endif
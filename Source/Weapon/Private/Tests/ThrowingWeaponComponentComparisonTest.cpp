@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponComponentComparison.h"
+#include "DefaultThrowingWeapon.h"
+#include "Struct/public/LatentWorldTest.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponComponentCompareTest, "Weapon.Component.Compare", EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+// Wait for the test level to begin play, then compare 200 hosts holding the weapon through a child actor and through the component
+bool FThrowingWeaponComponentCompareTest::RunTest(const FString& Parameters)
+{
+	FLatentWorldTestCommand::Run(*this, TEXT("No game world to compare the throwing weapon hosts in"), [this](UWorld& world) -> FLatentWorldTestCommand::FTick
+	{
+		if (!world.HasBegunPlay())
+		{
+			return nullptr;
+		}
+
+		TWeakObjectPtr<UWorld> weakWorld = &world;
+		return [this, weakWorld](float deltaTime)
+		{
+			UWorld* world = weakWorld.Get();
+			if (world == nullptr)
+			{
+				AddError(TEXT("The test level was unloaded before the comparison started"));
+				return false;
+			}
+
+			const int32 count = 200;
+
+			FThrowingWeaponComponentComparison::FResult childActorResult;
+			FThrowingWeaponComponentComparison::FResult componentResult;
+			FThrowingWeaponComponentComparison::Compare(world, count, ADefaultThrowingWeapon::StaticClass(), childActorResult, componentResult);
+
+			TestTrue(FString::Printf(TEXT("Component creates fewer UObjects (%d) than the child actor (%d)"), componentResult.NumObjects, childActorResult.NumObjects),
+				componentResult.NumObjects < childActorResult.NumObjects);
+			TestTrue(FString::Printf(TEXT("Component counts less memory (%lld bytes) than the child actor (%lld bytes)"), componentResult.ObjectBytes, childActorResult.ObjectBytes),
+				componentResult.ObjectBytes < childActorResult.ObjectBytes);
+
+			AddInfo(FString::Printf(TEXT("Spawn per instance: child actor %.2f us, component %.2f us"),
+				childActorResult.SpawnMilliseconds * 1000 / count, componentResult.SpawnMilliseconds * 1000 / count));
+			return false;
+		};
+	});
+	return true;
+}
+
+#endif
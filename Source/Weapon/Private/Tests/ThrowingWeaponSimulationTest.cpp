@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponSimulation.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Every check runs on plain values, so none of these needs a world: -nullrhi -ExecCmds="Automation RunTests Weapon.Simulation"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponSimulationImpactTest, "Weapon.Simulation.Impact", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Normal pitch of floors, walls and ceilings and where the weapon lodges on them
+bool FThrowingWeaponSimulationImpactTest::RunTest(const FString& Parameters)
+{
+	// A floor faces up (pitch 90), a wall faces sideways (pitch 0), a ceiling faces down (pitch -90)
+	TestNearlyEqual(TEXT("Floor normal pitch"), FThrowingWeaponSimulation::MakeRotationFromAxes(FVector::UpVector, FVector::ZeroVector, FVector::ZeroVector).Pitch, 90.0, 0.01);
+	TestNearlyEqual(TEXT("Wall normal pitch"), FThrowingWeaponSimulation::MakeRotationFromAxes(FVector::ForwardVector, FVector::ZeroVector, FVector::ZeroVector).Pitch, 0.0, 0.01);
+	TestNearlyEqual(TEXT("Ceiling normal pitch"), FThrowingWeaponSimulation::MakeRotationFromAxes(FVector::DownVector, FVector::ZeroVector, FVector::ZeroVector).Pitch, -90.0, 0.01);
+
+	TestNearlyEqual(TEXT("Floor impact pitch"), FThrowingWeaponSimulation::AdjustImpactPitch(FVector::UpVector, -40, -30), -90.f, 0.01f);
+	TestNearlyEqual(TEXT("Ceiling impact pitch"), FThrowingWeaponSimulation::AdjustImpactPitch(FVector::DownVector, -40, -30), -40.f, 0.01f);
+
+	FThrowingWeaponImpact wallImpact;
+	wallImpact.ImpactNormal = FVector::ForwardVector;
+	wallImpact.ImpactLocation = FVector(100, 0, 0);
+	wallImpact.ActorLocation = FVector(0, 0, 0);
+	wallImpact.LodgePointLocation = FVector(10, 0, 0);
+	TestNearlyEqual(TEXT("Wall impact location X"), FThrowingWeaponSimulation::AdjustImpactLocation(wallImpact).X, 90.0, 0.01);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponSimulationBezierLengthTest, "Weapon.Simulation.BezierLength", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// The closed form arc length against a straight path and a finely sampled curved one
+bool FThrowingWeaponSimulationBezierLengthTest::RunTest(const FString& Parameters)
+{
+	TestNearlyEqual(TEXT("Straight bezier length"), FThrowingWeaponSimulation::CalculateQuadraticBezierLength(FVector::ZeroVector, FVector(500, 0, 0), FVector(1000, 0, 0)), 1000.f, 0.01f);
+
+	const FVector start(1000, 200, 0);
+	const FVector control(300, 900, 150);
+	const FVector end(0, 0, 100);
+
+	double sampledLength = 0;
+	FVector previous = start;
+	for (int32 i = 1; i <= 10000; i++)
+	{
+		const double t = i / 10000.0;
+		const FVector point = start * ((1 - t) * (1 - t)) + control * (2 * (1 - t) * t) + end * (t * t);
+		sampledLength += FVector::Dist(previous, point);
+		previous = point;
+	}
+	TestNearlyEqual(TEXT("Curved bezier length"), static_cast<double>(FThrowingWeaponSimulation::CalculateQuadraticBezierLength(start, control, end)), sampledLength, 0.01);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponSimulationFlightTest, "Weapon.Simulation.Flight", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// The shared flight step lands on the exact arc, and the speed limit, spin and wiggle behave the same for every simulation
+bool FThrowingWeaponSimulationFlightTest::RunTest(const FString& Parameters)
+{
+	FVector location = FVector::ZeroVector;
+	FVector velocity(2000, 0, 1000);
+	for (int32 i = 0; i < 60; i++)
+	{
+		FThrowingWeaponSimulation::AdvanceFlight(location, velocity, -980, 0, 1 / 60.f);
+	}
+	TestTrue(TEXT("Flight is on the arc after a second"), location.Equals(FVector(2000, 0, 1000 - 490), 0.1f));
+	TestNearlyEqual(TEXT("Flight falls at gravity"), velocity.Z, 20.0, 0.01);
+
+	FThrowingWeaponSimulation::AdvanceFlight(location, velocity, -980, 1000, 1 / 60.f);
+	TestTrue(TEXT("Flight keeps to the speed limit"), velocity.Size() <= 1000.01);
+
+	TestNearlyEqual(TEXT("Spin holds at the curve end"), FThrowingWeaponSimulation::AdvanceSpin(0.9f, 0.5f, 1, 1), 1.f, 0.01f);
+	TestNearlyEqual(TEXT("Wiggle tilts the pitch"), FThrowingWeaponSimulation::CalculateWiggleRotation(FRotator(10, 20, 30), 1).Pitch, 10.0 + FThrowingWeaponSimulation::WigglePitch, 0.01);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponSimulationSweepPathTest, "Weapon.Simulation.SweepPath", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// A long frame is split into substeps that follow the falling arc, a short one sweeps the chord
+bool FThrowingWeaponSimulationSweepPathTest::RunTest(const FString& Parameters)
+{
+	const FVector gravity(0, 0, -980);
+	const float elapsedTime = 0.19f;
+
+	FThrowingWeaponFlightSample from;
+	from.Velocity = FVector(3000, 0, 500);
+	from.Time = 10;
+
+	FThrowingWeaponFlightSample to;
+	to.Location = from.Velocity * elapsedTime + gravity * (0.5f * elapsedTime * elapsedTime);
+	to.Velocity = from.Velocity + gravity * elapsedTime;
+	to.Time = from.Time + elapsedTime;
+
+	FThrowingWeaponSweepPath path;
+	FThrowingWeaponSimulation::BuildSweepPath(from, to, 0.05f, 100, path);
+	TestEqual(TEXT("Four substeps and the look-ahead"), path.Num(), 6);
+
+	for (int32 i = 0; i <= 4; i++)
+	{
+		const float time = elapsedTime * i / 4;
+		const FVector arcLocation = from.Velocity * time + gravity * (0.5f * time * time);
+		TestTrue(FString::Printf(TEXT("Substep %d is on the arc"), i), path[i].Equals(arcLocation, 0.01f));
+	}
+	TestTrue(TEXT("Look-ahead follows the velocity"), path[5].Equals(to.Location + to.Velocity.GetSafeNormal() * 100, 0.01f));
+
+	to.Time = from.Time + 0.01f;
+	FThrowingWeaponSimulation::BuildSweepPath(from, to, 0.05f, 0, path);
+	TestEqual(TEXT("Short frame sweeps the chord"), path.Num(), 2);
+
+	to.Time = from.Time + 60;
+	FThrowingWeaponSimulation::BuildSweepPath(from, to, 0.05f, 0, path);
+	TestEqual(TEXT("Hitch is capped"), path.Num(), FThrowingWeaponSimulation::MaxSweepSubsteps + 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponSimulationReturnTest, "Weapon.Simulation.Return", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+// Return duration, play rate and the pose along straight and curved paths
+bool FThrowingWeaponSimulationReturnTest::RunTest(const FString& Parameters)
+{
+	TestNearlyEqual(TEXT("Return duration"), FThrowingWeaponSimulation::CalculateReturnDuration(2800, 1400), 2.f, 0.01f);
+	TestNearlyEqual(TEXT("Zero speed return duration"), FThrowingWeaponSimulation::CalculateReturnDuration(2800, 0), 0.05f, 0.01f);
+	TestNearlyEqual(TEXT("Return play rate"), FThrowingWeaponSimulation::CalculateReturnPlayRate(2, 1), 0.5f, 0.01f);
+
+	// A constant return curve has no duration, it is played over one second and moves the weapon linearly
+	TestNearlyEqual(TEXT("Constant curve end time"), FThrowingWeaponSimulation::GetReturnCurveEndTime(0), 1.f, 0.01f);
+	TestNearlyEqual(TEXT("Curve end time"), FThrowingWeaponSimulation::GetReturnCurveEndTime(2), 2.f, 0.01f);
+	TestNearlyEqual(TEXT("Constant curve return alpha"), FThrowingWeaponSimulation::CalculateReturnAlpha(0, 0.25f, 0), 0.25f, 0.01f);
+	TestNearlyEqual(TEXT("Curve return alpha"), FThrowingWeaponSimulation::CalculateReturnAlpha(0.6f, 0.25f, 2), 0.6f, 0.01f);
+	TestTrue(TEXT("Constant curve return finishes after a second"), !FThrowingWeaponSimulation::IsReturnFinished(0.9f, 0) && FThrowingWeaponSimulation::IsReturnFinished(1, 0));
+	TestNearlyEqual(TEXT("Return average speed"), FThrowingWeaponSimulation::CalculateReturnAverageSpeed(2, 2), FThrowingWeaponSimulation::ReturnOptimalDistance, 0.01f);
+
+	FThrowingWeaponReturn weaponReturn;
+	weaponReturn.InitialLocation = FVector(1000, 0, 0);
+	weaponReturn.GripPointLocation = FVector(0, 0, 100);
+
+	const FThrowingWeaponReturnPath straightPath = FThrowingWeaponSimulation::BuildReturnPath(weaponReturn, 0, 1000);
+	TestNearlyEqual(TEXT("Straight return duration"), straightPath.Duration, static_cast<float>(FVector(1000, 0, -100).Size() / 1000), 0.01f);
+	TestNearlyEqual(TEXT("Half return X"), FThrowingWeaponSimulation::CalculateReturnPose(straightPath, weaponReturn.GripPointLocation, FRotator::ZeroRotator, 0.5f).Location.X, 500.0, 0.01);
+	TestNearlyEqual(TEXT("Finished return Z"), FThrowingWeaponSimulation::CalculateReturnPose(straightPath, weaponReturn.GripPointLocation, FRotator::ZeroRotator, 1).Location.Z, 100.0, 0.01);
+	TestNearlyEqual(TEXT("Retargeted return Y"), FThrowingWeaponSimulation::CalculateReturnPose(straightPath, FVector(0, 300, 100), FRotator::ZeroRotator, 1).Location.Y, 300.0, 0.01);
+
+	weaponReturn.CameraRightVector = FVector(0, 1, 0);
+	const FThrowingWeaponReturnPath curvedPath = FThrowingWeaponSimulation::BuildReturnPath(weaponReturn, 0.25f, 1000);
+	TestNearlyEqual(TEXT("Curved return start X"), FThrowingWeaponSimulation::CalculateReturnPose(curvedPath, weaponReturn.GripPointLocation, FRotator::ZeroRotator, 0).Location.X, 1000.0, 0.01);
+	TestTrue(TEXT("Curved return bows right"), FThrowingWeaponSimulation::CalculateReturnPose(curvedPath, weaponReturn.GripPointLocation, FRotator::ZeroRotator, 0.5f).Location.Y > 100);
+	TestTrue(TEXT("Curved return is longer than its chord"), curvedPath.Length > FVector::Dist(curvedPath.Start, curvedPath.End));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponStressTest.h"
+#include "Struct/public/LatentWorldTest.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ThrowingWeaponStressAutomationTest
+{
+	// Weapon.Stress.Budget* value, 0 (no budget) when the variable is missing
+	float GetBudget(const TCHAR* name)
+	{
+		const IConsoleVariable* variable = IConsoleManager::Get().FindConsoleVariable(name);
+		return variable != nullptr ? variable->GetFloat() : 0;
+	}
+
+	// Fail the test when a budget is set and the value is over it
+	void TestBudget(FAutomationTestBase& test, const TCHAR* what, double value, const TCHAR* budgetName)
+	{
+		const float budget = GetBudget(budgetName);
+		test.TestTrue(FString::Printf(TEXT("%s %.3f is within %s %.3f"), what, value, budgetName, budget), budget <= 0 || value <= budget);
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FThrowingWeaponStressAutomationTest, "Weapon.Stress", EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+// One test per simulation path, both with the default weapon count and cycles
+void FThrowingWeaponStressAutomationTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	OutBeautifiedNames.Add(TEXT("PerActor"));
+	OutTestCommands.Add(TEXT("Batched=false"));
+
+	OutBeautifiedNames.Add(TEXT("Batched"));
+	OutTestCommands.Add(TEXT("Batched=true"));
+}
+// Run the stress test in the test level and check its results against the Weapon.Stress.Budget* budgets
+bool FThrowingWeaponStressAutomationTest::RunTest(const FString& Parameters)
+{
+	using namespace ThrowingWeaponStressAutomationTest;
+
+	FLatentWorldTestCommand::Run(*this, TEXT("No game world to run the throwing weapon stress test in"), [this, Parameters](UWorld& world) -> FLatentWorldTestCommand::FTick
+	{
+		const TSharedPtr<FThrowingWeaponStressTest> stressTest = FThrowingWeaponStressTest::Start(Parameters, &world);
+		if (!stressTest.IsValid())
+		{
+			return nullptr;
+		}
+
+		return [this, stressTest](float deltaTime)
+		{
+			if (stressTest->Tick(deltaTime))
+			{
+				return true;
+			}
+
+			TestEqual(TEXT("Phases that timed out before every weapon lodged or arrived"), stressTest->NumTimedOutPhases, 0);
+			TestBudget(*this, TEXT("Median game thread frame (ms)"), stressTest->MedianMs, TEXT("Weapon.Stress.BudgetMedianMs"));
+			TestBudget(*this, TEXT("99th percentile game thread frame (ms)"), stressTest->P99Ms, TEXT("Weapon.Stress.BudgetP99Ms"));
+			TestBudget(*this, TEXT("Memory growth (MB)"), stressTest->MemoryGrowthMB, TEXT("Weapon.Stress.BudgetMemoryMB"));
+			return false;
+		};
+	});
+	return true;
+}
+
+#endif
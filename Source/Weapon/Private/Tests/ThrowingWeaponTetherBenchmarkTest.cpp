@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponTetherBenchmark.h"
+#include "Struct/public/LatentWorldTest.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FThrowingWeaponTetherBenchmarkTest, "Weapon.Tether.Benchmark", EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+// Compare 100 cables with 100 native tethers in the test level
+bool FThrowingWeaponTetherBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using ETetherType = FThrowingWeaponTetherBenchmark::ETetherType;
+
+	const int32 count = 100;
+
+	FLatentWorldTestCommand::Run(*this, TEXT("No game world to run the tether benchmark in"), [this, count](UWorld& world) -> FLatentWorldTestCommand::FTick
+	{
+		const TSharedPtr<FThrowingWeaponTetherBenchmark> benchmark = FThrowingWeaponTetherBenchmark::Start(&world, 300, { count });
+		if (!benchmark.IsValid())
+		{
+			return nullptr;
+		}
+
+		return [this, benchmark, count](float deltaTime)
+		{
+			if (benchmark->Tick(deltaTime))
+			{
+				return true;
+			}
+
+			const double cableMilliseconds = benchmark->GetRunMilliseconds(ETetherType::Cable, count);
+			const double nativeMilliseconds = benchmark->GetRunMilliseconds(ETetherType::Native, count);
+
+			TestTrue(TEXT("Both tether runs finished"), cableMilliseconds >= 0 && nativeMilliseconds >= 0);
+			TestTrue(FString::Printf(TEXT("%d native tethers (%.3f ms) are not slower than %d cables (%.3f ms)"), count, nativeMilliseconds, count, cableMilliseconds),
+				nativeMilliseconds <= cableMilliseconds);
+			return false;
+		};
+	});
+	return true;
+}
+
+#endif
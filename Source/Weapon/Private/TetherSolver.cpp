@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TetherSolver.h"
+
+// Straight rope from start to end
+void FTetherSolver::Reset(int32 numSegments, const FVector& start, const FVector& end)
+{
+	Allocate(FMath::Max(numSegments, 1) + 1);
+	Origin = start;
+
+	const FVector3f localEnd = FVector3f(end - start);
+
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		const FVector3f position = localEnd * (static_cast<float>(i) / (NumParticles - 1));
+
+		X[i] = PreviousX[i] = position.X;
+		Y[i] = PreviousY[i] = position.Y;
+		Z[i] = PreviousZ[i] = position.Z;
+	}
+}
+// Change the resolution, keeping the current shape (resampled along the particle index)
+void FTetherSolver::SetNumSegments(int32 numSegments)
+{
+	numSegments = FMath::Max(numSegments, 1);
+
+	if (NumParticles < 2 || numSegments == GetNumSegments())
+	{
+		return;
+	}
+
+	const TArray<float> oldX = X;
+	const TArray<float> oldY = Y;
+	const TArray<float> oldZ = Z;
+	const int32 oldNumSegments = GetNumSegments();
+
+	Allocate(numSegments + 1);
+
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		const float oldPosition = static_cast<float>(i) * oldNumSegments / numSegments;
+		const int32 oldIndex = FMath::Min(static_cast<int32>(oldPosition), oldNumSegments - 1);
+		const float alpha = oldPosition - oldIndex;
+
+		// Resampled particles start at rest, the next steps pick the motion up again
+		X[i] = PreviousX[i] = FMath::Lerp(oldX[oldIndex], oldX[oldIndex + 1], alpha);
+		Y[i] = PreviousY[i] = FMath::Lerp(oldY[oldIndex], oldY[oldIndex + 1], alpha);
+		Z[i] = PreviousZ[i] = FMath::Lerp(oldZ[oldIndex], oldZ[oldIndex + 1], alpha);
+	}
+}
+
+void FTetherSolver::Allocate(int32 numParticles)
+{
+	NumParticles = numParticles;
+	NumPaddedParticles = Align(numParticles, 4);
+
+	const int32 arraySize = NumPaddedParticles + 4;
+
+	for (TArray<float>* values : { &X, &Y, &Z, &PreviousX, &PreviousY, &PreviousZ, &CorrectionX, &CorrectionY, &CorrectionZ })
+	{
+		values->Reset(arraySize);
+		values->AddZeroed(arraySize);
+	}
+}
+// Keep the single precision particles close to the origin, the world positions don't change
+void FTetherSolver::Rebase(const FVector& newOrigin)
+{
+	const FVector3f offset = FVector3f(newOrigin - Origin);
+	Origin = newOrigin;
+
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		X[i] -= offset.X;
+		Y[i] -= offset.Y;
+		Z[i] -= offset.Z;
+		PreviousX[i] -= offset.X;
+		PreviousY[i] -= offset.Y;
+		PreviousZ[i] -= offset.Z;
+	}
+}
+
+void FTetherSolver::PinEnds(const FVector3f& localStart, const FVector3f& localEnd)
+{
+	const int32 last = NumParticles - 1;
+
+	X[0] = localStart.X;
+	Y[0] = localStart.Y;
+	Z[0] = localStart.Z;
+	X[last] = localEnd.X;
+	Y[last] = localEnd.Y;
+	Z[last] = localEnd.Z;
+}
+// One Verlet step and the constraint iterations
+void FTetherSolver::Simulate(const FVector& start, const FVector& end, float segmentLength, const FVector& gravity, float deltaTime, float damping, int32 iterations)
+{
+	if (NumParticles < 2)
+	{
+		return;
+	}
+
+	// Single precision is plenty within a few hundred meters of the origin
+	if (FVector::DistSquared(start, Origin) > FMath::Square(100000.0))
+	{
+		Rebase(start);
+	}
+
+	const FVector3f localStart = FVector3f(start - Origin);
+	const FVector3f localEnd = FVector3f(end - Origin);
+	const FVector3f gravityStep = FVector3f(gravity) * (deltaTime * deltaTime);
+
+	// Verlet integration
+	{
+		const VectorRegister4Float dampingVector = VectorSetFloat1(damping);
+		const VectorRegister4Float gravityX = VectorSetFloat1(gravityStep.X);
+		const VectorRegister4Float gravityY = VectorSetFloat1(gravityStep.Y);
+		const VectorRegister4Float gravityZ = VectorSetFloat1(gravityStep.Z);
+
+		float* positions[3] = { X.GetData(), Y.GetData(), Z.GetData() };
+		float* previousPositions[3] = { PreviousX.GetData(), PreviousY.GetData(), PreviousZ.GetData() };
+		const VectorRegister4Float gravitySteps[3] = { gravityX, gravityY, gravityZ };
+
+		for (int32 axis = 0; axis < 3; axis++)
+		{
+			float* position = positions[axis];
+			float* previousPosition = previousPositions[axis];
+
+			for (int32 i = 0; i < NumPaddedParticles; i += 4)
+			{
+				const VectorRegister4Float current = VectorLoad(position + i);
+				const VectorRegister4Float velocity = VectorMultiply(VectorSubtract(current, VectorLoad(previousPosition + i)), dampingVector);
+
+				VectorStore(current, previousPosition + i);
+				VectorStore(VectorAdd(current, VectorAdd(velocity, gravitySteps[axis])), position + i);
+			}
+		}
+	}
+
+	PinEnds(localStart, localEnd);
+
+	const VectorRegister4Float half = VectorSetFloat1(0.5f);
+	const VectorRegister4Float restLength = VectorSetFloat1(segmentLength);
+	const VectorRegister4Float minLengthSquared = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const int32 numLinks = NumParticles - 1;
+
+	for (int32 iteration = 0; iteration < iterations; iteration++)
+	{
+		// Every link at once: half of its stretch goes to each of its particles
+		for (int32 i = 0; i < NumPaddedParticles; i += 4)
+		{
+			const VectorRegister4Float deltaX = VectorSubtract(VectorLoad(X.GetData() + i + 1), VectorLoad(X.GetData() + i));
+			const VectorRegister4Float deltaY = VectorSubtract(VectorLoad(Y.GetData() + i + 1), VectorLoad(Y.GetData() + i));
+			const VectorRegister4Float deltaZ = VectorSubtract(VectorLoad(Z.GetData() + i + 1), VectorLoad(Z.GetData() + i));
+
+			const VectorRegister4Float lengthSquared = VectorMultiplyAdd(deltaX, deltaX, VectorMultiplyAdd(deltaY, deltaY, VectorMultiply(deltaZ, deltaZ)));
+			const VectorRegister4Float inverseLength = VectorReciprocalSqrtAccurate(VectorMax(lengthSquared, minLengthSquared));
+
+			// (1 - rest / length) / 2
+			const VectorRegister4Float stretch = VectorMultiply(VectorSubtract(VectorOneFloat(), VectorMultiply(restLength, inverseLength)), half);
+
+			VectorStore(VectorMultiply(deltaX, stretch), CorrectionX.GetData() + i + 1);
+			VectorStore(VectorMultiply(deltaY, stretch), CorrectionY.GetData() + i + 1);
+			VectorStore(VectorMultiply(deltaZ, stretch), CorrectionZ.GetData() + i + 1);
+		}
+
+		// Links past the last particle lead into the padding
+		for (int32 i = numLinks + 1; i < CorrectionX.Num(); i++)
+		{
+			CorrectionX[i] = CorrectionY[i] = CorrectionZ[i] = 0;
+		}
+
+		// Every particle at once: pulled along its next link, pushed back along its previous one
+		for (int32 i = 0; i < NumPaddedParticles; i += 4)
+		{
+			VectorStore(VectorAdd(VectorLoad(X.GetData() + i), VectorSubtract(VectorLoad(CorrectionX.GetData() + i + 1), VectorLoad(CorrectionX.GetData() + i))), X.GetData() + i);
+			VectorStore(VectorAdd(VectorLoad(Y.GetData() + i), VectorSubtract(VectorLoad(CorrectionY.GetData() + i + 1), VectorLoad(CorrectionY.GetData() + i))), Y.GetData() + i);
+			VectorStore(VectorAdd(VectorLoad(Z.GetData() + i), VectorSubtract(VectorLoad(CorrectionZ.GetData() + i + 1), VectorLoad(CorrectionZ.GetData() + i))), Z.GetData() + i);
+		}
+
+		PinEnds(localStart, localEnd);
+	}
+}
+// Every particle in world space (single precision for rendering)
+void FTetherSolver::GetParticles(TArray<FVector3f>& outParticles) const
+{
+	outParticles.SetNumUninitialized(NumParticles);
+
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		outParticles[i] = FVector3f(GetParticle(i));
+	}
+}
+// World space box around every particle
+FBox FTetherSolver::GetBounds() const
+{
+	FBox bounds(ForceInit);
+
+	for (int32 i = 0; i < NumParticles; i++)
+	{
+		bounds += GetParticle(i);
+	}
+	return bounds;
+}
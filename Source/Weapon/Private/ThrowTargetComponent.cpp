@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowTargetComponent.h"
+#include "ThrowTargetSubsystem.h"
+#include "Engine/World.h"
+
+UThrowTargetComponent::UThrowTargetComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	bWantsOnUpdateTransform = true;
+
+	Priority = 1;
+	bIsTargetable = true;
+	ThrowTargetSubsystem = nullptr;
+	TargetHandle = INDEX_NONE;
+}
+// Register with the world's target grid
+void UThrowTargetComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ThrowTargetSubsystem = UWorld::GetSubsystem<UThrowTargetSubsystem>(GetWorld());
+	if (ThrowTargetSubsystem != nullptr)
+	{
+		TargetHandle = ThrowTargetSubsystem->RegisterTarget(this);
+	}
+}
+
+void UThrowTargetComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ThrowTargetSubsystem != nullptr)
+	{
+		ThrowTargetSubsystem->UnregisterTarget(TargetHandle);
+		ThrowTargetSubsystem = nullptr;
+		TargetHandle = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+// Keep the grid cell up to date as the target moves
+void UThrowTargetComponent::OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	Super::OnUpdateTransform(UpdateTransformFlags, Teleport);
+
+	if (ThrowTargetSubsystem != nullptr)
+	{
+		ThrowTargetSubsystem->MoveTarget(TargetHandle, GetComponentLocation());
+	}
+}
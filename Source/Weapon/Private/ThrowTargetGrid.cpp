@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowTargetGrid.h"
+#include "WeaponStats.h"
+
+FThrowTargetGrid::FThrowTargetGrid(float cellSize)
+{
+	CellSize = FMath::Max(cellSize, 1.f);
+	InvCellSize = 1 / CellSize;
+}
+// Insert a target, returns its handle
+int32 FThrowTargetGrid::Add(const FVector& location)
+{
+	const int32 handle = Targets.Add(FTarget{ location, GetCell(location), INDEX_NONE });
+	AddToCell(handle, Targets[handle].Cell);
+	return handle;
+}
+// Update a target, changes cell only when it crossed a cell border
+void FThrowTargetGrid::Move(int32 handle, const FVector& location)
+{
+	FTarget& target = Targets[handle];
+	target.Location = location;
+
+	const FIntVector cell = GetCell(location);
+	if (cell != target.Cell)
+	{
+		RemoveFromCell(handle);
+		target.Cell = cell;
+		AddToCell(handle, cell);
+	}
+}
+
+void FThrowTargetGrid::Remove(int32 handle)
+{
+	RemoveFromCell(handle);
+	Targets.RemoveAt(handle);
+}
+
+FIntVector FThrowTargetGrid::GetCell(const FVector& location) const
+{
+	return FIntVector(FMath::FloorToInt(location.X * InvCellSize), FMath::FloorToInt(location.Y * InvCellSize), FMath::FloorToInt(location.Z * InvCellSize));
+}
+
+void FThrowTargetGrid::AddToCell(int32 handle, const FIntVector& cell)
+{
+	TArray<int32>& handles = Cells.FindOrAdd(cell);
+	Targets[handle].SlotInCell = handles.Add(handle);
+}
+// Swap the last handle of the cell into the removed slot, empty cells are dropped
+void FThrowTargetGrid::RemoveFromCell(int32 handle)
+{
+	const FTarget& target = Targets[handle];
+	TArray<int32>& handles = Cells.FindChecked(target.Cell);
+
+	handles.RemoveAtSwap(target.SlotInCell, 1, false);
+	if (handles.IsValidIndex(target.SlotInCell))
+	{
+		Targets[handles[target.SlotInCell]].SlotInCell = target.SlotInCell;
+	}
+
+	if (handles.Num() == 0)
+	{
+		Cells.Remove(target.Cell);
+	}
+}
+
+int64 FThrowTargetGrid::CountCells(const FIntVector& minCell, const FIntVector& maxCell)
+{
+	return static_cast<int64>(maxCell.X - minCell.X + 1) * (maxCell.Y - minCell.Y + 1) * (maxCell.Z - minCell.Z + 1);
+}
+// Test every target in the occupied cells of the box, walking whichever is smaller: the box or the occupied cells
+template <typename TPredicate>
+int32 FThrowTargetGrid::VisitBox(const FIntVector& minCell, const FIntVector& maxCell, TPredicate isInside, TArray<int32>& outHandles) const
+{
+	int32 numCandidates = 0;
+	auto visitCell = [this, &isInside, &outHandles, &numCandidates](const TArray<int32>& handles)
+	{
+		numCandidates += handles.Num();
+		for (int32 handle : handles)
+		{
+			if (isInside(Targets[handle].Location))
+			{
+				outHandles.Add(handle);
+			}
+		}
+	};
+
+	int32 numCellsVisited = 0;
+
+	if (CountCells(minCell, maxCell) > Cells.Num())
+	{
+		for (const TPair<FIntVector, TArray<int32>>& cell : Cells)
+		{
+			const FIntVector& key = cell.Key;
+			if (key.X >= minCell.X && key.X <= maxCell.X && key.Y >= minCell.Y && key.Y <= maxCell.Y && key.Z >= minCell.Z && key.Z <= maxCell.Z)
+			{
+				visitCell(cell.Value);
+			}
+			numCellsVisited++;
+		}
+	}
+	else
+	{
+		for (int32 z = minCell.Z; z <= maxCell.Z; z++)
+		{
+			for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+			{
+				for (int32 x = minCell.X; x <= maxCell.X; x++)
+				{
+					if (const TArray<int32>* handles = Cells.Find(FIntVector(x, y, z)))
+					{
+						visitCell(*handles);
+					}
+					numCellsVisited++;
+				}
+			}
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ThrowTargetCellsVisited, numCellsVisited);
+	INC_DWORD_STAT_BY(STAT_ThrowTargetCandidates, numCandidates);
+	return numCellsVisited;
+}
+// Targets inside the cone, the cone is shortened until its bounds fit in maxCells
+int32 FThrowTargetGrid::QueryCone(const FVector& origin, const FVector& direction, float halfAngleRadians, float maxDistance, int32 maxCells, TArray<int32>& outHandles) const
+{
+	const FVector axis = direction.GetSafeNormal();
+	const float clampedHalfAngle = FMath::Clamp(halfAngleRadians, 0.f, FMath::DegreesToRadians(89.f));
+	const float cosHalfAngle = FMath::Cos(clampedHalfAngle);
+	const float tanHalfAngle = FMath::Tan(clampedHalfAngle);
+
+	// The cone's bounds: its tip and the disk at its far end (a disk with normal n reaches r * sqrt(1 - n^2) along each axis)
+	const FVector diskExtentScale(FMath::Sqrt(FMath::Max(0.0, 1 - axis.X * axis.X)), FMath::Sqrt(FMath::Max(0.0, 1 - axis.Y * axis.Y)), FMath::Sqrt(FMath::Max(0.0, 1 - axis.Z * axis.Z)));
+
+	float distance = FMath::Max(maxDistance, 0.f);
+	FIntVector minCell;
+	FIntVector maxCell;
+
+	for (;;)
+	{
+		const FVector farCenter = origin + axis * distance;
+		const FVector diskExtent = diskExtentScale * (distance * tanHalfAngle);
+
+		FBox bounds(origin, origin);
+		bounds += farCenter - diskExtent;
+		bounds += farCenter + diskExtent;
+
+		minCell = GetCell(bounds.Min);
+		maxCell = GetCell(bounds.Max);
+
+		if (CountCells(minCell, maxCell) <= FMath::Max(maxCells, 1) || distance < CellSize)
+		{
+			break;
+		}
+		distance *= 0.75f;
+	}
+
+	const double distanceSquared = FMath::Square(static_cast<double>(distance));
+	const double cosSquared = FMath::Square(static_cast<double>(cosHalfAngle));
+
+	return VisitBox(minCell, maxCell, [&origin, &axis, distanceSquared, cosSquared](const FVector& location)
+	{
+		const FVector toTarget = location - origin;
+		const double along = FVector::DotProduct(toTarget, axis);
+		const double lengthSquared = toTarget.SizeSquared();
+
+		return along > 0 && lengthSquared <= distanceSquared && along * along >= cosSquared * lengthSquared;
+	}, outHandles);
+}
+// Targets inside the sphere, the sphere is shrunk until its bounds fit in maxCells
+int32 FThrowTargetGrid::QuerySphere(const FVector& center, float radius, int32 maxCells, TArray<int32>& outHandles) const
+{
+	float clampedRadius = FMath::Max(radius, 0.f);
+	FIntVector minCell;
+	FIntVector maxCell;
+
+	for (;;)
+	{
+		minCell = GetCell(center - FVector(clampedRadius));
+		maxCell = GetCell(center + FVector(clampedRadius));
+
+		if (CountCells(minCell, maxCell) <= FMath::Max(maxCells, 1) || clampedRadius < CellSize)
+		{
+			break;
+		}
+		clampedRadius *= 0.75f;
+	}
+
+	const double radiusSquared = FMath::Square(static_cast<double>(clampedRadius));
+
+	return VisitBox(minCell, maxCell, [&center, radiusSquared](const FVector& location)
+	{
+		return FVector::DistSquared(location, center) <= radiusSquared;
+	}, outHandles);
+}
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowTargetGridBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThrowTargetGrid.h"
+#include "HAL/IConsoleManager.h"
+
+// Move the targets and run every query both ways
+FThrowTargetGridBenchmark::FResult FThrowTargetGridBenchmark::Measure(int32 numTargets, int32 numQueries)
+{
+	// An encounter spread over 40 x 40 metres, aimed at from its edge
+	const float worldSize = 40000;
+	const float halfAngleDegrees = 10;
+	const float maxDistance = 3000;
+	const int32 maxCells = 512;
+
+	FRandomStream random(numTargets);
+	FThrowTargetGrid grid;
+	TArray<int32> handles;
+
+	for (int32 i = 0; i < numTargets; i++)
+	{
+		handles.Add(grid.Add(FVector(random.FRandRange(0, worldSize), random.FRandRange(0, worldSize), random.FRandRange(0, 300))));
+	}
+
+	TArray<int32> gridResult;
+	TArray<int32> bruteForceResult;
+	FResult result;
+
+	for (int32 query = 0; query < numQueries; query++)
+	{
+		// Every target moves a little each frame, like an encounter does
+		const double moveStart = FPlatformTime::Seconds();
+		for (int32 handle : handles)
+		{
+			grid.Move(handle, grid.GetLocation(handle) + FVector(random.FRandRange(-20, 20), random.FRandRange(-20, 20), 0));
+		}
+		result.MoveSeconds += FPlatformTime::Seconds() - moveStart;
+
+		const FVector origin(random.FRandRange(0, worldSize), random.FRandRange(0, worldSize), 150);
+		const FVector direction = FVector(random.FRandRange(-1, 1), random.FRandRange(-1, 1), random.FRandRange(-0.1f, 0.1f)).GetSafeNormal();
+
+		gridResult.Reset();
+		const double gridStart = FPlatformTime::Seconds();
+		result.NumCellsVisited += grid.QueryCone(origin, direction, FMath::DegreesToRadians(halfAngleDegrees), maxDistance, maxCells, gridResult);
+		result.GridSeconds += FPlatformTime::Seconds() - gridStart;
+
+		bruteForceResult.Reset();
+		const double bruteForceStart = FPlatformTime::Seconds();
+		const double cosSquared = FMath::Square(FMath::Cos(FMath::DegreesToRadians(halfAngleDegrees)));
+		for (int32 handle : handles)
+		{
+			const FVector toTarget = grid.GetLocation(handle) - origin;
+			const double along = FVector::DotProduct(toTarget, direction);
+			if (along > 0 && toTarget.SizeSquared() <= maxDistance * maxDistance && along * along >= cosSquared * toTarget.SizeSquared())
+			{
+				bruteForceResult.Add(handle);
+			}
+		}
+		result.BruteForceSeconds += FPlatformTime::Seconds() - bruteForceStart;
+
+		gridResult.Sort();
+		bruteForceResult.Sort();
+		result.NumMismatches += gridResult != bruteForceResult ? 1 : 0;
+	}
+
+
+	result.NumCells = grid.GetNumCells();
+	return result;
+}
+// Weapon.Targets.Benchmark console command
+void FThrowTargetGridBenchmark::Run(const TArray<FString>& args)
+{
+	const int32 numTargets = args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*args[0])) : 5000;
+	const int32 numQueries = args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*args[1])) : 1000;
+
+	const FResult result = Measure(numTargets, numQueries);
+
+	UE_LOG(LogTemp, Display, TEXT("Weapon.Targets.Benchmark: %d targets in %d cells, %d queries: grid %.2f us/query (%.1f cells), every target %.2f us/query, moves %.2f us/target, %d mismatches"),
+		numTargets, result.NumCells, numQueries,
+		result.GridSeconds * 1000000 / numQueries, static_cast<double>(result.NumCellsVisited) / numQueries,
+		result.BruteForceSeconds * 1000000 / numQueries,
+		result.MoveSeconds * 1000000 / (static_cast<double>(numQueries) * numTargets),
+		result.NumMismatches);
+
+	if (result.NumMismatches > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon.Targets.Benchmark: the grid and the full scan found different targets in %d queries"), result.NumMismatches);
+	}
+}
+
+static FAutoConsoleCommand CmdThrowTargetGridBenchmark(
+	TEXT("Weapon.Targets.Benchmark"),
+	TEXT("Compare throw target grid cone queries with testing every target and check they agree. Optional arguments: targets (5000), queries (1000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FThrowTargetGridBenchmark::Run));
+
+#endif
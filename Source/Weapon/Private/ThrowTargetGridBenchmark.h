@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+/// <summary>
+/// Weapon.Targets.Benchmark: fills a target grid with moving targets and compares aim cone queries against testing every
+/// target, checking that both find the same targets whenever the cone fits the cell budget. The Weapon.Targets.Grid
+/// automation tests run the same comparison and fail on any mismatch or a grid slower than the full scan
+/// </summary>
+struct FThrowTargetGridBenchmark
+{
+	struct FResult
+	{
+		int32 NumCells = 0;
+		double GridSeconds = 0; // Cone queries on the grid
+		double BruteForceSeconds = 0; // The same cones tested against every target
+		double MoveSeconds = 0; // Moving every target once per query
+		int64 NumCellsVisited = 0;
+		int32 NumMismatches = 0; // Queries where the grid and the full scan found different targets
+	};
+
+	static FResult Measure(int32 numTargets, int32 numQueries); // Move the targets and run every query both ways
+
+	static void Run(const TArray<FString>& args); // Weapon.Targets.Benchmark console command
+};
+
+#endif
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowTargetSubsystem.h"
+#include "ThrowTargetComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "WeaponStats.h"
+
+static float GThrowTargetCellSize = 1000;
+static FAutoConsoleVariableRef CVarThrowTargetCellSize(
+	TEXT("Weapon.Targets.CellSize"),
+	GThrowTargetCellSize,
+	TEXT("Edge length of a throw target grid cell (read when a world starts)"));
+
+static int32 GThrowTargetMaxQueryCells = 512;
+static FAutoConsoleVariableRef CVarThrowTargetMaxQueryCells(
+	TEXT("Weapon.Targets.MaxQueryCells"),
+	GThrowTargetMaxQueryCells,
+	TEXT("Most grid cells one throw target query visits, larger queries are shortened to fit"));
+
+void UThrowTargetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Grid = FThrowTargetGrid(GThrowTargetCellSize);
+}
+// Only game worlds have targets to throw at
+bool UThrowTargetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+// Add a target at its current location, returns its handle
+int32 UThrowTargetSubsystem::RegisterTarget(UThrowTargetComponent* target)
+{
+	const int32 handle = Grid.Add(target->GetComponentLocation());
+
+	if (handle >= Targets.Num())
+	{
+		Targets.SetNum(handle + 1);
+	}
+	Targets[handle] = target;
+
+	INC_DWORD_STAT(STAT_ThrowTargets);
+	return handle;
+}
+
+void UThrowTargetSubsystem::UnregisterTarget(int32 handle)
+{
+	if (Grid.IsValidHandle(handle))
+	{
+		Grid.Remove(handle);
+		Targets[handle] = nullptr;
+
+		DEC_DWORD_STAT(STAT_ThrowTargets);
+	}
+}
+// Only touches the grid when the target crossed a cell border
+void UThrowTargetSubsystem::MoveTarget(int32 handle, const FVector& location)
+{
+	if (Grid.IsValidHandle(handle))
+	{
+		Grid.Move(handle, location);
+	}
+}
+// Every target inside the cone
+void UThrowTargetSubsystem::QueryCone(const FVector& origin, const FVector& direction, float halfAngleDegrees, float maxDistance, TArray<UThrowTargetComponent*>& outTargets) const
+{
+	WEAPON_PROFILE_SCOPE(STAT_ThrowTargetQuery);
+
+	QueryHandles.Reset();
+	Grid.QueryCone(origin, direction, FMath::DegreesToRadians(halfAngleDegrees), maxDistance, GThrowTargetMaxQueryCells, QueryHandles);
+	GatherTargets(outTargets);
+}
+// Every target inside the sphere
+void UThrowTargetSubsystem::QuerySphere(const FVector& center, float radius, TArray<UThrowTargetComponent*>& outTargets) const
+{
+	WEAPON_PROFILE_SCOPE(STAT_ThrowTargetQuery);
+
+	QueryHandles.Reset();
+	Grid.QuerySphere(center, radius, GThrowTargetMaxQueryCells, QueryHandles);
+	GatherTargets(outTargets);
+}
+// Best of centered and near, scaled by priority
+UThrowTargetComponent* UThrowTargetSubsystem::FindBestTarget(const FVector& origin, const FVector& direction, float halfAngleDegrees, float maxDistance, const AActor* ignoredActor) const
+{
+	WEAPON_PROFILE_SCOPE(STAT_ThrowTargetQuery);
+
+	QueryHandles.Reset();
+	Grid.QueryCone(origin, direction, FMath::DegreesToRadians(halfAngleDegrees), maxDistance, GThrowTargetMaxQueryCells, QueryHandles);
+
+	const FVector axis = direction.GetSafeNormal();
+	const float cosHalfAngle = FMath::Cos(FMath::DegreesToRadians(halfAngleDegrees));
+
+	UThrowTargetComponent* bestTarget = nullptr;
+	float bestScore = -MAX_flt;
+
+	for (int32 handle : QueryHandles)
+	{
+		UThrowTargetComponent* target = Targets[handle];
+		if (target == nullptr || !target->bIsTargetable || target->GetOwner() == ignoredActor)
+		{
+			continue;
+		}
+
+		const FVector toTarget = Grid.GetLocation(handle) - origin;
+		const float distance = toTarget.Size();
+		const float cosAngle = distance > KINDA_SMALL_NUMBER ? FVector::DotProduct(toTarget, axis) / distance : 1;
+
+		// 1 on the axis and 0 at the cone's edge, plus up to half for being near. Never negative, so a higher priority always scores higher
+		const float centered = (cosAngle - cosHalfAngle) / FMath::Max(1 - cosHalfAngle, KINDA_SMALL_NUMBER);
+		const float nearness = 1 - FMath::Min(distance / FMath::Max(maxDistance, 1.f), 1.f);
+		const float score = FMath::Max(centered + 0.5f * nearness, 0.f) * target->Priority;
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestTarget = target;
+		}
+	}
+	return bestTarget;
+}
+// Components of the handles the last query found
+void UThrowTargetSubsystem::GatherTargets(TArray<UThrowTargetComponent*>& outTargets) const
+{
+	outTargets.Reserve(outTargets.Num() + QueryHandles.Num());
+
+	for (int32 handle : QueryHandles)
+	{
+		if (UThrowTargetComponent* target = Targets[handle])
+		{
+			outTargets.Add(target);
+		}
+	}
+}
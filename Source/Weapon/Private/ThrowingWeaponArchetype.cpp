@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponArchetype.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/StaticMesh.h"
+
+// Every set soft reference, loaded together with the archetype
+void UThrowingWeaponArchetype::GetAssetPaths(TArray<FSoftObjectPath>& outPaths) const
+{
+	for (const FSoftObjectPath& path : { Mesh.ToSoftObjectPath(), RotationForwardCurve.ToSoftObjectPath(), ReturnSpeedCurve.ToSoftObjectPath(), WiggleCurve.ToSoftObjectPath() })
+	{
+		if (!path.IsNull())
+		{
+			outPaths.Add(path);
+		}
+	}
+}
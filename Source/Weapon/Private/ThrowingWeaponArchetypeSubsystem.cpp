@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponArchetypeSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+
+// Start loading the preload manifest, its archetypes follow when it arrives
+void UThrowingWeaponArchetypeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (PreloadManifest.IsNull())
+	{
+		return;
+	}
+
+	PreloadManifestHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(PreloadManifest.ToSoftObjectPath(), FStreamableDelegate::CreateWeakLambda(this, [this]()
+	{
+		const UThrowingWeaponPreloadManifest* manifest = PreloadManifest.Get();
+		if (manifest == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Throwing weapon preload manifest %s could not be loaded"), *PreloadManifest.ToString());
+			return;
+		}
+
+		for (const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype : manifest->Archetypes)
+		{
+			if (!archetype.IsNull())
+			{
+				LoadArchetype(archetype.ToSoftObjectPath()).bPreloaded = true;
+			}
+		}
+	}));
+}
+// Let go of every archetype, loads still running are cancelled
+void UThrowingWeaponArchetypeSubsystem::Deinitialize()
+{
+	for (TPair<FSoftObjectPath, FArchetypeLoad>& archetype : Archetypes)
+	{
+		for (const TSharedPtr<FStreamableHandle>& handle : { archetype.Value.ArchetypeHandle, archetype.Value.AssetsHandle })
+		{
+			if (handle.IsValid())
+			{
+				handle->CancelHandle();
+			}
+		}
+	}
+	Archetypes.Reset();
+
+	if (PreloadManifestHandle.IsValid())
+	{
+		PreloadManifestHandle->CancelHandle();
+		PreloadManifestHandle.Reset();
+	}
+
+	Super::Deinitialize();
+}
+// Add a user, onLoaded runs once the archetype and its assets are in memory
+void UThrowingWeaponArchetypeSubsystem::RequestArchetype(const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype, FOnThrowingWeaponArchetypeLoaded onLoaded)
+{
+	if (archetype.IsNull())
+	{
+		return;
+	}
+
+	FArchetypeLoad& load = LoadArchetype(archetype.ToSoftObjectPath());
+	load.NumUsers++;
+
+	if (load.bLoaded)
+	{
+		onLoaded.ExecuteIfBound(archetype.Get());
+	}
+	else
+	{
+		load.Waiting.Add(MoveTemp(onLoaded));
+	}
+}
+// Remove a user, the archetype stays resident while it is preloaded or still used
+void UThrowingWeaponArchetypeSubsystem::ReleaseArchetype(const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype)
+{
+	const FSoftObjectPath path = archetype.ToSoftObjectPath();
+
+	FArchetypeLoad* load = Archetypes.Find(path);
+	if (load == nullptr)
+	{
+		return;
+	}
+
+	load->NumUsers = FMath::Max(0, load->NumUsers - 1);
+
+	if (load->NumUsers == 0 && !load->bPreloaded)
+	{
+		// Releasing the handles only drops the references, garbage collection frees the assets
+		for (const TSharedPtr<FStreamableHandle>& handle : { load->ArchetypeHandle, load->AssetsHandle })
+		{
+			if (handle.IsValid())
+			{
+				handle->CancelHandle();
+			}
+		}
+		Archetypes.Remove(path);
+	}
+}
+
+bool UThrowingWeaponArchetypeSubsystem::IsArchetypeLoaded(const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype) const
+{
+	const FArchetypeLoad* load = Archetypes.Find(archetype.ToSoftObjectPath());
+	return load != nullptr && load->bLoaded;
+}
+// Start loading the archetype if it isn't already
+UThrowingWeaponArchetypeSubsystem::FArchetypeLoad& UThrowingWeaponArchetypeSubsystem::LoadArchetype(const FSoftObjectPath& path)
+{
+	if (FArchetypeLoad* load = Archetypes.Find(path))
+	{
+		return *load;
+	}
+
+	Archetypes.Add(path);
+	TSharedPtr<FStreamableHandle> handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(path, FStreamableDelegate::CreateUObject(this, &UThrowingWeaponArchetypeSubsystem::ArchetypeLoaded, path));
+
+	// Found again, the map may have changed if the load finished right away
+	FArchetypeLoad& load = Archetypes.FindChecked(path);
+	load.ArchetypeHandle = handle;
+	return load;
+}
+// The archetype is in memory, load the mesh and curves it references
+void UThrowingWeaponArchetypeSubsystem::ArchetypeLoaded(FSoftObjectPath path)
+{
+	FArchetypeLoad* load = Archetypes.Find(path);
+	const UThrowingWeaponArchetype* archetype = Cast<UThrowingWeaponArchetype>(path.ResolveObject());
+
+	if (load == nullptr || load->AssetsHandle.IsValid())
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> assetPaths;
+	if (archetype != nullptr)
+	{
+		archetype->GetAssetPaths(assetPaths);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Throwing weapon archetype %s could not be loaded"), *path.ToString());
+	}
+
+	if (assetPaths.Num() == 0)
+	{
+		AssetsLoaded(path);
+		return;
+	}
+
+	load->AssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(assetPaths, FStreamableDelegate::CreateUObject(this, &UThrowingWeaponArchetypeSubsystem::AssetsLoaded, path));
+}
+// Everything is in memory, hand the archetype to whoever waited for it
+void UThrowingWeaponArchetypeSubsystem::AssetsLoaded(FSoftObjectPath path)
+{
+	FArchetypeLoad* load = Archetypes.Find(path);
+	if (load == nullptr || load->bLoaded)
+	{
+		return;
+	}
+
+	load->bLoaded = true;
+
+	// A callback may request or release archetypes, which can move the map entries
+	TArray<FOnThrowingWeaponArchetypeLoaded> waiting = MoveTemp(load->Waiting);
+	UThrowingWeaponArchetype* archetype = Cast<UThrowingWeaponArchetype>(path.ResolveObject());
+
+	for (FOnThrowingWeaponArchetypeLoaded& onLoaded : waiting)
+	{
+		onLoaded.ExecuteIfBound(archetype);
+	}
+}
@@ -0,0 +1,444 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponBallistics.h"
+#include "WeaponStats.h"
+
+#if !UE_BUILD_SHIPPING
+#include "ThrowingWeaponBallisticsChecks.h"
+#include "HAL/IConsoleManager.h"
+#endif
+
+namespace Ballistics
+{
+	// Real cube root, FMath::Pow is NaN for negative bases
+	double Cbrt(double value)
+	{
+		return value < 0 ? -FMath::Pow(-value, 1.0 / 3) : FMath::Pow(value, 1.0 / 3);
+	}
+
+	// Real roots of a * x^2 + b * x + c
+	int32 SolveQuadratic(double a, double b, double c, double* outRoots)
+	{
+		if (FMath::Abs(a) < UE_DOUBLE_SMALL_NUMBER)
+		{
+			if (FMath::Abs(b) < UE_DOUBLE_SMALL_NUMBER)
+			{
+				return 0;
+			}
+			outRoots[0] = -c / b;
+			return 1;
+		}
+
+		const double discriminant = b * b - 4 * a * c;
+		if (discriminant < 0)
+		{
+			return 0;
+		}
+
+		// Written so neither root subtracts two nearly equal numbers
+		const double sqrtDiscriminant = FMath::Sqrt(discriminant);
+		const double q = -0.5 * (b + (b < 0 ? -sqrtDiscriminant : sqrtDiscriminant));
+		outRoots[0] = q / a;
+		outRoots[1] = FMath::Abs(q) > UE_DOUBLE_SMALL_NUMBER ? c / q : outRoots[0];
+		return 2;
+	}
+
+	// Largest real root of x^3 + a * x^2 + b * x + c, Cardano with one real root, the trigonometric form with three
+	double SolveCubicLargest(double a, double b, double c)
+	{
+		const double p = b - a * a / 3;
+		const double q = 2 * a * a * a / 27 - a * b / 3 + c;
+		const double discriminant = q * q / 4 + p * p * p / 27;
+
+		double root = 0;
+		if (discriminant > 0)
+		{
+			const double sqrtDiscriminant = FMath::Sqrt(discriminant);
+			root = Cbrt(-q / 2 + sqrtDiscriminant) + Cbrt(-q / 2 - sqrtDiscriminant);
+		}
+		else if (p < 0)
+		{
+			const double angle = FMath::Acos(FMath::Clamp(3 * q / (2 * p) * FMath::Sqrt(-3 / p), -1.0, 1.0)) / 3;
+			root = 2 * FMath::Sqrt(-p / 3) * FMath::Cos(angle);
+		}
+		return root - a / 3;
+	}
+
+	// Real roots of a4 * x^4 + a3 * x^3 + a2 * x^2 + a1 * x + a0, Ferrari's method on the depressed quartic
+	int32 SolveQuartic(double a4, double a3, double a2, double a1, double a0, double* outRoots)
+	{
+		if (FMath::Abs(a4) < UE_DOUBLE_SMALL_NUMBER)
+		{
+			// Without gravity the cubic term goes too, what's left is the straight line intercept
+			return SolveQuadratic(a2, a1, a0, outRoots);
+		}
+
+		const double b = a3 / a4;
+		const double c = a2 / a4;
+		const double d = a1 / a4;
+		const double e = a0 / a4;
+
+		// x = y - b / 4 leaves y^4 + p * y^2 + q * y + r
+		const double bb = b * b;
+		const double p = c - 3 * bb / 8;
+		const double q = bb * b / 8 - b * c / 2 + d;
+		const double r = -3 * bb * bb / 256 + bb * c / 16 - b * d / 4 + e;
+		const double shift = -b / 4;
+
+		int32 numRoots = 0;
+		double quadraticRoots[2];
+
+		if (FMath::Abs(q) < UE_DOUBLE_KINDA_SMALL_NUMBER)
+		{
+			// Quadratic in y^2
+			const int32 numSquares = SolveQuadratic(1, p, r, quadraticRoots);
+			for (int32 i = 0; i < numSquares; i++)
+			{
+				if (quadraticRoots[i] >= 0)
+				{
+					const double y = FMath::Sqrt(quadraticRoots[i]);
+					outRoots[numRoots++] = y + shift;
+					outRoots[numRoots++] = -y + shift;
+				}
+			}
+			return numRoots;
+		}
+
+		// m makes (y^2 + p / 2 + m)^2 - 2m * (y - q / 4m)^2 the quartic, which splits it into two quadratics
+		const double m = FMath::Max(SolveCubicLargest(p, p * p / 4 - r, -q * q / 8), UE_DOUBLE_SMALL_NUMBER);
+		const double s = FMath::Sqrt(2 * m);
+		const double offset = q / (2 * s);
+
+		for (const double sign : { 1.0, -1.0 })
+		{
+			const int32 numQuadraticRoots = SolveQuadratic(1, -sign * s, p / 2 + m + sign * offset, quadraticRoots);
+			for (int32 i = 0; i < numQuadraticRoots; i++)
+			{
+				outRoots[numRoots++] = quadraticRoots[i] + shift;
+			}
+		}
+		return numRoots;
+	}
+
+	// Two Newton steps on the quartic take the rounding of the closed form out of a root
+	double PolishRoot(double a4, double a3, double a2, double a1, double a0, double root)
+	{
+		for (int32 i = 0; i < 2; i++)
+		{
+			const double value = (((a4 * root + a3) * root + a2) * root + a1) * root + a0;
+			const double slope = ((4 * a4 * root + 3 * a3) * root + 2 * a2) * root + a1;
+			if (FMath::Abs(slope) < UE_DOUBLE_SMALL_NUMBER)
+			{
+				break;
+			}
+			root -= value / slope;
+		}
+		return root;
+	}
+
+	// Direction and aim point of a flight that takes time seconds
+	FORCEINLINE bool MakeSolution(const FVector& offset, const FVector& targetVelocity, double gravityZ, double time, const FVector& target, FThrowingWeaponBallisticSolution& outSolution)
+	{
+		if (!(time > UE_DOUBLE_KINDA_SMALL_NUMBER))
+		{
+			outSolution = FThrowingWeaponBallisticSolution();
+			return false;
+		}
+
+		// Launch velocity is (d + v t) / t - g t / 2
+		FVector launchVelocity = offset / time + targetVelocity;
+		launchVelocity.Z -= 0.5 * gravityZ * time;
+
+		outSolution.Direction = launchVelocity.GetSafeNormal();
+		outSolution.AimPoint = target + targetVelocity * time;
+		outSolution.Time = time;
+		return true;
+	}
+
+	// Still target: a4 * t^4 + a2 * t^2 + a0 is a quadratic in t^2
+	FORCEINLINE bool SolveStill(const FVector& start, const FVector& target, double speedSquared, double gravityZ, EThrowingWeaponArc arc, FThrowingWeaponBallisticSolution& outSolution)
+	{
+		const FVector offset = target - start;
+		const double a4 = 0.25 * gravityZ * gravityZ;
+		const double a2 = -offset.Z * gravityZ - speedSquared;
+		const double a0 = offset.SizeSquared();
+
+		double timeSquared = -1;
+		if (a4 < UE_DOUBLE_SMALL_NUMBER)
+		{
+			timeSquared = a0 / speedSquared;
+		}
+		else
+		{
+			// Negative discriminant: the target is further than the throw speed can carry the weapon
+			const double discriminant = a2 * a2 - 4 * a4 * a0;
+			if (discriminant >= 0)
+			{
+				const double sqrtDiscriminant = FMath::Sqrt(discriminant);
+				timeSquared = (-a2 + (arc == EThrowingWeaponArc::Low ? -sqrtDiscriminant : sqrtDiscriminant)) / (2 * a4);
+			}
+		}
+
+		return MakeSolution(offset, FVector::ZeroVector, gravityZ, timeSquared > 0 ? FMath::Sqrt(timeSquared) : -1, target, outSolution);
+	}
+
+	// Moving target: the full quartic, the low arc is the shortest positive flight time and the high arc the longest
+	bool SolveMoving(const FVector& start, const FVector& target, const FVector& targetVelocity, double speedSquared, double gravityZ, EThrowingWeaponArc arc, FThrowingWeaponBallisticSolution& outSolution)
+	{
+		const FVector offset = target - start;
+		const double a4 = 0.25 * gravityZ * gravityZ;
+		const double a3 = -targetVelocity.Z * gravityZ;
+		const double a2 = targetVelocity.SizeSquared() - offset.Z * gravityZ - speedSquared;
+		const double a1 = 2 * FVector::DotProduct(offset, targetVelocity);
+		const double a0 = offset.SizeSquared();
+
+		double roots[4];
+		const int32 numRoots = SolveQuartic(a4, a3, a2, a1, a0, roots);
+
+		double time = -1;
+		for (int32 i = 0; i < numRoots; i++)
+		{
+			const double root = PolishRoot(a4, a3, a2, a1, a0, roots[i]);
+			if (root > UE_DOUBLE_KINDA_SMALL_NUMBER && (time < 0 || (arc == EThrowingWeaponArc::Low ? root < time : root > time)))
+			{
+				time = root;
+			}
+		}
+
+		return MakeSolution(offset, targetVelocity, gravityZ, time, target, outSolution);
+	}
+}
+
+// Still target, false when it is out of reach at this speed
+bool FThrowingWeaponBallistics::Solve(const FVector& start, const FVector& target, float speed, float gravityZ, EThrowingWeaponArc arc, FThrowingWeaponBallisticSolution& outSolution)
+{
+	if (speed <= 0)
+	{
+		outSolution = FThrowingWeaponBallisticSolution();
+		return false;
+	}
+	return Ballistics::SolveStill(start, target, static_cast<double>(speed) * speed, gravityZ, arc, outSolution);
+}
+// Moving target, aims where it will be when the weapon gets there
+bool FThrowingWeaponBallistics::SolveLeading(const FVector& start, const FVector& target, const FVector& targetVelocity, float speed, float gravityZ, EThrowingWeaponArc arc, FThrowingWeaponBallisticSolution& outSolution)
+{
+	if (targetVelocity.IsNearlyZero())
+	{
+		return Solve(start, target, speed, gravityZ, arc, outSolution);
+	}
+
+	if (speed <= 0)
+	{
+		outSolution = FThrowingWeaponBallisticSolution();
+		return false;
+	}
+	return Ballistics::SolveMoving(start, target, targetVelocity, static_cast<double>(speed) * speed, gravityZ, arc, outSolution);
+}
+// Every pair with the same speed and gravity, one tight loop over contiguous queries. Returns how many are in reach
+int32 FThrowingWeaponBallistics::SolveBatch(TArrayView<const FThrowingWeaponBallisticQuery> queries, float speed, float gravityZ, EThrowingWeaponArc arc, TArrayView<FThrowingWeaponBallisticSolution> outSolutions)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponBallisticBatch);
+
+	check(outSolutions.Num() >= queries.Num());
+
+	if (speed <= 0)
+	{
+		for (int32 i = 0; i < queries.Num(); i++)
+		{
+			outSolutions[i] = FThrowingWeaponBallisticSolution();
+		}
+		return 0;
+	}
+
+	const double speedSquared = static_cast<double>(speed) * speed;
+	const FThrowingWeaponBallisticQuery* query = queries.GetData();
+	FThrowingWeaponBallisticSolution* solution = outSolutions.GetData();
+
+	int32 numSolved = 0;
+	for (int32 i = 0; i < queries.Num(); i++)
+	{
+		const bool bSolved = query[i].TargetVelocity.IsNearlyZero()
+			? Ballistics::SolveStill(query[i].Start, query[i].Target, speedSquared, gravityZ, arc, solution[i])
+			: Ballistics::SolveMoving(query[i].Start, query[i].Target, query[i].TargetVelocity, speedSquared, gravityZ, arc, solution[i]);
+
+		numSolved += bSolved ? 1 : 0;
+	}
+
+	INC_DWORD_STAT_BY(STAT_WeaponBallisticSolves, queries.Num());
+	return numSolved;
+}
+
+#if !UE_BUILD_SHIPPING
+
+double FThrowingWeaponBallisticsChecks::GetMiss(const FThrowingWeaponBallisticQuery& query, float speed, float gravityZ, const FThrowingWeaponBallisticSolution& solution)
+{
+	const double time = solution.Time;
+
+	FVector weaponLocation = query.Start + solution.Direction * (speed * time);
+	weaponLocation.Z += 0.5 * gravityZ * time * time;
+
+	return FVector::Dist(weaponLocation, query.Target + query.TargetVelocity * time);
+}
+
+bool FThrowingWeaponBallisticsChecks::SolveByTrialThrows(const FVector& start, const FVector& target, float speed, float gravityZ, FVector& outDirection)
+{
+	const FVector offset = target - start;
+	const FVector horizontal = FVector(offset.X, offset.Y, 0).GetSafeNormal();
+	const double distance = FVector(offset.X, offset.Y, 0).Size();
+	const double stepTime = 1.0 / 60;
+
+	// Height of a stepped throw at the target distance, like the projectile movement would fly it
+	auto throwHeight = [&](double pitch)
+	{
+		FVector location = start;
+		FVector velocity = horizontal * (speed * FMath::Cos(pitch)) + FVector(0, 0, speed * FMath::Sin(pitch));
+		double travelled = 0;
+
+		for (int32 step = 0; step < 600; step++)
+		{
+			const FVector next = location + velocity * stepTime + FVector(0, 0, 0.5 * gravityZ * stepTime * stepTime);
+			const double nextTravelled = FVector::DotProduct(next - start, horizontal);
+
+			if (nextTravelled >= distance)
+			{
+				return FMath::Lerp(location.Z, next.Z, (distance - travelled) / FMath::Max(nextTravelled - travelled, UE_DOUBLE_SMALL_NUMBER));
+			}
+
+			location = next;
+			travelled = nextTravelled;
+			velocity.Z += gravityZ * stepTime;
+		}
+		return -UE_DOUBLE_BIG_NUMBER;
+	};
+
+	// The low arc only, between straight down and the widest throw
+	double low = -UE_DOUBLE_HALF_PI + 0.01;
+	double high = UE_DOUBLE_PI / 4;
+
+	if (throwHeight(high) < target.Z)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < 24; i++)
+	{
+		const double pitch = (low + high) / 2;
+		if (throwHeight(pitch) < target.Z)
+		{
+			low = pitch;
+		}
+		else
+		{
+			high = pitch;
+		}
+	}
+
+	const double pitch = (low + high) / 2;
+	outDirection = horizontal * FMath::Cos(pitch) + FVector(0, 0, FMath::Sin(pitch));
+	return true;
+}
+
+void FThrowingWeaponBallisticsChecks::MakeQueries(int32 numQueries, bool bMoving, TArray<FThrowingWeaponBallisticQuery>& outQueries)
+{
+	FRandomStream random(0);
+
+	outQueries.Reset(numQueries);
+	for (int32 i = 0; i < numQueries; i++)
+	{
+		FThrowingWeaponBallisticQuery& query = outQueries.AddDefaulted_GetRef();
+		query.Start = FVector(random.FRandRange(-1000, 1000), random.FRandRange(-1000, 1000), random.FRandRange(0, 200));
+		const double targetYaw = random.FRandRange(0, UE_TWO_PI);
+		query.Target = query.Start + FVector(FMath::Cos(targetYaw), FMath::Sin(targetYaw), 0) * random.FRandRange(200, 4000) + FVector(0, 0, random.FRandRange(-500, 500));
+
+		const double velocityYaw = random.FRandRange(0, UE_TWO_PI);
+		query.TargetVelocity = bMoving ? FVector(FMath::Cos(velocityYaw), FMath::Sin(velocityYaw), 0) * random.FRandRange(0, 600) : FVector::ZeroVector;
+	}
+}
+
+template<typename FunctionType>
+double FThrowingWeaponBallisticsChecks::TimeNanosecondsPerCall(int32 iterations, FunctionType&& function)
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+
+	for (int32 i = 0; i < iterations; i++)
+	{
+		function(i);
+	}
+
+	return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles) * 1000000.0 / iterations;
+}
+
+void FThrowingWeaponBallisticsChecks::Benchmark(const TArray<FString>& args)
+{
+	const int32 numPairs = args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*args[0])) : 1024;
+	const int32 numPasses = args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*args[1])) : 200;
+
+	const float speed = 2500;
+	const float gravityZ = -980;
+
+	TArray<FThrowingWeaponBallisticQuery> stillQueries;
+	TArray<FThrowingWeaponBallisticQuery> movingQueries;
+	MakeQueries(numPairs, false, stillQueries);
+	MakeQueries(numPairs, true, movingQueries);
+
+	TArray<FThrowingWeaponBallisticSolution> solutions;
+	solutions.SetNum(numPairs);
+
+	// Summed into a volatile so the solves aren't optimized away
+	double sink = 0;
+	const int32 numSolves = numPairs * numPasses;
+
+	const double stillNs = TimeNanosecondsPerCall(numSolves, [&](int32 i)
+	{
+		const FThrowingWeaponBallisticQuery& query = stillQueries[i % numPairs];
+		FThrowingWeaponBallistics::Solve(query.Start, query.Target, speed, gravityZ, EThrowingWeaponArc::Low, solutions[i % numPairs]);
+		sink += solutions[i % numPairs].Time;
+	});
+
+	const double movingNs = TimeNanosecondsPerCall(numSolves, [&](int32 i)
+	{
+		const FThrowingWeaponBallisticQuery& query = movingQueries[i % numPairs];
+		FThrowingWeaponBallistics::SolveLeading(query.Start, query.Target, query.TargetVelocity, speed, gravityZ, EThrowingWeaponArc::Low, solutions[i % numPairs]);
+		sink += solutions[i % numPairs].Time;
+	});
+
+	int32 numStillSolved = 0;
+	const double stillBatchNs = TimeNanosecondsPerCall(numPasses, [&](int32 i)
+	{
+		numStillSolved = FThrowingWeaponBallistics::SolveBatch(stillQueries, speed, gravityZ, EThrowingWeaponArc::Low, solutions);
+		sink += solutions[i % numPairs].Time;
+	}) / numPairs;
+
+	int32 numMovingSolved = 0;
+	const double movingBatchNs = TimeNanosecondsPerCall(numPasses, [&](int32 i)
+	{
+		numMovingSolved = FThrowingWeaponBallistics::SolveBatch(movingQueries, speed, gravityZ, EThrowingWeaponArc::High, solutions);
+		sink += solutions[i % numPairs].Time;
+	}) / numPairs;
+
+	// The trial throws are orders of magnitude slower, a single pass over the pairs is plenty
+	const double trialNs = TimeNanosecondsPerCall(numPairs, [&](int32 i)
+	{
+		FVector direction;
+		SolveByTrialThrows(stillQueries[i].Start, stillQueries[i].Target, speed, gravityZ, direction);
+		sink += direction.X;
+	});
+
+	volatile double result = sink;
+	(void)result;
+
+	UE_LOG(LogTemp, Display, TEXT("Throwing weapon ballistics benchmark (%d pairs, %d passes, ns per solve):"), numPairs, numPasses);
+	UE_LOG(LogTemp, Display, TEXT("  Solve (still)              %10.2f"), stillNs);
+	UE_LOG(LogTemp, Display, TEXT("  SolveLeading (moving)      %10.2f"), movingNs);
+	UE_LOG(LogTemp, Display, TEXT("  SolveBatch (still, low)    %10.2f  %d/%d in reach"), stillBatchNs, numStillSolved, numPairs);
+	UE_LOG(LogTemp, Display, TEXT("  SolveBatch (moving, high)  %10.2f  %d/%d in reach"), movingBatchNs, numMovingSolved, numPairs);
+	UE_LOG(LogTemp, Display, TEXT("  Trial throws (still, low)  %10.2f  %.0fx the batched solve"), trialNs, trialNs / FMath::Max(stillBatchNs, UE_DOUBLE_SMALL_NUMBER));
+}
+
+static FAutoConsoleCommand CmdThrowingWeaponBallisticsBenchmark(
+	TEXT("Weapon.Ballistics.Benchmark"),
+	TEXT("Time the single, batched and trial throw ballistic solves. Optional arguments: pairs per batch (default 1024), passes (default 200)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FThrowingWeaponBallisticsChecks::Benchmark));
+
+#endif
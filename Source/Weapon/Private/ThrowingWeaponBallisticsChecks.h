@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThrowingWeaponBallistics.h"
+
+/// <summary>
+/// Weapon.Ballistics.Benchmark and the helpers of the Weapon.Ballistics automation tests, none of them needs a world
+/// </summary>
+struct FThrowingWeaponBallisticsChecks
+{
+	static void Benchmark(const TArray<FString>& args); // Nanoseconds per solve of the single, batched and trial throw paths
+
+	static double GetMiss(const FThrowingWeaponBallisticQuery& query, float speed, float gravityZ, const FThrowingWeaponBallisticSolution& solution); // Distance between the weapon and the target at the solved time
+
+	static bool SolveByTrialThrows(const FVector& start, const FVector& target, float speed, float gravityZ, FVector& outDirection); // The iterative reference: bisect the pitch of stepped throws
+
+	static void MakeQueries(int32 numQueries, bool bMoving, TArray<FThrowingWeaponBallisticQuery>& outQueries); // Random shooter/target pairs around the origin
+
+	template<typename FunctionType>
+	static double TimeNanosecondsPerCall(int32 iterations, FunctionType&& function); // Run function(i) for every iteration
+};
+
+#endif
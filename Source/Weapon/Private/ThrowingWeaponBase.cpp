@@ -6,12 +6,36 @@
 #include "Kismet/GameplayStatics.h"
 #include "Camera/CameraComponent.h"
 #include "PlayerCharacter/Public/PlayerCharacterBase.h"
+#include "DefaultThrowingWeapon.h"
+#include "ThrowingWeaponSubsystem.h"
+#include "ThrowingWeaponSignificanceSubsystem.h"
+#include "WeaponTraceDiagnostics.h"
+#include "WeaponStats.h"
+#include "ThrowingWeaponSimulation.h"
+#include "ThrowingWeaponBallistics.h"
+#include "WeaponThrowLatency.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/DamageType.h"
+#include "HAL/IConsoleManager.h"
+#include "ThrowingWeaponArchetype.h"
+#include "ThrowingWeaponArchetypeSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Curves/CurveFloat.h"
+
+static int32 GThrowingWeaponLowLatencyThrow = -1;
+static FAutoConsoleVariableRef CVarThrowingWeaponLowLatencyThrow(
+	TEXT("Weapon.Throw.LowLatency"),
+	GThrowingWeaponLowLatencyThrow,
+	TEXT("Tick throwing weapons after their owner's controller so a throw flies the frame its input is processed. -1: per weapon setting, 0: off, 1: on"));
 
 // Sets default values
 AThrowingWeaponBase::AThrowingWeaponBase()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+ 	// Tick only runs the state machine, so it is switched on while the weapon is launched, wiggling or returning
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	/// <summary>
 	/// Normal components
@@ -30,87 +54,168 @@ AThrowingWeaponBase::AThrowingWeaponBase()
 
 	ProjectileMovementComponent = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("Projectile Movement"));
 
-	/// <summary>
-	/// Timelines
-	/// </summary>
-	
-	// Throwing weapon rotation timeline
-	TLThrowingWeaponRotationForwardComponent = CreateDefaultSubobject<UTimelineComponent>(TEXT("Weapon Rotation Forward"));
-	ThrowingWeaponRotationForwardInterpFunction.BindUFunction(this, FName("TLThrowingWeaponRotationForwardFloatUpdate"));
-	ThrowingWeaponRotationForwardTimelineFinished.BindUFunction(this, FName("TLThrowingWeaponRotationForwardFinished"));
+	WeaponThrowTraceDistance = 60;
+	bUseContinuousThrowCollision = true;
+	ContinuousCollisionInflation = 0;
+	ContinuousCollisionMaxStepTime = FThrowingWeaponSimulation::DefaultMaxSweepStepTime;
+	bUseAsyncThrowTrace = false;
+	bUseBatchedSimulation = false;
+	bUseLowLatencyThrow = false;
+	ReturnPathCurvature = 0.25f;
+	ReturnPlayRate = 1;
+	StateTime = 0;
+	ReturnTime = 0;
+	BatchedSimulationIndex = INDEX_NONE;
+	BatchedSimulationState = ThrowingWeaponState::Idle;
+	ThrowingWeaponSubsystem = nullptr;
+	AsyncThrowTraceSubmitCycles = 0;
+	bIsAsyncThrowTraceRunning = false;
+	bIsImpactPending = false;
+	bIsArchetypeReady = false;
+	ThrowImpactDamage = 0;
+	ThrowImpactSound = nullptr;
+}
+
+// Called when the game starts or when spawned
+void AThrowingWeaponBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The owning player may already be set, otherwise the weapon belongs to the local player
+	if (PlayerReference == nullptr)
+	{
+		PlayerReference = Cast<APlayerCharacterBase>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
+	}
+	ThrowingWeaponSubsystem = UWorld::GetSubsystem<UThrowingWeaponSubsystem>(GetWorld());
 
-	// Throw curve timeline (i.e gravitation)
-	TLWeaponThrowTraceComponent = CreateDefaultSubobject<UTimelineComponent>(TEXT("Throwing Weapon Airtime"));
-	WeaponThrowTraceInterpFunction.BindUFunction(this, FName("TLWeaponThrowTraceFloatUpdate"));
-	WeaponThrowTraceTimelineFinished.BindUFunction(this, FName("TLWeaponThrowTraceFinished"));
+	ThrowTraceQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(ThrowingWeaponTrace), true, this);
+	ThrowTraceQueryParams.AddIgnoredActor(PlayerReference);
 
-	// Throwing weapon return timeline
-	TLThrowingWeaponReturnComponent = CreateDefaultSubobject<UTimelineComponent>(TEXT("Axe Return Time"));
-	ThrowingWeaponReturnTickEvent.BindUFunction(this, FName("TLCalculateThrowingWeaponReturnPosition"));
-	ThrowingWeaponReturnFinished.BindUFunction(this, FName("TLThrowingWeaponReturnFinished"));
+	// Constant tables until the variant's curves are in memory
+	BakeCurves(nullptr, nullptr, nullptr);
+	RequestArchetype();
 
-	// Throwing weapon wiggle timeline
-	TLWiggleThrowingWeaponComponent = CreateDefaultSubobject<UTimelineComponent>(TEXT("Wiggle Axe Time"));
-	WiggleLodgedThrowingWeaponInterpFunction.BindUFunction(this, FName("TLWiggleLodgedThrowingWeaponFloatUpdate"));
-	WiggleLodgedThrowingWeaponTimelineFinished.BindUFunction(this, FName("TLWiggleLodgedThrowingWeaponFinished"));
+	SetUseBatchedSimulation(bUseBatchedSimulation);
 
+	if (UThrowingWeaponSignificanceSubsystem* significanceSubsystem = UWorld::GetSubsystem<UThrowingWeaponSignificanceSubsystem>(GetWorld()))
+	{
+		significanceSubsystem->RegisterActor(this);
+	}
 }
 
-// Called when the game starts or when spawned
-void AThrowingWeaponBase::BeginPlay()
+// Called when the weapon is destroyed or the level ends
+void AThrowingWeaponBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::BeginPlay();
+	TrackActiveWeapon(CurrentThrowingWeaponState, ThrowingWeaponState::Idle);
+	ReleaseArchetype();
+
+	if (UThrowingWeaponSubsystem* throwingWeaponSubsystem = UWorld::GetSubsystem<UThrowingWeaponSubsystem>(GetWorld()))
+	{
+		throwingWeaponSubsystem->RemoveWeapon(this);
+	}
+
+	if (UThrowingWeaponSignificanceSubsystem* significanceSubsystem = UWorld::GetSubsystem<UThrowingWeaponSignificanceSubsystem>(GetWorld()))
+	{
+		significanceSubsystem->UnregisterActor(this);
+	}
 
-	PlayerReference = Cast<APlayerCharacterBase>(UGameplayStatics::GetPlayerCharacter(GetWorld(), 0));
-	
+	Super::EndPlay(EndPlayReason);
 }
 
-// Called every frame
+// Called every frame while the throwing weapon is launched, wiggling or returning
 void AThrowingWeaponBase::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	switch (CurrentThrowingWeaponState)
+	{
+	case ThrowingWeaponState::Launched:
+		UpdateLaunchedThrowingWeapon(DeltaTime);
+		break;
+
+	case ThrowingWeaponState::Wiggle:
+		UpdateWiggleThrowingWeapon(DeltaTime);
+		break;
+
+	case ThrowingWeaponState::Returning:
+		UpdateReturningThrowingWeapon(DeltaTime);
+		break;
+
+	default:
+		SetActorTickEnabled(false);
+		break;
+	}
 }
-// Start the timeline for rotating the throwing weapon forward
-void AThrowingWeaponBase::StartThrowingWeaponRotationForward()
+// Switch between batched and per actor simulation while the weapon is Idle
+void AThrowingWeaponBase::SetUseBatchedSimulation(bool bNewUseBatchedSimulation)
 {
-	if (TLThrowingWeaponRotationForward_Curve)
-	{		
-		TLThrowingWeaponRotationForwardComponent->AddInterpFloat(TLThrowingWeaponRotationForward_Curve, ThrowingWeaponRotationForwardInterpFunction, FName("Rotation"));		
+	if (CurrentThrowingWeaponState != ThrowingWeaponState::Idle)
+	{
+		return;
+	}
+
+	bUseBatchedSimulation = bNewUseBatchedSimulation;
+
+	if (HasActorBegunPlay() && bUseBatchedSimulation)
+	{
+		// The subsystem moves a batched weapon, nothing on the actor itself needs to tick
+		SetActorTickEnabled(false);
+		ProjectileMovementComponent->Deactivate();
 	}
-	TLThrowingWeaponRotationForwardComponent->SetPlayRate(ThrowingWeaponSpinRate);
-	TLThrowingWeaponRotationForwardComponent->SetTimelineFinishedFunc(ThrowingWeaponRotationForwardTimelineFinished);
-	TLThrowingWeaponRotationForwardComponent->SetLooping(false);
-	TLThrowingWeaponRotationForwardComponent->PlayFromStart();
 }
-// Stops the throwing weapon forward rotation
-void AThrowingWeaponBase::StopThrowingWeaponRotation()
+// Start spinning the throwing weapon forward
+void AThrowingWeaponBase::StartThrowingWeaponRotationForward()
 {
-	TLThrowingWeaponRotationForwardFinished();
+	StateTime = 0;
 }
 // Launch the throwing weapon
 void AThrowingWeaponBase::ThrowWeapon(FRotator cameraRotation, FVector throwDirection, FVector cameraLocation, const float throwSpeed)
 {
+	WEAPON_PROFILE_SCOPE(STAT_WeaponThrow);
+
 	StartCameraRotation = cameraRotation;
 	ThrowDirection = throwDirection;
 	CameraLocationAtThrow = cameraLocation;
 
-	if (TLWeaponThrowTrace_Curve != nullptr)
+	UpdateLowLatencyTickOrder();
+
+	SnapThrowingWeaponToStartPosition();
+	LaunchThrowingWeapon();
+
+	WEAPON_THROW_LATENCY_THROW(this);
+}
+// Tick after the owner's controller while the low latency throw is on. The input that throws is processed in the controller's
+// tick, so the weapon's first flight step (newly enabled ticks still run this frame) comes after it instead of a frame later
+void AThrowingWeaponBase::UpdateLowLatencyTickOrder()
+{
+	const bool bLowLatency = GThrowingWeaponLowLatencyThrow < 0 ? bUseLowLatencyThrow : GThrowingWeaponLowLatencyThrow != 0;
+
+	AActor* controller = bLowLatency && PlayerReference != nullptr ? PlayerReference->GetController() : nullptr;
+
+	if (controller == LowLatencyTickPrerequisite.Get())
 	{
-		TLWeaponThrowTraceComponent->AddInterpFloat(TLWeaponThrowTrace_Curve, WeaponThrowTraceInterpFunction, FName("Axe Throw Trace Time"));		
+		return;
 	}
 
-	TLWeaponThrowTraceComponent->SetTimelineFinishedFunc(WeaponThrowTraceTimelineFinished);
-	TLWeaponThrowTraceComponent->SetLooping(true);
+	if (AActor* oldController = LowLatencyTickPrerequisite.Get())
+	{
+		RemoveTickPrerequisiteActor(oldController);
+		ProjectileMovementComponent->RemoveTickPrerequisiteActor(oldController);
+	}
 
-	SnapThrowingWeaponToStartPosition();
-	TLWeaponThrowTraceComponent->PlayFromStart();
-	LaunchThrowingWeapon();
+	if (controller != nullptr)
+	{
+		AddTickPrerequisiteActor(controller);
+		ProjectileMovementComponent->AddTickPrerequisiteActor(controller);
+	}
+
+	LowLatencyTickPrerequisite = controller;
 }
 // Return the throwing weapon to player
 void AThrowingWeaponBase::RecallThrowingWeapon()
 {
-	TLStopWeaponThrowTrace();
+	WEAPON_PROFILE_SCOPE(STAT_WeaponRecall);
+
 	ThrowingWeaponMeshComponent->SetVisibility(true, false);
 	ThrowingWeaponMeshComponent->SetRelativeRotation(FRotator(0, 0, 0));
 	AdjustThrowingWeaponReturnLocation();
@@ -119,120 +224,597 @@ void AThrowingWeaponBase::RecallThrowingWeapon()
 	{
 	case ThrowingWeaponState::Launched:
 
-		CurrentThrowingWeaponState = ThrowingWeaponState::Returning;
-
+		ProjectileMovementComponent->Deactivate();
 		ReturnPosition();
-		StopThrowingWeaponRotation();
+
+		SetThrowingWeaponState(ThrowingWeaponState::Returning);
 		PivotPointComponent->SetRelativeRotation(FRotator(0, 0, 0));
 		break;
 
 
 	case ThrowingWeaponState::Lodged:
-		WiggleLodgedThrowingWeapon();
-		GetWorld()->GetTimerManager().SetTimer(ThrowingWeaponReturnDelay, this, &AThrowingWeaponBase::ResetThrowingWeaponReturnDelay, 0.2, false);
 		ReturnPosition();
+		WiggleLodgedThrowingWeapon();
 		break;
 
 	}
 }
-// The timeline update for rotating the throwing weapon forward
-void AThrowingWeaponBase::TLThrowingWeaponRotationForwardFloatUpdate(float value)
+// Spin forward along the rotation curve and look for an impact
+void AThrowingWeaponBase::UpdateLaunchedThrowingWeapon(float deltaTime)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponUpdateLaunched);
+
+	StateTime = FThrowingWeaponSimulation::AdvanceSpin(StateTime, deltaTime, ThrowingWeaponSpinRate, SpinCurveTable->GetEndTime());
+
+	const float spin = SpinCurveTable->Evaluate(StateTime);
+	PivotPointComponent->SetRelativeRotation(FRotator(spin * ThrowingWeaponRotationMultiplier, 0, 0), false, nullptr);
+
+	FHitResult HitResult;
+	if (!bIsImpactPending && TraceThrowingWeaponFlight(ProjectileMovementComponent->Velocity, HitResult))
+	{
+		PublishThrowingWeaponImpact(HitResult, ProjectileMovementComponent->Velocity);
+	}
+}
+// Wiggle the lodged throwing weapon loose along the wiggle curve while the return already starts
+void AThrowingWeaponBase::UpdateWiggleThrowingWeapon(float deltaTime)
 {
-	PivotPointComponent->SetRelativeRotation(FRotator(value * ThrowingWeaponRotationMultiplier, 0, 0), false, false);
+	WEAPON_PROFILE_SCOPE(STAT_WeaponUpdateWiggle);
+
+	StateTime += deltaTime * FThrowingWeaponSimulation::WigglePlayRate;
+
+	LodgePointComponent->SetRelativeRotation(FThrowingWeaponSimulation::CalculateWiggleRotation(LodgePointBaseRotation, WiggleCurveTable->Evaluate(StateTime)));
+
+	if (AdvanceThrowingWeaponReturn(deltaTime))
+	{
+		ThrowingWeaponReturnFinished();
+	}
+	else if (StateTime >= WiggleCurveTable->GetEndTime())
+	{
+		ThrowingWeaponWiggleFinished();
+	}
 }
-// The Timeline finished for rotating the throwing weapon forward
-void AThrowingWeaponBase::TLThrowingWeaponRotationForwardFinished()
+// Move the returning throwing weapon towards the player
+void AThrowingWeaponBase::UpdateReturningThrowingWeapon(float deltaTime)
 {
-	TLThrowingWeaponRotationForwardComponent->Stop();
+	WEAPON_PROFILE_SCOPE(STAT_WeaponUpdateReturning);
+
+	if (AdvanceThrowingWeaponReturn(deltaTime))
+	{
+		ThrowingWeaponReturnFinished();
+	}
 }
-// The timeline update for throwing weapon trajectory and collision
-void AThrowingWeaponBase::TLWeaponThrowTraceFloatUpdate(float value)
+// Move along the return speed curve, true once the curve is finished
+bool AThrowingWeaponBase::AdvanceThrowingWeaponReturn(float deltaTime)
 {
-	float WeaponThrowTraceDistance = 60;
-	FVector start = GetActorLocation();
-	FVector end = ((GetActorForwardVector() * WeaponThrowTraceDistance) + start);
+	ReturnTime += deltaTime * ReturnPlayRate;
 
-	FHitResult HitResult;
-	TArray<AActor*> ActorsToIgnore;
-	bool bHit = UKismetSystemLibrary::LineTraceSingle(this, start, end, UEngineTypes::ConvertToTraceType(ECC_Visibility),
-		true, ActorsToIgnore, EDrawDebugTrace::ForDuration, HitResult, true, FLinearColor::Yellow, FLinearColor::Red, 1);
+	const float curveEndTime = ReturnSpeedCurveTable->GetEndTime();
+	CalculateThrowingWeaponReturn(FThrowingWeaponSimulation::CalculateReturnAlpha(ReturnSpeedCurveTable->Evaluate(ReturnTime), ReturnTime, curveEndTime));
+
+	return FThrowingWeaponSimulation::IsReturnFinished(ReturnTime, curveEndTime);
+}
+// The lodged throwing weapon is loose, keep returning
+void AThrowingWeaponBase::ThrowingWeaponWiggleFinished()
+{
+	SetThrowingWeaponState(ThrowingWeaponState::Returning);
+}
+// The throwing weapon is back at the player
+void AThrowingWeaponBase::ThrowingWeaponReturnFinished()
+{
+	ProjectileMovementComponent->Deactivate();
 
-	if (bHit)
+	bIsThrowingWeaponReturnDelayFinished = true;
+
+	// Only the player's own weapon is caught, any other weapon just stops where it arrived
+	if (PlayerReference != nullptr && PlayerReference->GetDefaultThrowingWeapon() == this)
+	{
+		PlayerReference->CatchThrowingWeapon();
+	}
+	else
+	{
+		SetThrowingWeaponState(ThrowingWeaponState::Idle);
+	}
+}
+// Trace for impacts with the configured collision mode
+bool AThrowingWeaponBase::TraceThrowingWeaponFlight(FVector velocity, FHitResult& hitResult)
+{
+	// Async traces are submitted by the subsystem, without one the weapon always traces right away
+	if (bUseAsyncThrowTrace && ThrowingWeaponSubsystem != nullptr)
 	{
-		ImpactLocation = HitResult.ImpactPoint;
-		ImpactNormal = HitResult.ImpactNormal;
+		return TraceThrowingWeaponFlightAsync(velocity, hitResult);
+	}
+	return TraceThrowingWeaponFlightSync(velocity, hitResult);
+}
+// Trace right now on the game thread
+bool AThrowingWeaponBase::TraceThrowingWeaponFlightSync(FVector velocity, FHitResult& hitResult)
+{
+	WEAPON_PROFILE_SCOPE(STAT_ThrowTraceSync);
+	const uint64 startCycles = FPlatformTime::Cycles64();
 
-		ProjectileMovementComponent->Deactivate();
+	const bool bHit = bUseContinuousThrowCollision ? SweepThrowingWeaponFlight(velocity, hitResult) : LineTraceThrowingWeaponFlight(hitResult);
 
-		TLStopWeaponThrowTrace();
+	// The subsystem compares this against the async cost for the time saved stat
+	if (ThrowingWeaponSubsystem != nullptr)
+	{
+		ThrowingWeaponSubsystem->RecordSyncFlightTrace(FPlatformTime::Cycles64() - startCycles);
+	}
+	return bHit;
+}
+// Use last frame's async result and queue this frame's trace. The launch frame and lost results trace synchronously, so a result is never more than one frame old
+bool AThrowingWeaponBase::TraceThrowingWeaponFlightAsync(FVector velocity, FHitResult& hitResult)
+{
+	// Nothing was submitted before the launch frame, trace right away so point blank throws still lodge
+	if (!bIsAsyncThrowTraceRunning)
+	{
+		bIsAsyncThrowTraceRunning = true;
+		return TraceThrowingWeaponFlightSync(velocity, hitResult);
+	}
 
-		LodgeThrowingWeapon();
+	if (AsyncThrowTraceHandles.Num() > 0)
+	{
+		WEAPON_PROFILE_SCOPE(STAT_ThrowTraceAsyncConsume);
+		const uint64 startCycles = FPlatformTime::Cycles64();
+
+		// The segments are in flight order, so the first blocking hit is the impact
+		FTraceDatum traceDatum;
+		bool bHasResult = true;
+		bool bHit = false;
+		for (const FTraceHandle& traceHandle : AsyncThrowTraceHandles)
+		{
+			bHasResult = GetWorld()->QueryTraceData(traceHandle, traceDatum);
+			bHit = bHasResult && traceDatum.OutHits.Num() > 0 && traceDatum.OutHits[0].bBlockingHit;
+
+			if (!bHasResult || bHit)
+			{
+				break;
+			}
+		}
+		AsyncThrowTraceHandles.Reset();
+
+		if (!bHasResult)
+		{
+			// The world only keeps async results for one frame, trace the lost segment again now
+			ThrowingWeaponSubsystem->RecordAsyncFlightTrace(FPlatformTime::Cycles64() - startCycles, 0, true);
+
+			if (bUseContinuousThrowCollision)
+			{
+				PreviousThrowTraceSample = AsyncThrowTraceStart;
+			}
+			return TraceThrowingWeaponFlightSync(velocity, hitResult);
+		}
+
+		if (bHit)
+		{
+			hitResult = traceDatum.OutHits[0];
+		}
+
+		WEAPON_TRACE_DIAGNOSTICS_RECORD_ASYNC(GetWorld(), traceDatum.Start, traceDatum.End, hitResult, bHit, bUseContinuousThrowCollision, AsyncThrowTraceSubmitCycles);
+
+		ThrowingWeaponSubsystem->RecordAsyncFlightTrace(FPlatformTime::Cycles64() - startCycles, FPlatformTime::ToSeconds64(startCycles - AsyncThrowTraceSubmitCycles), false);
+
+		if (bHit)
+		{
+			return true;
+		}
 	}
+
+	QueueAsyncThrowTrace(velocity);
+	return false;
 }
-// Timeline for finished throwing weapon trajectory
-void AThrowingWeaponBase::TLWeaponThrowTraceFinished()
-{	
-	ProjectileMovementComponent->Deactivate();
-	StopThrowingWeaponRotation();
+// Queue this frame's trace, the subsystem submits every queued trace together once per frame
+void AThrowingWeaponBase::QueueAsyncThrowTrace(FVector velocity)
+{
+	FThrowingWeaponFlightTrace trace;
+	trace.Weapon = this;
+	trace.bSwept = bUseContinuousThrowCollision;
+
+	if (bUseContinuousThrowCollision)
+	{
+		// Same segments the sync sweep would use
+		const FThrowingWeaponFlightSample currentSample = MakeThrowTraceSample(velocity);
 
-	ThrowingWeaponMeshComponent->SetVisibility(false);
+		FThrowingWeaponSimulation::BuildSweepPath(PreviousThrowTraceSample, currentSample, ContinuousCollisionMaxStepTime, WeaponThrowTraceDistance, trace.Path);
+		trace.Rotation = ThrowingWeaponMeshComponent->GetComponentQuat();
+		trace.Shape = GetThrowSweepShape();
+
+		AsyncThrowTraceStart = PreviousThrowTraceSample;
+		PreviousThrowTraceSample = currentSample;
+	}
+	else
+	{
+		const FVector start = GetActorLocation();
+		trace.Path.Add(start);
+		trace.Path.Add((GetActorForwardVector() * WeaponThrowTraceDistance) + start);
+	}
+
+	ThrowingWeaponSubsystem->QueueFlightTrace(trace);
+}
+// Trace a fixed distance ahead of the throwing weapon
+bool AThrowingWeaponBase::LineTraceThrowingWeaponFlight(FHitResult& hitResult)
+{
+	const FVector start = GetActorLocation();
+	const FVector end = ((GetActorForwardVector() * WeaponThrowTraceDistance) + start);
+
+	WEAPON_TRACE_DIAGNOSTICS_BEGIN(traceStartCycles);
+
+	bool bHit = GetWorld()->LineTraceSingleByChannel(hitResult, start, end, ECC_Visibility, ThrowTraceQueryParams);
+
+	WEAPON_TRACE_DIAGNOSTICS_RECORD(GetWorld(), start, end, hitResult, bHit, false, traceStartCycles);
+
+	return bHit;
+}
+// Sweep the throwing weapon shape over everything it passed through since the last trace. A frame longer than ContinuousCollisionMaxStepTime
+// is split into one sweep per step along the arc (a single sweep while the frame rate keeps up), the last one adds the look-ahead
+bool AThrowingWeaponBase::SweepThrowingWeaponFlight(FVector velocity, FHitResult& hitResult)
+{
+	const FThrowingWeaponFlightSample currentSample = MakeThrowTraceSample(velocity);
+
+	FThrowingWeaponSweepPath path;
+	FThrowingWeaponSimulation::BuildSweepPath(PreviousThrowTraceSample, currentSample, ContinuousCollisionMaxStepTime, WeaponThrowTraceDistance, path);
+
+	PreviousThrowTraceSample = currentSample;
+
+	return SweepThrowPath(GetWorld(), path, ThrowingWeaponMeshComponent->GetComponentQuat(), GetThrowSweepShape(), ThrowTraceQueryParams, hitResult);
+}
+// Sweep a shape segment by segment along a path, stopping at the first blocking hit
+bool AThrowingWeaponBase::SweepThrowPath(const UWorld* world, const FThrowingWeaponSweepPath& path, const FQuat& rotation, const FCollisionShape& shape, const FCollisionQueryParams& queryParams, FHitResult& hitResult)
+{
+	bool bHit = false;
+	for (int32 i = 1; i < path.Num() && !bHit; i++)
+	{
+		WEAPON_TRACE_DIAGNOSTICS_BEGIN(traceStartCycles);
+
+		bHit = world->SweepSingleByChannel(hitResult, path[i - 1], path[i], rotation, ECC_Visibility, shape, queryParams);
+
+		WEAPON_TRACE_DIAGNOSTICS_RECORD(world, path[i - 1], path[i], hitResult, bHit, true, traceStartCycles);
+	}
+	return bHit;
+}
+// Where the swept shape is now, the next sweep starts from it
+FThrowingWeaponFlightSample AThrowingWeaponBase::MakeThrowTraceSample(FVector velocity) const
+{
+	FThrowingWeaponFlightSample sample;
+	sample.Location = ThrowingWeaponMeshComponent->Bounds.Origin;
+	sample.Velocity = velocity;
+	sample.Time = GetWorld()->GetTimeSeconds();
+	return sample;
 }
-// Immediately stop the throwing weapon movement
-void AThrowingWeaponBase::TLStopWeaponThrowTrace()
+// Box of the mesh's local bounds, swept with the mesh rotation. The world bounds box grows and shrinks as the weapon spins, this one fits the blade at any angle
+FCollisionShape AThrowingWeaponBase::GetThrowSweepShape() const
 {
-	TLWeaponThrowTraceComponent->Stop();
+	return MakeThrowSweepShape(ThrowingWeaponMeshComponent, ContinuousCollisionInflation);
 }
-// Handle the return position based on the return speed curve
-void AThrowingWeaponBase::TLCalculateThrowingWeaponReturnPosition()
+// Box of a mesh's scaled local bounds grown (or shrunk) by inflation, to be swept with the mesh rotation
+FCollisionShape AThrowingWeaponBase::MakeThrowSweepShape(const UStaticMeshComponent* meshComponent, float inflation)
 {
-	CalculateThrowingWeaponReturn(		
-		TLThrowingWeaponReturnSpeed_Curve->GetFloatValue(TLThrowingWeaponReturnComponent->GetPlaybackPosition())		
-	);
+	const FVector localExtent = meshComponent->CalcLocalBounds().BoxExtent * meshComponent->GetComponentScale().GetAbs();
+
+	return FCollisionShape::MakeBox((localExtent + inflation).ComponentMax(FVector::ZeroVector));
 }
-// Timeline for finished throwing weapon return
-void AThrowingWeaponBase::TLThrowingWeaponReturnFinished()
+// Hand the impact to the subsystem, which lodges every weapon that hit something this frame in one pass. Worlds without one lodge right away
+void AThrowingWeaponBase::PublishThrowingWeaponImpact(const FHitResult& hitResult, FVector velocity)
 {
+	if (bIsImpactPending)
+	{
+		return;
+	}
+
+	if (ThrowingWeaponSubsystem != nullptr)
+	{
+		bIsImpactPending = true;
+		ThrowingWeaponSubsystem->PublishImpact(this, hitResult, velocity);
+		return;
+	}
+
+	HandleThrowingWeaponImpact(hitResult, velocity);
+	ApplyThrowingWeaponImpactEffects(hitResult, velocity);
+}
+// Stop the flight and lodge the throwing weapon where it hit
+void AThrowingWeaponBase::HandleThrowingWeaponImpact(const FHitResult& hitResult, FVector velocity)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponImpact);
+
+	bIsImpactPending = false;
+
+	ImpactLocation = hitResult.ImpactPoint;
+	ImpactNormal = hitResult.ImpactNormal;
+
+	ProjectileMovementComponent->Velocity = velocity;
 	ProjectileMovementComponent->Deactivate();
-	StopThrowingWeaponRotation();
 
-	PlayerReference->CatchThrowingWeapon();
-	bIsThrowingWeaponReturnDelayFinished = true;
+	LodgeThrowingWeapon();
+}
+// Damage whatever was hit (only the server deals damage) and play the impact effects
+void AThrowingWeaponBase::ApplyThrowingWeaponImpactEffects(const FHitResult& hitResult, FVector velocity)
+{
+	AActor* hitActor = hitResult.GetActor();
+	if (ThrowImpactDamage > 0 && hitActor != nullptr && HasAuthority())
+	{
+		AController* instigator = PlayerReference != nullptr ? PlayerReference->GetController() : nullptr;
+		UGameplayStatics::ApplyPointDamage(hitActor, ThrowImpactDamage, velocity.GetSafeNormal(), hitResult, instigator, this, ThrowImpactDamageType);
+	}
+
+	if (ThrowImpactSound != nullptr)
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, ThrowImpactSound, hitResult.ImpactPoint);
+	}
+
+	OnThrowingWeaponImpact.Broadcast(this, hitResult);
+}
+// Change state and move the weapon to the matching subsystem batch when it is batched
+void AThrowingWeaponBase::SetThrowingWeaponState(ThrowingWeaponState newState)
+{
+	TrackActiveWeapon(CurrentThrowingWeaponState, newState);
+
+	CurrentThrowingWeaponState = newState;
+
+	if (bUseBatchedSimulation)
+	{
+		if (UThrowingWeaponSubsystem* throwingWeaponSubsystem = UWorld::GetSubsystem<UThrowingWeaponSubsystem>(GetWorld()))
+		{
+			throwingWeaponSubsystem->SetWeaponState(this, newState);
+		}
+	}
+	else
+	{
+		// Idle and Lodged weapons have nothing to update
+		SetActorTickEnabled(newState == ThrowingWeaponState::Launched || newState == ThrowingWeaponState::Wiggle || newState == ThrowingWeaponState::Returning);
+	}
+
+	// A throw or recall shouldn't wait for the next significance update to get its tick rate
+	if (UThrowingWeaponSignificanceSubsystem* significanceSubsystem = UWorld::GetSubsystem<UThrowingWeaponSignificanceSubsystem>(GetWorld()))
+	{
+		significanceSubsystem->RefreshActor(this);
+	}
+
+	OnThrowingWeaponStateChanged.Broadcast(this, newState);
 }
-// Timeline for updating the lodged throwing weapon wiggle
-void AThrowingWeaponBase::TLWiggleLodgedThrowingWeaponFloatUpdate(float value)
+// Load a weapon variant in the background and swap it on when it is ready
+void AThrowingWeaponBase::SetArchetype(const TSoftObjectPtr<UThrowingWeaponArchetype>& newArchetype)
 {
-	LodgePointComponent->SetRelativeRotation(FRotator(LodgePointBaseRotation.Pitch + value * -30, LodgePointBaseRotation.Yaw, LodgePointBaseRotation.Roll));
+	if (newArchetype == Archetype)
+	{
+		return;
+	}
+
+	ReleaseArchetype();
+	Archetype = newArchetype;
+
+	// Until then the weapon keeps the variant it has
+	if (HasActorBegunPlay())
+	{
+		RequestArchetype();
+	}
+}
+// Load Archetype (or the weapon's own curves without one) and apply it when ready
+void AThrowingWeaponBase::RequestArchetype()
+{
+	bIsArchetypeReady = false;
+
+	if (!Archetype.IsNull())
+	{
+		RequestedArchetype = Archetype;
+
+		UGameInstance* gameInstance = GetGameInstance();
+		if (UThrowingWeaponArchetypeSubsystem* archetypeSubsystem = gameInstance != nullptr ? gameInstance->GetSubsystem<UThrowingWeaponArchetypeSubsystem>() : nullptr)
+		{
+			archetypeSubsystem->RequestArchetype(Archetype, FOnThrowingWeaponArchetypeLoaded::CreateUObject(this, &AThrowingWeaponBase::ApplyArchetype));
+		}
+		else
+		{
+			// Worlds without a game instance (editor previews) have nobody to share the load with
+			ApplyArchetype(Archetype.LoadSynchronous());
+		}
+		return;
+	}
+
+	TArray<FSoftObjectPath> curvePaths;
+	for (const TSoftObjectPtr<UCurveFloat>* curve : { &TLThrowingWeaponRotationForward_Curve, &TLThrowingWeaponReturnSpeed_Curve, &TLWiggleThrowingWeapon_Curve })
+	{
+		if (!curve->IsNull())
+		{
+			curvePaths.Add(curve->ToSoftObjectPath());
+		}
+	}
+
+	auto curvesLoaded = [this]()
+	{
+		BakeCurves(TLThrowingWeaponRotationForward_Curve.Get(), TLThrowingWeaponReturnSpeed_Curve.Get(), TLWiggleThrowingWeapon_Curve.Get());
+		bIsArchetypeReady = true;
+
+		// Only the tables are read from here on, the curve assets can be unloaded
+		CurvesHandle.Reset();
+	};
+
+	if (curvePaths.Num() == 0)
+	{
+		curvesLoaded();
+		return;
+	}
+
+	CurvesHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(curvePaths, FStreamableDelegate::CreateWeakLambda(this, curvesLoaded));
+}
+// Stop keeping the current variant in memory for this weapon
+void AThrowingWeaponBase::ReleaseArchetype()
+{
+	if (!RequestedArchetype.IsNull())
+	{
+		UGameInstance* gameInstance = GetGameInstance();
+		if (UThrowingWeaponArchetypeSubsystem* archetypeSubsystem = gameInstance != nullptr ? gameInstance->GetSubsystem<UThrowingWeaponArchetypeSubsystem>() : nullptr)
+		{
+			archetypeSubsystem->ReleaseArchetype(RequestedArchetype);
+		}
+		RequestedArchetype.Reset();
+	}
+
+	if (CurvesHandle.IsValid())
+	{
+		CurvesHandle->CancelHandle();
+		CurvesHandle.Reset();
+	}
+}
+// Swap the loaded mesh and curves onto the weapon
+void AThrowingWeaponBase::ApplyArchetype(UThrowingWeaponArchetype* archetype)
+{
+	// A variant that finished loading after the weapon already moved on to another one
+	if (archetype != nullptr && FSoftObjectPath(archetype) != RequestedArchetype.ToSoftObjectPath())
+	{
+		return;
+	}
+
+	if (archetype != nullptr)
+	{
+		if (UStaticMesh* mesh = archetype->Mesh.Get())
+		{
+			ThrowingWeaponMeshComponent->SetStaticMesh(mesh);
+		}
+
+		BakeCurves(archetype->RotationForwardCurve.Get(), archetype->ReturnSpeedCurve.Get(), archetype->WiggleCurve.Get());
+	}
+
+	bIsArchetypeReady = true;
+}
+// Shared tables of the curves (sampled once per asset), constant ones for missing curves
+void AThrowingWeaponBase::BakeCurves(const UCurveFloat* rotationForwardCurve, const UCurveFloat* returnSpeedCurve, const UCurveFloat* wiggleCurve)
+{
+	SpinCurveTable = FBakedCurve::FindOrBake(rotationForwardCurve, 0);
+	ReturnSpeedCurveTable = FBakedCurve::FindOrBake(returnSpeedCurve, 1);
+	WiggleCurveTable = FBakedCurve::FindOrBake(wiggleCurve, 0);
+
+	// A batched weapon still points at the old tables
+	if (ThrowingWeaponSubsystem != nullptr && BatchedSimulationIndex != INDEX_NONE)
+	{
+		ThrowingWeaponSubsystem->RefreshWeaponCurves(this);
+	}
+}
+// Count weapons that left Idle for "stat Weapon" and the Insights counter track
+void AThrowingWeaponBase::TrackActiveWeapon(ThrowingWeaponState oldState, ThrowingWeaponState newState)
+{
+#if WITH_WEAPON_PROFILING
+	const bool bWasActive = oldState != ThrowingWeaponState::Idle;
+	const bool bIsActive = newState != ThrowingWeaponState::Idle;
+
+	if (bIsActive && !bWasActive)
+	{
+		INC_DWORD_STAT(STAT_WeaponActive);
+		TRACE_COUNTER_INCREMENT(WeaponActiveCounter);
+	}
+	else if (bWasActive && !bIsActive)
+	{
+		DEC_DWORD_STAT(STAT_WeaponActive);
+		TRACE_COUNTER_DECREMENT(WeaponActiveCounter);
+	}
+#endif
+}
+// The player the weapon returns to, needed when every player has a weapon (the local player is only right for its own)
+void AThrowingWeaponBase::SetOwningPlayer(APlayerCharacterBase* owningPlayer)
+{
+	ThrowTraceQueryParams.ClearIgnoredActors();
+	ThrowTraceQueryParams.AddIgnoredActor(this);
+	ThrowTraceQueryParams.AddIgnoredActor(owningPlayer);
+
+	PlayerReference = owningPlayer;
+}
+// Match a lodge decided by the server, whatever this weapon predicted
+void AThrowingWeaponBase::ReconcileLodge(FVector actorLocation, FRotator lodgePointRotation)
+{
+	// Still flying (or never thrown) here, stop where the server stopped
+	if (CurrentThrowingWeaponState == ThrowingWeaponState::Launched || CurrentThrowingWeaponState == ThrowingWeaponState::Idle)
+	{
+		ProjectileMovementComponent->Deactivate();
+		PivotPointComponent->SetRelativeRotation(FRotator(0, 0, 0));
+		SetActorRotation(StartCameraRotation);
+
+		SetThrowingWeaponState(ThrowingWeaponState::Lodged);
+	}
+
+	// A weapon that was already recalled here keeps returning
+	if (CurrentThrowingWeaponState == ThrowingWeaponState::Lodged)
+	{
+		SetActorLocation(actorLocation);
+		LodgePointComponent->SetRelativeRotation(lodgePointRotation);
+	}
 }
-// Timeline for finished wiggle 
-void AThrowingWeaponBase::TLWiggleLodgedThrowingWeaponFinished()
+// Relative rotation of the lodge point
+FRotator AThrowingWeaponBase::GetLodgePointRotation() const
 {
-	CurrentThrowingWeaponState = ThrowingWeaponState::Returning;
+	return LodgePointComponent->GetRelativeRotation();
 }
 // Snap the throwing weapon to center of screen (corshair)
 void AThrowingWeaponBase::SnapThrowingWeaponToStartPosition()
 {
 	SetActorLocationAndRotation((ThrowDirection * WeaponThrowDirectionMultiplier + CameraLocationAtThrow) - PivotPointComponent->GetRelativeLocation(), ReturnCameraStartRotation());
 }
+// Where ThrowWeapon would start the flight and how fast, the same math as SnapThrowingWeaponToStartPosition and LaunchThrowingWeapon
+void AThrowingWeaponBase::PredictLaunch(const FVector& throwDirection, const FVector& cameraLocation, FVector& outLocation, FVector& outVelocity, float& outGravityZ) const
+{
+	outLocation = (throwDirection * WeaponThrowDirectionMultiplier + cameraLocation) - PivotPointComponent->GetRelativeLocation();
+	outVelocity = throwDirection * WeaponThrowSpeed;
+	outGravityZ = ProjectileMovementComponent->ShouldApplyGravity() ? GetWorld()->GetGravityZ() * ProjectileMovementComponent->ProjectileGravityScale : 0;
+}
+// ThrowWeapon's throwDirection that hits the (moving) target with WeaponThrowSpeed and the projectile's gravity, false when it is out of reach
+bool AThrowingWeaponBase::SolveThrowDirection(FVector cameraLocation, FVector targetLocation, FVector targetVelocity, bool bHighArc, FVector& outThrowDirection) const
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponBallistics);
+
+	const EThrowingWeaponArc arc = bHighArc ? EThrowingWeaponArc::High : EThrowingWeaponArc::Low;
+
+	// The flight starts ahead of cameraLocation along the throw direction, each pass solves from where the previous direction starts it
+	FVector throwDirection = (targetLocation - cameraLocation).GetSafeNormal();
+	for (int32 pass = 0; pass < 2; pass++)
+	{
+		FVector launchLocation;
+		FVector launchVelocity;
+		float launchGravityZ;
+		PredictLaunch(throwDirection, cameraLocation, launchLocation, launchVelocity, launchGravityZ);
+
+		FThrowingWeaponBallisticSolution solution;
+		if (!FThrowingWeaponBallistics::SolveLeading(launchLocation, targetLocation, targetVelocity, WeaponThrowSpeed, launchGravityZ, arc, solution))
+		{
+			return false;
+		}
+		throwDirection = solution.Direction;
+	}
+
+	outThrowDirection = throwDirection;
+	return true;
+}
+// Line trace against whatever the throw trace hits, ignoring the weapon and its owner
+bool AThrowingWeaponBase::TraceThrowPreview(const FVector& start, const FVector& end, FHitResult& hitResult) const
+{
+	return GetWorld()->LineTraceSingleByChannel(hitResult, start, end, ECC_Visibility, ThrowTraceQueryParams);
+}
 // Launch the throwing weapon
 void AThrowingWeaponBase::LaunchThrowingWeapon()
 {
 	ProjectileMovementComponent->bRotationFollowsVelocity = true;
 
-	CurrentThrowingWeaponState = ThrowingWeaponState::Launched;
-
 	ThrowingWeaponMeshComponent->SetRelativeRotation(FRotator(0, 180, 0));
 
-	ProjectileMovementComponent->Activate();
-
 	ProjectileMovementComponent->Velocity = ThrowDirection * WeaponThrowSpeed;
+	PreviousThrowTraceSample = MakeThrowTraceSample(ProjectileMovementComponent->Velocity);
+	AsyncThrowTraceHandles.Reset();
+	bIsAsyncThrowTraceRunning = false;
+	bIsImpactPending = false;
 
 	StartThrowingWeaponRotationForward();
+
+	if (!bUseBatchedSimulation)
+	{
+		// A batched weapon has its flight integrated by the subsystem instead
+		ProjectileMovementComponent->Activate();
+
+		// Substep the projectile integration so each frame's swept segment stays close to the real arc
+		ProjectileMovementComponent->bForceSubStepping = bUseContinuousThrowCollision;
+		ProjectileMovementComponent->MaxSimulationTimeStep = ContinuousCollisionMaxStepTime;
+	}
+
+	SetThrowingWeaponState(ThrowingWeaponState::Launched);
 }
 // Lodge throwing weapon on impact
 void AThrowingWeaponBase::LodgeThrowingWeapon()
 {
 	ProjectileMovementComponent->Deactivate();
-	StopThrowingWeaponRotation();
 
 	PivotPointComponent->SetRelativeRotation(FRotator(0, 0, 0));
 
@@ -242,7 +824,7 @@ void AThrowingWeaponBase::LodgeThrowingWeapon()
 	FRotator LodgeRotation = ProjectileMovementComponent->Velocity.ToOrientationRotator();
 
 	// Adjust the pitch of the rotation based on the impact normal (The vertical rotation)
-	LodgeRotation.Pitch += AdjustThrowingWeaponImpactPitch(ImpactNormal, FMath::RandRange(-30, -45), FMath::RandRange(-25, -35));
+	LodgeRotation.Pitch = FThrowingWeaponSimulation::CalculateLodgePitch(ProjectileMovementComponent->Velocity, ImpactNormal);
 
 	// Set the rotation for the lodge point
 	LodgePointComponent->SetRelativeRotation(LodgeRotation);
@@ -250,93 +832,87 @@ void AThrowingWeaponBase::LodgeThrowingWeapon()
 	// Adjust the location of the projectile based on the impact location and normal
 	SetActorLocation(AdjustThrowingWeaponImpactLocation(ImpactNormal, ImpactLocation));
 
-	CurrentThrowingWeaponState = ThrowingWeaponState::Lodged;
+	SetThrowingWeaponState(ThrowingWeaponState::Lodged);
 }
 // Adjust where the throwing weapon will return
 void AThrowingWeaponBase::AdjustThrowingWeaponReturnLocation()
 {
 	if (PlayerReference != nullptr)
 	{
-		MaxCalculationDistanceFromPlayer = 3000;
-		DistanceFromPlayer = GetClampedThrowingWeaponDistanceFromPlayer(MaxCalculationDistanceFromPlayer);
-
 		FVector newActorLocation = GetActorLocation();
 		SetActorLocation(newActorLocation);
 		
 		InitialLocation = GetActorLocation();
 
-		InitialRotation = GetActorRotation();
-
 		StartCameraRotation = PlayerReference->FollowCameraComponent->GetComponentRotation();		
 
 		LodgePointComponent->SetRelativeRotation(FRotator(0, 0, 0));
 	}
 }
 
-// Return position and speed
+// Build the return path once and the play rate that has the weapon arrive when the return curve ends
 void AThrowingWeaponBase::ReturnPosition()
 {
-	TLThrowingWeaponReturnComponent->PlayFromStart();
-	OptimalDistance = 1400;
-	
-	TLThrowingWeaponReturnComponent->SetPlayRate(CalculateThrowingWeaponReturnTimelineSpeed(OptimalDistance, ThrowingWeaponReturnSpeed));
-	if (TLThrowingWeaponReturnSpeed_Curve)
-	{		
-		TLThrowingWeaponReturnComponent->AddInterpFloat(TLThrowingWeaponReturnSpeed_Curve, ThrowingWeaponReturnSpeedValue, FName("Update Speed"));		
-	}
+	OptimalDistance = FThrowingWeaponSimulation::ReturnOptimalDistance;
 
-	TLThrowingWeaponReturnComponent->SetTimelinePostUpdateFunc(ThrowingWeaponReturnTickEvent);
-	TLThrowingWeaponReturnComponent->SetTimelineFinishedFunc(ThrowingWeaponReturnFinished);
+	const float averageSpeed = FThrowingWeaponSimulation::CalculateReturnAverageSpeed(ThrowingWeaponReturnSpeed, ReturnSpeedCurveTable.IsValid() ? ReturnSpeedCurveTable->GetEndTime() : 0);
 
-	TLThrowingWeaponReturnComponent->SetLooping(false);
+	if (PlayerReference != nullptr)
+	{
+		const FTransform& gripPointTransform = PlayerReference->GetWeaponGripPointTransform();
+
+		FThrowingWeaponReturn weaponReturn;
+		weaponReturn.InitialLocation = InitialLocation;
+		weaponReturn.GripPointLocation = gripPointTransform.GetLocation();
+		weaponReturn.GripPointRotation = gripPointTransform.Rotator();
+		weaponReturn.CameraRightVector = PlayerReference->FollowCameraComponent->GetRightVector();
+
+		ReturnPath = FThrowingWeaponSimulation::BuildReturnPath(weaponReturn, ReturnPathCurvature, averageSpeed);
+	}
+
+	ReturnPlayRate = CalculateThrowingWeaponReturnTimelineSpeed();
+	ReturnTime = 0;
 }
 
 // The speed, location (player location) and rotation when recalling the throwing weapon                    
 void AThrowingWeaponBase::CalculateThrowingWeaponReturn(float speedCurve) //  Rework method to properly handle returning without the need for speedCurve
 {	
-	if (PlayerReference != nullptr)
-	{
-		bIsThrowingWeaponReturnDelayFinished = false;
-		
-		FVector CharacterLocation = PlayerReference->FollowCameraComponent->GetRightVector()
-			+ PlayerReference->GetMesh()->GetSocketLocation(FName("WeaponGripPoint"));
+	WEAPON_PROFILE_SCOPE(STAT_WeaponReturnPose);
 
-		FVector lerpActorRightVector = FMath::Lerp(InitialLocation, CharacterLocation, speedCurve);
+	CommitThrowingWeaponReturnPose(CalculateThrowingWeaponReturnPose(speedCurve));
+}
+// Pose on the return path, only reads the path and the owner's cached grip point
+FThrowingWeaponReturnPose AThrowingWeaponBase::CalculateThrowingWeaponReturnPose(float speedCurve) const
+{
+	if (PlayerReference == nullptr)
+	{
+		return FThrowingWeaponReturnPose();
+	}
 
-		ReturnTargetLocation = lerpActorRightVector;
+	// Only the grip point is read, the path itself was built at the recall
+	const FTransform& gripPointTransform = PlayerReference->GetWeaponGripPointTransform();
 
-		FRotator socketRotation = PlayerReference->GetMesh()->GetSocketRotation(FName("WeaponGripPoint"));
+	return FThrowingWeaponSimulation::CalculateReturnPose(ReturnPath, gripPointTransform.GetLocation(), gripPointTransform.Rotator(), speedCurve);
+}
+// Move the weapon to the return pose, nothing happens without a player to return to
+void AThrowingWeaponBase::CommitThrowingWeaponReturnPose(const FThrowingWeaponReturnPose& returnPose)
+{
+	if (PlayerReference != nullptr)
+	{
+		bIsThrowingWeaponReturnDelayFinished = false;
 
-		SetActorLocationAndRotation(ReturnTargetLocation, socketRotation, false, 0, ETeleportType::None);
+		ReturnTargetLocation = returnPose.Location;
 
+		SetActorLocationAndRotation(ReturnTargetLocation, returnPose.Rotation, false, 0, ETeleportType::None);
 	}
 }
 // Wiggle the lodged throwing weapon
 void AThrowingWeaponBase::WiggleLodgedThrowingWeapon()
 {
 	LodgePointBaseRotation = LodgePointComponent->GetRelativeRotation();
+	StateTime = 0;
 
-	if (TLWiggleThrowingWeapon_Curve)
-	{
-		GetWorld()->GetTimerManager().SetTimer(ThrowingWeaponWiggleTimerDelay, this, &AThrowingWeaponBase::ResetWiggleTimerDelay, 0.2, false);
-		
-		TLWiggleThrowingWeaponComponent->AddInterpFloat(TLWiggleThrowingWeapon_Curve, WiggleLodgedThrowingWeaponInterpFunction, FName("Lodged Throwing Weapon Wiggle Time"));
-
-		TLWiggleThrowingWeaponComponent->SetLooping(false);
-	}
-	TLWiggleThrowingWeaponComponent->SetPlayRate(3);
-	TLWiggleThrowingWeaponComponent->PlayFromStart();
-	TLWiggleThrowingWeaponComponent->SetTimelineFinishedFunc(WiggleLodgedThrowingWeaponTimelineFinished);
-}
-// Reset the wiggle so that the timer is available for next throw
-void AThrowingWeaponBase::ResetWiggleTimerDelay()
-{	
-	GetWorldTimerManager().ClearTimer(ThrowingWeaponWiggleTimerDelay);
-}
-// Check for the wiggle timer finished event 
-void AThrowingWeaponBase::ResetThrowingWeaponReturnDelay()
-{
-	bIsThrowingWeaponReturnDelayFinished = true;
+	SetThrowingWeaponState(ThrowingWeaponState::Wiggle);
 }
 // Returns the rotation of the camera
 FRotator AThrowingWeaponBase::ReturnCameraStartRotation()
@@ -348,79 +924,29 @@ FRotator AThrowingWeaponBase::ReturnCameraStartRotation()
 // Return a rotation based on the current axis
 FRotator AThrowingWeaponBase::MakeRotationFromAxes(FVector forward, FVector right, FVector up)
 {
-	forward.Normalize();
-	right.Normalize();
-	up.Normalize();
-
-	FMatrix rotationMatrix(forward, right, up, FVector::ZeroVector);
-
-	return rotationMatrix.Rotator();
+	return FThrowingWeaponSimulation::MakeRotationFromAxes(forward, right, up);
 }
 // Adjust how the throwing weapon should impact
 FVector AThrowingWeaponBase::AdjustThrowingWeaponImpactLocation(FVector impactNormal, FVector impactLocation)
 {
-	FVector right = FVector(0, 0, 0);
-	FVector up = FVector(0, 0, 0);
-
-	FVector vectorAdditionVariable = FVector(0, 0, 0);
-	FVector returningVariable = FVector(0, 0, 0);
-
-	if (MakeRotationFromAxes(impactNormal, right, up).Pitch > 0)
-	{
-		impactNormal.Y = ((MakeRotationFromAxes(impactNormal, right, up).Pitch - 90) / 90) * 10;
+	FThrowingWeaponImpact impact;
+	impact.ImpactNormal = impactNormal;
+	impact.ImpactLocation = impactLocation;
+	impact.ActorLocation = GetActorLocation();
+	impact.LodgePointLocation = LodgePointComponent->GetComponentLocation();
 
-		vectorAdditionVariable = impactNormal;
-
-		impactLocation = impactLocation + vectorAdditionVariable.Z;
-
-		returningVariable = LodgePointComponent->GetComponentLocation() - GetActorLocation() + impactLocation;
-	}
-	else
-	{
-		returningVariable = GetActorLocation() - LodgePointComponent->GetComponentLocation() + impactLocation;
-	}
-
-	return returningVariable;
+	return FThrowingWeaponSimulation::AdjustImpactLocation(impact);
 }
 // Adjusts the vertical rise of the throwing weapon handle based on surface
 float AThrowingWeaponBase::AdjustThrowingWeaponImpactPitch(FVector impactNormal, float inclinedSurfaceRange, float regularSurfaceRange)
 {
-	FVector right = FVector(0, 0, 0);
-	FVector up = FVector(0, 0, 0);
-
-	if (MakeRotationFromAxes(impactNormal, right, up).Pitch > 0)
-	{
-		regularSurfaceRange = inclinedSurfaceRange - MakeRotationFromAxes(impactNormal, right, up).Pitch;
-
-		if (MakeRotationFromAxes(impactNormal, right, up).Pitch > -80)
-		{
-			return -90;
-		}
-		return regularSurfaceRange;
-	}
-	else
-	{
-		if (MakeRotationFromAxes(impactNormal, right, up).Pitch > -80)
-		{
-			return -90;
-		}
-		return inclinedSurfaceRange;
-	}
-}
-// Gets the max distance from player 
-float AThrowingWeaponBase::GetClampedThrowingWeaponDistanceFromPlayer(float maxDistance)
-{
-	FVector distanceFromWeaponToPlayer = GetActorLocation() - PlayerReference->GetMesh()->GetSocketLocation(FName("WeaponGripPoint"));
-	float clampedWeaponDistanceFromPlayer = FMath::Clamp(distanceFromWeaponToPlayer.Size(), 0, maxDistance);
-
-	return clampedWeaponDistanceFromPlayer;
+	return FThrowingWeaponSimulation::AdjustImpactPitch(impactNormal, inclinedSurfaceRange, regularSurfaceRange);
 }
-// Checks how long it will take for the throwing weapon to return to the player
-float AThrowingWeaponBase::CalculateThrowingWeaponReturnTimelineSpeed(float optimalDistance, float throwingWeaponReturnSpeed)
+// Return curve play rate that arrives at the player when the return path's duration is up
+float AThrowingWeaponBase::CalculateThrowingWeaponReturnTimelineSpeed() const
 {
-	float calculateReturnSpeed = (optimalDistance * ThrowingWeaponReturnSpeed) / DistanceFromPlayer;
-	float ClampCalculateReturnSpeed = FMath::Clamp(calculateReturnSpeed, 0.4, 0.7);
+	const float curveEndTime = FThrowingWeaponSimulation::GetReturnCurveEndTime(ReturnSpeedCurveTable.IsValid() ? ReturnSpeedCurveTable->GetEndTime() : 0);
 
-	return ClampCalculateReturnSpeed;
+	return FThrowingWeaponSimulation::CalculateReturnPlayRate(ReturnPath.Duration, curveEndTime);
 }
 
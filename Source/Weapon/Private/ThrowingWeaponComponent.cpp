@@ -0,0 +1,342 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponComponent.h"
+#include "ThrowingWeaponArchetype.h"
+#include "ThrowingWeaponArchetypeSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "WeaponStats.h"
+
+// Sets default values
+UThrowingWeaponComponent::UThrowingWeaponComponent()
+{
+	// Tick only runs the state machine, so it is switched on while the weapon is launched, wiggling or returning
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	GripSocketName = FName("WeaponGripPoint");
+	ThrowingWeaponSpinRate = 1;
+	ThrowingWeaponRotationMultiplier = 360;
+	WeaponThrowSpeed = 2500;
+	WeaponThrowDirectionMultiplier = 100;
+	GravityScale = 1;
+	ThrowingWeaponReturnSpeed = 1;
+	ReturnPathCurvature = 0.25f;
+	WeaponThrowTraceDistance = 60;
+
+	ProxyMeshComponent = nullptr;
+	GripComponent = nullptr;
+	CurrentThrowingWeaponState = ThrowingWeaponState::Idle;
+	Location = FVector::ZeroVector;
+	Velocity = FVector::ZeroVector;
+	ThrowRotation = FRotator::ZeroRotator;
+	LodgeRotation = FRotator::ZeroRotator;
+	GravityZ = 0;
+	StateTime = 0;
+	ReturnTime = 0;
+	ReturnPlayRate = 1;
+}
+// Create the mesh proxy at the grip and start loading the variant
+void UThrowingWeaponComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* owner = GetOwner();
+
+	ThrowTraceQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(ThrowingWeaponTrace), false, owner);
+
+	// Held by the host's skeletal mesh unless SetGrip already chose something
+	if (GripComponent == nullptr)
+	{
+		USkeletalMeshComponent* hostMesh = owner->FindComponentByClass<USkeletalMeshComponent>();
+		GripComponent = hostMesh != nullptr ? static_cast<USceneComponent*>(hostMesh) : owner->GetRootComponent();
+	}
+
+	ProxyMeshComponent = NewObject<UStaticMeshComponent>(owner);
+	ProxyMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProxyMeshComponent->SetGenerateOverlapEvents(false);
+	ProxyMeshComponent->SetCanEverAffectNavigation(false);
+	ProxyMeshComponent->SetupAttachment(GripComponent, GripSocketName);
+	ProxyMeshComponent->RegisterComponent();
+
+	// Constant tables until the variant's curves are in memory
+	SpinCurveTable = FBakedCurve::FindOrBake(nullptr, 0);
+	ReturnSpeedCurveTable = FBakedCurve::FindOrBake(nullptr, 1);
+	WiggleCurveTable = FBakedCurve::FindOrBake(nullptr, 0);
+
+	if (!Archetype.IsNull())
+	{
+		UGameInstance* gameInstance = GetWorld()->GetGameInstance();
+		if (UThrowingWeaponArchetypeSubsystem* archetypeSubsystem = gameInstance != nullptr ? gameInstance->GetSubsystem<UThrowingWeaponArchetypeSubsystem>() : nullptr)
+		{
+			archetypeSubsystem->RequestArchetype(Archetype, FOnThrowingWeaponArchetypeLoaded::CreateUObject(this, &UThrowingWeaponComponent::ApplyArchetype));
+		}
+		else
+		{
+			ApplyArchetype(Archetype.LoadSynchronous());
+		}
+	}
+}
+// Let go of the variant and remove the proxy from the host
+void UThrowingWeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (!Archetype.IsNull())
+	{
+		UGameInstance* gameInstance = GetWorld()->GetGameInstance();
+		if (UThrowingWeaponArchetypeSubsystem* archetypeSubsystem = gameInstance != nullptr ? gameInstance->GetSubsystem<UThrowingWeaponArchetypeSubsystem>() : nullptr)
+		{
+			archetypeSubsystem->ReleaseArchetype(Archetype);
+		}
+	}
+
+	if (ProxyMeshComponent != nullptr)
+	{
+		ProxyMeshComponent->DestroyComponent();
+		ProxyMeshComponent = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+// Called every frame while the weapon is launched, wiggling or returning
+void UThrowingWeaponComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponComponent);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	switch (CurrentThrowingWeaponState)
+	{
+	case ThrowingWeaponState::Launched:
+		UpdateLaunched(DeltaTime);
+		break;
+
+	case ThrowingWeaponState::Wiggle:
+		UpdateWiggle(DeltaTime);
+		break;
+
+	case ThrowingWeaponState::Returning:
+		if (AdvanceReturn(DeltaTime, 0))
+		{
+			Catch();
+		}
+		break;
+
+	default:
+		SetComponentTickEnabled(false);
+		break;
+	}
+}
+// Where the weapon is held and returns to
+void UThrowingWeaponComponent::SetGrip(USceneComponent* gripComponent, FName gripSocketName)
+{
+	GripComponent = gripComponent;
+	GripSocketName = gripSocketName;
+
+	// A weapon that is away picks up the new grip when it is caught
+	if (ProxyMeshComponent != nullptr && CurrentThrowingWeaponState == ThrowingWeaponState::Idle)
+	{
+		ProxyMeshComponent->AttachToComponent(GripComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale, GripSocketName);
+	}
+}
+// Launch from in front of the view along throwDirection
+void UThrowingWeaponComponent::ThrowWeapon(FVector throwDirection, FVector viewLocation, FRotator viewRotation)
+{
+	if (CurrentThrowingWeaponState != ThrowingWeaponState::Idle || ProxyMeshComponent == nullptr)
+	{
+		return;
+	}
+
+	const FVector direction = throwDirection.GetSafeNormal();
+
+	Location = viewLocation + direction * WeaponThrowDirectionMultiplier;
+	Velocity = direction * WeaponThrowSpeed;
+	ThrowRotation = viewRotation;
+	GravityZ = GetWorld()->GetGravityZ() * GravityScale;
+	StateTime = 0;
+
+	SetProxyPose(Location, Velocity.Rotation());
+	PreviousTraceSample = MakeTraceSample();
+	SetThrowingWeaponState(ThrowingWeaponState::Launched);
+}
+// Return to the grip, a lodged weapon wiggles loose first
+void UThrowingWeaponComponent::RecallThrowingWeapon()
+{
+	switch (CurrentThrowingWeaponState)
+	{
+	case ThrowingWeaponState::Launched:
+		BuildReturnPath();
+		SetThrowingWeaponState(ThrowingWeaponState::Returning);
+		break;
+
+	case ThrowingWeaponState::Lodged:
+		BuildReturnPath();
+		StateTime = 0;
+		SetThrowingWeaponState(ThrowingWeaponState::Wiggle);
+		break;
+
+	default:
+		break;
+	}
+}
+// Integrate the flight, spin and sweep the proxy along the flight since last frame the same way AThrowingWeaponBase's continuous collision does
+void UThrowingWeaponComponent::UpdateLaunched(float deltaTime)
+{
+	StateTime = FThrowingWeaponSimulation::AdvanceSpin(StateTime, deltaTime, ThrowingWeaponSpinRate, SpinCurveTable->GetEndTime());
+	FThrowingWeaponSimulation::AdvanceFlight(Location, Velocity, GravityZ, 0, deltaTime);
+
+	const float spin = SpinCurveTable->Evaluate(StateTime);
+	SetProxyPose(Location, (Velocity.Rotation().Quaternion() * FRotator(spin * ThrowingWeaponRotationMultiplier, 0, 0).Quaternion()).Rotator());
+
+	const FThrowingWeaponFlightSample currentSample = MakeTraceSample();
+
+	FThrowingWeaponSweepPath path;
+	FThrowingWeaponSimulation::BuildSweepPath(PreviousTraceSample, currentSample, FThrowingWeaponSimulation::DefaultMaxSweepStepTime, WeaponThrowTraceDistance, path);
+	PreviousTraceSample = currentSample;
+
+	FHitResult hitResult;
+	if (AThrowingWeaponBase::SweepThrowPath(GetWorld(), path, ProxyMeshComponent->GetComponentQuat(), AThrowingWeaponBase::MakeThrowSweepShape(ProxyMeshComponent, 0), ThrowTraceQueryParams, hitResult))
+	{
+		Lodge(hitResult);
+	}
+}
+// Wiggle loose along the wiggle curve while the return already starts
+void UThrowingWeaponComponent::UpdateWiggle(float deltaTime)
+{
+	StateTime += deltaTime * FThrowingWeaponSimulation::WigglePlayRate;
+
+	if (AdvanceReturn(deltaTime, WiggleCurveTable->Evaluate(StateTime)))
+	{
+		Catch();
+	}
+	else if (StateTime >= WiggleCurveTable->GetEndTime())
+	{
+		SetThrowingWeaponState(ThrowingWeaponState::Returning);
+	}
+}
+// Move along the return path tilted by the wiggle curve value, true once the weapon arrived
+bool UThrowingWeaponComponent::AdvanceReturn(float deltaTime, float wiggleValue)
+{
+	ReturnTime += deltaTime * ReturnPlayRate;
+
+	const FTransform gripTransform = GetGripTransform();
+	const float curveEndTime = ReturnSpeedCurveTable->GetEndTime();
+	const float returnAlpha = FThrowingWeaponSimulation::CalculateReturnAlpha(ReturnSpeedCurveTable->Evaluate(ReturnTime), ReturnTime, curveEndTime);
+	const FThrowingWeaponReturnPose returnPose = FThrowingWeaponSimulation::CalculateReturnPose(ReturnPath, gripTransform.GetLocation(), gripTransform.Rotator(), returnAlpha);
+
+	Location = returnPose.Location;
+	SetProxyPose(Location, FThrowingWeaponSimulation::CalculateWiggleRotation(returnPose.Rotation, wiggleValue));
+
+	return FThrowingWeaponSimulation::IsReturnFinished(ReturnTime, curveEndTime);
+}
+// Stop at the impact, tilted for the surface the same way AThrowingWeaponBase lodges
+void UThrowingWeaponComponent::Lodge(const FHitResult& hitResult)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponImpact);
+
+	FThrowingWeaponImpact impact;
+	impact.ImpactNormal = hitResult.ImpactNormal;
+	impact.ImpactLocation = hitResult.ImpactPoint;
+	impact.ActorLocation = hitResult.ImpactPoint;
+	impact.LodgePointLocation = hitResult.ImpactPoint;
+
+	LodgeRotation = FRotator(FThrowingWeaponSimulation::CalculateLodgePitch(Velocity, impact.ImpactNormal), ThrowRotation.Yaw, 0);
+
+	Location = FThrowingWeaponSimulation::AdjustImpactLocation(impact);
+	Velocity = FVector::ZeroVector;
+
+	SetProxyPose(Location, LodgeRotation);
+	SetThrowingWeaponState(ThrowingWeaponState::Lodged);
+}
+// Path from where the weapon is to the grip, built once per recall
+void UThrowingWeaponComponent::BuildReturnPath()
+{
+	const float curveEndTime = FThrowingWeaponSimulation::GetReturnCurveEndTime(ReturnSpeedCurveTable->GetEndTime());
+	const float averageSpeed = FThrowingWeaponSimulation::CalculateReturnAverageSpeed(ThrowingWeaponReturnSpeed, curveEndTime);
+
+	const FTransform gripTransform = GetGripTransform();
+
+	FThrowingWeaponReturn weaponReturn;
+	weaponReturn.InitialLocation = Location;
+	weaponReturn.GripPointLocation = gripTransform.GetLocation();
+	weaponReturn.GripPointRotation = gripTransform.Rotator();
+	weaponReturn.CameraRightVector = GetViewRightVector();
+
+	ReturnPath = FThrowingWeaponSimulation::BuildReturnPath(weaponReturn, ReturnPathCurvature, averageSpeed);
+	ReturnPlayRate = FThrowingWeaponSimulation::CalculateReturnPlayRate(ReturnPath.Duration, curveEndTime);
+	ReturnTime = 0;
+}
+// Back at the grip, the proxy follows the socket again without being reattached
+void UThrowingWeaponComponent::Catch()
+{
+	ProxyMeshComponent->SetUsingAbsoluteLocation(false);
+	ProxyMeshComponent->SetUsingAbsoluteRotation(false);
+	ProxyMeshComponent->SetRelativeLocationAndRotation(FVector::ZeroVector, FRotator::ZeroRotator);
+
+	SetThrowingWeaponState(ThrowingWeaponState::Idle);
+}
+
+void UThrowingWeaponComponent::SetThrowingWeaponState(ThrowingWeaponState newState)
+{
+	CurrentThrowingWeaponState = newState;
+
+	// Idle and Lodged weapons have nothing to update
+	SetComponentTickEnabled(newState == ThrowingWeaponState::Launched || newState == ThrowingWeaponState::Wiggle || newState == ThrowingWeaponState::Returning);
+
+	OnThrowingWeaponStateChanged.Broadcast(this, newState);
+}
+// Place the proxy in world space, it stays attached to the grip but ignores it while the weapon is away
+void UThrowingWeaponComponent::SetProxyPose(const FVector& location, const FRotator& rotation)
+{
+	if (!ProxyMeshComponent->IsUsingAbsoluteLocation())
+	{
+		ProxyMeshComponent->SetUsingAbsoluteLocation(true);
+		ProxyMeshComponent->SetUsingAbsoluteRotation(true);
+	}
+
+	ProxyMeshComponent->SetWorldLocationAndRotation(location, rotation);
+}
+
+FTransform UThrowingWeaponComponent::GetGripTransform() const
+{
+	return GripComponent != nullptr ? GripComponent->GetSocketTransform(GripSocketName) : GetOwner()->GetActorTransform();
+}
+// Where the proxy's swept shape is now, the next sweep starts from it
+FThrowingWeaponFlightSample UThrowingWeaponComponent::MakeTraceSample() const
+{
+	FThrowingWeaponFlightSample sample;
+	sample.Location = ProxyMeshComponent->Bounds.Origin;
+	sample.Velocity = Velocity;
+	sample.Time = GetWorld()->GetTimeSeconds();
+	return sample;
+}
+// Right vector of the host's view, the return bows out towards it
+FVector UThrowingWeaponComponent::GetViewRightVector() const
+{
+	if (const APawn* pawn = Cast<APawn>(GetOwner()))
+	{
+		return FRotationMatrix(pawn->GetViewRotation()).GetUnitAxis(EAxis::Y);
+	}
+	return GetOwner()->GetActorRightVector();
+}
+// Mesh and curve tables of the loaded variant
+void UThrowingWeaponComponent::ApplyArchetype(UThrowingWeaponArchetype* archetype)
+{
+	if (archetype == nullptr || FSoftObjectPath(archetype) != Archetype.ToSoftObjectPath())
+	{
+		return;
+	}
+
+	if (UStaticMesh* mesh = archetype->Mesh.Get())
+	{
+		ProxyMeshComponent->SetStaticMesh(mesh);
+	}
+
+	SpinCurveTable = FBakedCurve::FindOrBake(archetype->RotationForwardCurve.Get(), 0);
+	ReturnSpeedCurveTable = FBakedCurve::FindOrBake(archetype->ReturnSpeedCurve.Get(), 1);
+	WiggleCurveTable = FBakedCurve::FindOrBake(archetype->WiggleCurve.Get(), 0);
+}
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponComponentComparison.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThrowingWeaponComponent.h"
+#include "DefaultThrowingWeapon.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectHash.h"
+
+AActor* FThrowingWeaponComponentComparison::SpawnHost(UWorld* world, const FVector& location)
+{
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* host = world->SpawnActor<AActor>(AActor::StaticClass(), FTransform(location), spawnParameters);
+
+	USkeletalMeshComponent* hostMesh = NewObject<USkeletalMeshComponent>(host);
+	host->SetRootComponent(hostMesh);
+	hostMesh->RegisterComponent();
+
+	return host;
+}
+
+int64 FThrowingWeaponComponentComparison::CountObjectBytes(const UObject* object)
+{
+	TArray<UObject*> subobjects;
+	GetObjectsWithOuter(object, subobjects, true);
+	subobjects.Add(const_cast<UObject*>(object));
+
+	int64 bytes = 0;
+	for (UObject* subobject : subobjects)
+	{
+		FArchiveCountMem countMem(subobject);
+		bytes += countMem.GetMax();
+	}
+	return bytes;
+}
+// Spawn count hosts, add their weapon and measure what the weapons added (the hosts are measured on their own first)
+FThrowingWeaponComponentComparison::FResult FThrowingWeaponComponentComparison::Measure(UWorld* world, int32 count, TFunctionRef<void(AActor*)> addWeapon, TFunctionRef<int64(AActor*)> countWeapon)
+{
+	TArray<AActor*> hosts;
+	for (int32 i = 0; i < count; i++)
+	{
+		hosts.Add(SpawnHost(world, FVector((i % 32) * 200, (i / 32) * 200, 10000)));
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	FResult result;
+	const int32 objectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	const uint64 usedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+	const double spawnStart = FPlatformTime::Seconds();
+
+	for (AActor* host : hosts)
+	{
+		addWeapon(host);
+	}
+
+	result.SpawnMilliseconds = (FPlatformTime::Seconds() - spawnStart) * 1000;
+	result.NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable() - objectsBefore;
+	result.UsedPhysicalBytes = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<int64>(usedPhysicalBefore);
+
+	for (AActor* host : hosts)
+	{
+		result.ObjectBytes += countWeapon(host);
+		host->Destroy();
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return result;
+}
+
+// Measure both ways of holding the weapon
+void FThrowingWeaponComponentComparison::Compare(UWorld* world, int32 count, TSubclassOf<AThrowingWeaponBase> weaponClass, FResult& outChildActorResult, FResult& outComponentResult)
+{
+	outChildActorResult = Measure(world, count,
+		[weaponClass](AActor* host)
+		{
+			UChildActorComponent* childActorComponent = NewObject<UChildActorComponent>(host);
+			childActorComponent->SetChildActorClass(weaponClass);
+			childActorComponent->SetupAttachment(host->GetRootComponent(), FName("WeaponGripPoint"));
+			childActorComponent->RegisterComponent();
+		},
+		[](AActor* host)
+		{
+			// The child actor is outered to the level, not to its host
+			UChildActorComponent* childActorComponent = host->FindComponentByClass<UChildActorComponent>();
+			return CountObjectBytes(childActorComponent) + (childActorComponent->GetChildActor() != nullptr ? CountObjectBytes(childActorComponent->GetChildActor()) : 0);
+		});
+
+	outComponentResult = Measure(world, count,
+		[](AActor* host)
+		{
+			// The host already began play, so registering begins play on the component, which creates the proxy
+			UThrowingWeaponComponent* weaponComponent = NewObject<UThrowingWeaponComponent>(host);
+			weaponComponent->RegisterComponent();
+		},
+		[](AActor* host)
+		{
+			UThrowingWeaponComponent* weaponComponent = host->FindComponentByClass<UThrowingWeaponComponent>();
+			return CountObjectBytes(weaponComponent) + (weaponComponent->GetProxyMesh() != nullptr ? CountObjectBytes(weaponComponent->GetProxyMesh()) : 0);
+		});
+}
+// Weapon.Component.Compare console command
+void FThrowingWeaponComponentComparison::Run(const TArray<FString>& args, UWorld* world)
+{
+	if (world == nullptr)
+	{
+		return;
+	}
+
+	const int32 count = args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*args[0])) : 200;
+
+	// The weapon actor APlayerCharacterBase spawns unless a Blueprint class is given
+	TSubclassOf<AThrowingWeaponBase> weaponClass = ADefaultThrowingWeapon::StaticClass();
+	if (args.Num() > 1)
+	{
+		if (UClass* loadedClass = LoadClass<AThrowingWeaponBase>(nullptr, *args[1]))
+		{
+			weaponClass = loadedClass;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Weapon.Component.Compare: %s is not a throwing weapon class, using ADefaultThrowingWeapon"), *args[1]);
+		}
+	}
+
+	FResult childActorResult;
+	FResult componentResult;
+	Compare(world, count, weaponClass, childActorResult, componentResult);
+
+	const auto logResult = [count](const TCHAR* name, const FResult& result)
+	{
+		UE_LOG(LogTemp, Display, TEXT("  %-16s %8.2f us/spawn %6.1f objects %8.1f KB counted %8.1f KB resident"),
+			name,
+			result.SpawnMilliseconds * 1000 / count,
+			static_cast<double>(result.NumObjects) / count,
+			result.ObjectBytes / 1024.0 / count,
+			result.UsedPhysicalBytes / 1024.0 / count);
+	};
+
+	UE_LOG(LogTemp, Display, TEXT("Weapon.Component.Compare: %d hosts of %s, per instance:"), count, *GetNameSafe(weaponClass));
+	logResult(TEXT("ChildActor"), childActorResult);
+	logResult(TEXT("Component"), componentResult);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdThrowingWeaponComponentCompare(
+	TEXT("Weapon.Component.Compare"),
+	TEXT("Compare spawn time and memory of a throwing weapon held through a ChildActorComponent and through UThrowingWeaponComponent. Optional arguments: hosts (200), weapon class path"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FThrowingWeaponComponentComparison::Run));
+
+#endif
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThrowingWeaponBase.h"
+
+/// <summary>
+/// Weapon.Component.Compare: spawns the same number of weapon hosts holding their weapon through a UChildActorComponent
+/// (like APlayerCharacterBase) and through a UThrowingWeaponComponent, and logs spawn time, UObjects, counted object memory
+/// and resident memory per instance for both. The Weapon.Component.Compare automation test fails when the component
+/// creates as many objects or as much counted memory as the child actor
+/// </summary>
+struct FThrowingWeaponComponentComparison
+{
+	struct FResult
+	{
+		double SpawnMilliseconds = 0; // Spawning and registering every host
+		int32 NumObjects = 0; // UObjects created
+		int64 ObjectBytes = 0; // Counted size of the hosts' weapon objects
+		int64 UsedPhysicalBytes = 0; // Resident memory growth, noisy below a few hundred hosts
+	};
+
+	static void Compare(UWorld* world, int32 count, TSubclassOf<AThrowingWeaponBase> weaponClass, FResult& outChildActorResult, FResult& outComponentResult); // Measure both ways of holding the weapon
+
+	static void Run(const TArray<FString>& args, UWorld* world); // Weapon.Component.Compare console command
+
+	static AActor* SpawnHost(UWorld* world, const FVector& location); // Empty actor with a skeletal mesh to hold the weapon
+
+	static int64 CountObjectBytes(const UObject* object); // Counted memory of the object and everything outered to it
+
+	static FResult Measure(UWorld* world, int32 count, TFunctionRef<void(AActor*)> addWeapon, TFunctionRef<int64(AActor*)> countWeapon);
+};
+
+#endif
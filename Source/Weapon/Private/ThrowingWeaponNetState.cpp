@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponNetState.h"
+#include "Engine/NetSerialization.h"
+
+#if !UE_BUILD_SHIPPING
+#include "HAL/IConsoleManager.h"
+#include "UObject/CoreNet.h"
+#endif
+
+bool FThrowingWeaponNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	// Five states fit in three bits, the other three values only come from a corrupt or hostile packet
+	uint32 state = State;
+	Ar.SerializeBits(&state, 3);
+	State = static_cast<uint8>(state);
+
+	Ar << Sequence;
+
+	if (Ar.IsError() || State > ThrowingWeaponState::Returning)
+	{
+		State = ThrowingWeaponState::Idle;
+		bOutSuccess = false;
+		return true;
+	}
+
+	// Idle and the return states only need the state itself
+	const ThrowingWeaponState currentState = GetState();
+	if (currentState == ThrowingWeaponState::Launched || currentState == ThrowingWeaponState::Lodged)
+	{
+		bOutSuccess &= SerializePackedVector<10, 24>(Location, Ar);
+		Rotation.SerializeCompressedShort(Ar);
+	}
+
+	if (currentState == ThrowingWeaponState::Launched)
+	{
+		bOutSuccess &= SerializeFixedVector<1, 16>(Direction, Ar);
+	}
+
+	bOutSuccess &= !Ar.IsError();
+
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/// <summary>
+/// Payload counters behind Weapon.Net.Stats, kept per process (server and clients count what they send)
+/// </summary>
+struct FThrowingWeaponNetStats
+{
+	uint64 NumThrows = 0;
+	uint64 NumStates = 0; // Replicated state changes
+	uint64 NumRpcs = 0; // Launch/recall requests sent to the server
+	uint64 StateBits = 0;
+	uint64 RpcBits = 0;
+
+	static FThrowingWeaponNetStats& Get()
+	{
+		static FThrowingWeaponNetStats stats;
+		return stats;
+	}
+};
+
+// Count the payload of a sent state, measured by serializing it like the net driver does
+void FThrowingWeaponNetState::RecordSent(const FThrowingWeaponNetState& netState, bool bIsRpc)
+{
+	FThrowingWeaponNetState serializedState = netState;
+	FNetBitWriter writer(nullptr, 1024);
+	bool bSuccess = true;
+	serializedState.NetSerialize(writer, nullptr, bSuccess);
+
+	FThrowingWeaponNetStats& stats = FThrowingWeaponNetStats::Get();
+	if (bIsRpc)
+	{
+		stats.NumRpcs++;
+		stats.RpcBits += writer.GetNumBits();
+	}
+	else
+	{
+		stats.NumStates++;
+		stats.StateBits += writer.GetNumBits();
+	}
+}
+// A recall request was sent, its only parameter is the byte of the recalled throw's sequence
+void FThrowingWeaponNetState::RecordSentRecall()
+{
+	FThrowingWeaponNetStats& stats = FThrowingWeaponNetStats::Get();
+	stats.NumRpcs++;
+	stats.RpcBits += 8;
+}
+// A throw started on the server
+void FThrowingWeaponNetState::RecordThrow()
+{
+	FThrowingWeaponNetStats::Get().NumThrows++;
+}
+
+static FAutoConsoleCommand CmdThrowingWeaponNetStats(
+	TEXT("Weapon.Net.Stats"),
+	TEXT("Print the throwing weapon replication payload per throw (run on the server or a listen server after throwing in a multi-client PIE session). Optional argument: reset"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		FThrowingWeaponNetStats& stats = FThrowingWeaponNetStats::Get();
+
+		if (args.Num() > 0 && args[0] == TEXT("reset"))
+		{
+			stats = FThrowingWeaponNetStats();
+			return;
+		}
+
+		// What the same state would cost as plain FVector/FVector/FRotator (doubles) and two bytes
+		const double unquantizedBytes = 3 * 3 * sizeof(double) + 2;
+		const double throws = FMath::Max<uint64>(stats.NumThrows, 1);
+
+		UE_LOG(LogTemp, Display, TEXT("Throwing weapon replication: %llu throws, %llu state updates (%.1f bytes each), %llu requests (%.1f bytes each)"),
+			stats.NumThrows,
+			stats.NumStates, stats.NumStates > 0 ? stats.StateBits / 8.0 / stats.NumStates : 0.0,
+			stats.NumRpcs, stats.NumRpcs > 0 ? stats.RpcBits / 8.0 / stats.NumRpcs : 0.0);
+		UE_LOG(LogTemp, Display, TEXT("  %.1f payload bytes per throw per connection, launch and recall requests included (%.1f bytes per state unquantized)"),
+			(stats.StateBits + stats.RpcBits) / 8.0 / throws, unquantizedBytes);
+	}));
+
+#endif
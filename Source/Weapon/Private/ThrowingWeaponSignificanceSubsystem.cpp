@@ -0,0 +1,300 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponSignificanceSubsystem.h"
+#include "ThrowingWeaponBase.h"
+#include "PlayerCharacter/Public/PlayerCharacterBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "WeaponStats.h"
+
+static int32 GThrowingWeaponSignificanceEnabled = 1;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceEnabled(
+	TEXT("Weapon.Significance.Enabled"),
+	GThrowingWeaponSignificanceEnabled,
+	TEXT("Lower the tick rate of far and off-screen throwing weapons and characters. 0 ticks everything every frame"));
+
+static float GThrowingWeaponSignificanceUpdateInterval = 0.25f;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceUpdateInterval(
+	TEXT("Weapon.Significance.UpdateInterval"),
+	GThrowingWeaponSignificanceUpdateInterval,
+	TEXT("Seconds between two significance updates (state changes are scored right away)"));
+
+static float GThrowingWeaponSignificanceFarDistance = 8000;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceFarDistance(
+	TEXT("Weapon.Significance.FarDistance"),
+	GThrowingWeaponSignificanceFarDistance,
+	TEXT("Off-screen actors further than this from every viewer tick at Weapon.Significance.FarTickInterval"));
+
+static float GThrowingWeaponSignificanceHysteresis = 0.15f;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceHysteresis(
+	TEXT("Weapon.Significance.Hysteresis"),
+	GThrowingWeaponSignificanceHysteresis,
+	TEXT("Fraction past Weapon.Significance.FarDistance an actor has to move before it drops to Far, so actors on the border don't flip every update"));
+
+static float GThrowingWeaponSignificanceVisibilityGrace = 0.5f;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceVisibilityGrace(
+	TEXT("Weapon.Significance.VisibilityGrace"),
+	GThrowingWeaponSignificanceVisibilityGrace,
+	TEXT("Seconds an actor still counts as visible (and ticks every frame) after it was last rendered"));
+
+static float GThrowingWeaponSignificanceReducedTickInterval = 0.033f;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceReducedTickInterval(
+	TEXT("Weapon.Significance.ReducedTickInterval"),
+	GThrowingWeaponSignificanceReducedTickInterval,
+	TEXT("Tick interval of off-screen actors within Weapon.Significance.FarDistance"));
+
+static float GThrowingWeaponSignificanceFarTickInterval = 0.2f;
+static FAutoConsoleVariableRef CVarThrowingWeaponSignificanceFarTickInterval(
+	TEXT("Weapon.Significance.FarTickInterval"),
+	GThrowingWeaponSignificanceFarTickInterval,
+	TEXT("Tick interval of off-screen actors past Weapon.Significance.FarDistance and characters with nothing to update"));
+
+TStatId UThrowingWeaponSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UThrowingWeaponSignificanceSubsystem, STATGROUP_Tickables);
+}
+// Only game worlds have viewers to be significant to
+bool UThrowingWeaponSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+// Score every registered actor once per update interval
+void UThrowingWeaponSignificanceSubsystem::Tick(float DeltaTime)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponSignificance);
+
+	TimeUntilUpdate -= DeltaTime;
+
+	const bool bIsEnabled = GThrowingWeaponSignificanceEnabled != 0;
+	if (TimeUntilUpdate <= 0 || bIsEnabled != bWasEnabled)
+	{
+		TimeUntilUpdate = GThrowingWeaponSignificanceUpdateInterval;
+		bWasEnabled = bIsEnabled;
+
+		GatherViewLocations();
+
+		for (int32 i = Entries.Num() - 1; i >= 0; i--)
+		{
+			AActor* actor = Entries[i].Actor.Get();
+			if (actor == nullptr)
+			{
+				Entries.RemoveAtSwap(i);
+				continue;
+			}
+
+			const EThrowingWeaponSignificance significance = CalculateSignificance(actor, Entries[i].Significance);
+			if (significance != Entries[i].Significance)
+			{
+				ApplySignificance(actor, significance);
+				Entries[i].Significance = significance;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_WeaponSignificanceFull, GetNumActors(EThrowingWeaponSignificance::Full));
+	SET_DWORD_STAT(STAT_WeaponSignificanceReduced, GetNumActors(EThrowingWeaponSignificance::Reduced));
+	SET_DWORD_STAT(STAT_WeaponSignificanceFar, GetNumActors(EThrowingWeaponSignificance::Far));
+	SET_DWORD_STAT(STAT_WeaponSignificanceEventOnly, GetNumActors(EThrowingWeaponSignificance::EventOnly));
+}
+// Start managing the tick rate of a throwing weapon or character
+void UThrowingWeaponSignificanceSubsystem::RegisterActor(AActor* actor)
+{
+	if (actor == nullptr || Entries.ContainsByPredicate([actor](const FEntry& other) { return other.Actor == actor; }))
+	{
+		return;
+	}
+
+	FEntry& entry = Entries.AddDefaulted_GetRef();
+	entry.Actor = actor;
+
+	RefreshActor(actor);
+}
+// Stop managing the actor and give it back its full tick rate
+void UThrowingWeaponSignificanceSubsystem::UnregisterActor(AActor* actor)
+{
+	const int32 index = Entries.IndexOfByPredicate([actor](const FEntry& other) { return other.Actor == actor; });
+	if (index != INDEX_NONE)
+	{
+		if (Entries[index].Significance != EThrowingWeaponSignificance::Full)
+		{
+			ApplySignificance(actor, EThrowingWeaponSignificance::Full);
+		}
+		Entries.RemoveAtSwap(index);
+	}
+}
+// Score the actor again right away, called on state changes so they never wait for the next update
+void UThrowingWeaponSignificanceSubsystem::RefreshActor(AActor* actor)
+{
+	FEntry* entry = Entries.FindByPredicate([actor](const FEntry& other) { return other.Actor == actor; });
+	if (entry == nullptr)
+	{
+		return;
+	}
+
+	if (ViewLocations.Num() == 0)
+	{
+		GatherViewLocations();
+	}
+
+	const EThrowingWeaponSignificance significance = CalculateSignificance(actor, entry->Significance);
+	if (significance != entry->Significance)
+	{
+		ApplySignificance(actor, significance);
+		entry->Significance = significance;
+	}
+}
+// Full for actors that aren't registered
+EThrowingWeaponSignificance UThrowingWeaponSignificanceSubsystem::GetSignificance(const AActor* actor) const
+{
+	const FEntry* entry = Entries.FindByPredicate([actor](const FEntry& other) { return other.Actor == actor; });
+	return entry != nullptr ? entry->Significance : EThrowingWeaponSignificance::Full;
+}
+// How many registered actors are at a significance
+int32 UThrowingWeaponSignificanceSubsystem::GetNumActors(EThrowingWeaponSignificance significance) const
+{
+	int32 count = 0;
+	for (const FEntry& entry : Entries)
+	{
+		count += entry.Significance == significance ? 1 : 0;
+	}
+	return count;
+}
+// Local viewpoints, or every player's pawn on a server without local players
+void UThrowingWeaponSignificanceSubsystem::GatherViewLocations()
+{
+	ViewLocations.Reset();
+
+	for (FConstPlayerControllerIterator iterator = GetWorld()->GetPlayerControllerIterator(); iterator; ++iterator)
+	{
+		const APlayerController* playerController = iterator->Get();
+		if (playerController != nullptr && playerController->IsLocalController())
+		{
+			FVector viewLocation;
+			FRotator viewRotation;
+			playerController->GetPlayerViewPoint(viewLocation, viewRotation);
+			ViewLocations.Add(viewLocation);
+		}
+	}
+
+	if (ViewLocations.Num() == 0)
+	{
+		for (FConstPlayerControllerIterator iterator = GetWorld()->GetPlayerControllerIterator(); iterator; ++iterator)
+		{
+			if (const APawn* pawn = iterator->Get() != nullptr ? iterator->Get()->GetPawn() : nullptr)
+			{
+				ViewLocations.Add(pawn->GetActorLocation());
+			}
+		}
+	}
+}
+// Significance the actor should have now
+EThrowingWeaponSignificance UThrowingWeaponSignificanceSubsystem::CalculateSignificance(const AActor* actor, EThrowingWeaponSignificance currentSignificance) const
+{
+	if (GThrowingWeaponSignificanceEnabled == 0)
+	{
+		return EThrowingWeaponSignificance::Full;
+	}
+
+	const EThrowingWeaponSignificance stateSignificance = CalculateStateSignificance(actor);
+	if (stateSignificance != EThrowingWeaponSignificance::Reduced || ViewLocations.Num() == 0)
+	{
+		return stateSignificance;
+	}
+
+	// Ticks between frames would show as a stutter, so anything on screen keeps its full rate whatever the distance
+	if (actor->WasRecentlyRendered(GThrowingWeaponSignificanceVisibilityGrace))
+	{
+		return EThrowingWeaponSignificance::Full;
+	}
+
+	double distanceSquared = TNumericLimits<double>::Max();
+	for (const FVector& viewLocation : ViewLocations)
+	{
+		distanceSquared = FMath::Min(distanceSquared, FVector::DistSquared(viewLocation, actor->GetActorLocation()));
+	}
+
+	// Staying at a level reaches further than getting there, so an actor on the border doesn't flip every update
+	const double farDistance = GThrowingWeaponSignificanceFarDistance * (currentSignificance != EThrowingWeaponSignificance::Far ? 1 + GThrowingWeaponSignificanceHysteresis : 1);
+
+	EThrowingWeaponSignificance significance = distanceSquared < FMath::Square(farDistance) ? EThrowingWeaponSignificance::Reduced : EThrowingWeaponSignificance::Far;
+
+	// Drop one level per update, come back up at once
+	if (significance > currentSignificance && currentSignificance != EThrowingWeaponSignificance::EventOnly)
+	{
+		significance = static_cast<EThrowingWeaponSignificance>(static_cast<uint8>(currentSignificance) + 1);
+	}
+	return significance;
+}
+// Full or EventOnly when the state alone decides, Reduced when distance and visibility decide
+EThrowingWeaponSignificance UThrowingWeaponSignificanceSubsystem::CalculateStateSignificance(const AActor* actor) const
+{
+	if (const AThrowingWeaponBase* weapon = Cast<AThrowingWeaponBase>(actor))
+	{
+		// Held and lodged weapons don't tick, a throw or recall wakes them up
+		if (weapon->CurrentThrowingWeaponState == ThrowingWeaponState::Idle || weapon->CurrentThrowingWeaponState == ThrowingWeaponState::Lodged)
+		{
+			return EThrowingWeaponSignificance::EventOnly;
+		}
+
+		// The subsystem moves batched weapons, and the line trace only looks WeaponThrowTraceDistance ahead so longer steps would fly through walls.
+		// Async results are only kept for one frame, so a slower tick would lose every one and trace again synchronously
+		const bool bIsLaunched = weapon->CurrentThrowingWeaponState == ThrowingWeaponState::Launched;
+		if (weapon->bUseBatchedSimulation || (bIsLaunched && (!weapon->bUseContinuousThrowCollision || weapon->bUseAsyncThrowTrace)))
+		{
+			return EThrowingWeaponSignificance::Full;
+		}
+
+		// Players always see their own throw
+		if (weapon->PlayerReference != nullptr && weapon->PlayerReference->IsLocallyControlled())
+		{
+			return EThrowingWeaponSignificance::Full;
+		}
+	}
+	else if (const APlayerCharacterBase* character = Cast<APlayerCharacterBase>(actor))
+	{
+		// Camera, aim assist and the throw preview of the local player run every frame
+		if (character->IsLocallyControlled())
+		{
+			return EThrowingWeaponSignificance::Full;
+		}
+
+		// Only aiming rotates a character nobody controls locally
+		if (!character->bIsAiming)
+		{
+			return EThrowingWeaponSignificance::Far;
+		}
+	}
+	return EThrowingWeaponSignificance::Reduced;
+}
+// Set the tick interval of the actor and, for throwing weapons, their projectile movement
+void UThrowingWeaponSignificanceSubsystem::ApplySignificance(AActor* actor, EThrowingWeaponSignificance significance)
+{
+	const float tickInterval = GetTickInterval(significance);
+
+	// Ticks with an interval get the time since they last ran, so the flight, spin and rotation keep their speed at any rate
+	actor->SetActorTickInterval(tickInterval);
+
+	if (AThrowingWeaponBase* weapon = Cast<AThrowingWeaponBase>(actor))
+	{
+		weapon->ProjectileMovementComponent->SetComponentTickInterval(tickInterval);
+	}
+}
+
+float UThrowingWeaponSignificanceSubsystem::GetTickInterval(EThrowingWeaponSignificance significance)
+{
+	switch (significance)
+	{
+	case EThrowingWeaponSignificance::Reduced:
+		return GThrowingWeaponSignificanceReducedTickInterval;
+
+	case EThrowingWeaponSignificance::Far:
+		return GThrowingWeaponSignificanceFarTickInterval;
+
+	default:
+		// EventOnly actors don't tick, the next state change starts them at full rate until they are scored again
+		return 0;
+	}
+}
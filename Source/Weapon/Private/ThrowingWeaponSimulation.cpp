@@ -0,0 +1,281 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponSimulation.h"
+
+#if !UE_BUILD_SHIPPING
+#include "HAL/IConsoleManager.h"
+#endif
+
+// Midpoint projectile step, the same one the projectile movement component takes. Exact for constant gravity below maxSpeed
+void FThrowingWeaponSimulation::AdvanceFlight(FVector& location, FVector& velocity, float gravityZ, float maxSpeed, float deltaTime)
+{
+	const FVector oldVelocity = velocity;
+	velocity.Z += gravityZ * deltaTime;
+
+	if (maxSpeed > 0)
+	{
+		velocity = velocity.GetClampedToMaxSize(maxSpeed);
+	}
+
+	location += (oldVelocity + velocity) * (0.5f * deltaTime);
+}
+// Spin curve time, held at the end of the curve
+float FThrowingWeaponSimulation::AdvanceSpin(float spinTime, float deltaTime, float spinRate, float curveEndTime)
+{
+	return FMath::Min(spinTime + deltaTime * spinRate, curveEndTime);
+}
+// Rotation tilted by the wiggle curve value
+FRotator FThrowingWeaponSimulation::CalculateWiggleRotation(const FRotator& baseRotation, float wiggleValue)
+{
+	return FRotator(baseRotation.Pitch + wiggleValue * WigglePitch, baseRotation.Yaw, baseRotation.Roll);
+}
+// Flight pitch plus a random tilt for the surface, so weapons lodged in the same wall don't all line up
+float FThrowingWeaponSimulation::CalculateLodgePitch(const FVector& velocity, const FVector& impactNormal)
+{
+	return velocity.ToOrientationRotator().Pitch + AdjustImpactPitch(impactNormal, FMath::RandRange(-30, -45), FMath::RandRange(-25, -35));
+}
+// Rotation of a matrix built from the (normalized) axes
+FRotator FThrowingWeaponSimulation::MakeRotationFromAxes(FVector forward, FVector right, FVector up)
+{
+	forward.Normalize();
+	right.Normalize();
+	up.Normalize();
+
+	FMatrix rotationMatrix(forward, right, up, FVector::ZeroVector);
+
+	return rotationMatrix.Rotator();
+}
+// Actor location that puts the lodged mesh at the impact
+FVector FThrowingWeaponSimulation::AdjustImpactLocation(const FThrowingWeaponImpact& impact)
+{
+	const float normalPitch = MakeRotationFromAxes(impact.ImpactNormal, FVector::ZeroVector, FVector::ZeroVector).Pitch;
+
+	if (normalPitch > 0)
+	{
+		FVector impactNormal = impact.ImpactNormal;
+		impactNormal.Y = ((normalPitch - 90) / 90) * 10;
+
+		const FVector impactLocation = impact.ImpactLocation + impactNormal.Z;
+
+		return impact.LodgePointLocation - impact.ActorLocation + impactLocation;
+	}
+	return impact.ActorLocation - impact.LodgePointLocation + impact.ImpactLocation;
+}
+// Pitch added to the lodge rotation for the surface
+float FThrowingWeaponSimulation::AdjustImpactPitch(const FVector& impactNormal, float inclinedSurfaceRange, float regularSurfaceRange)
+{
+	const float normalPitch = MakeRotationFromAxes(impactNormal, FVector::ZeroVector, FVector::ZeroVector).Pitch;
+
+	// Anything but a near ceiling gets the handle straight up, regularSurfaceRange is kept for tuning but never wins
+	if (normalPitch > -80)
+	{
+		return -90;
+	}
+	return inclinedSurfaceRange;
+}
+// Path and arrival time of a recall, the path bows out to the camera right by curvature times its chord
+FThrowingWeaponReturnPath FThrowingWeaponSimulation::BuildReturnPath(const FThrowingWeaponReturn& weaponReturn, float curvature, float averageSpeed)
+{
+	FThrowingWeaponReturnPath path;
+	path.Start = weaponReturn.InitialLocation;
+	path.EndOffset = weaponReturn.CameraRightVector;
+	path.End = weaponReturn.GripPointLocation + path.EndOffset;
+
+	const float chord = FVector::Dist(path.Start, path.End);
+	path.Control = (path.Start + path.End) * 0.5 + weaponReturn.CameraRightVector.GetSafeNormal() * (chord * curvature);
+
+	path.Length = CalculateQuadraticBezierLength(path.Start, path.Control, path.End);
+	path.Duration = CalculateReturnDuration(path.Length, averageSpeed);
+	return path;
+}
+// Exact arc length of a quadratic Bezier, the integral of its speed in closed form
+float FThrowingWeaponSimulation::CalculateQuadraticBezierLength(const FVector& start, const FVector& control, const FVector& end)
+{
+	// Speed squared along the path is a * t^2 + b * t + c
+	const FVector acceleration = start - control * 2 + end;
+	const FVector velocity = (control - start) * 2;
+
+	const double a = 4 * acceleration.SizeSquared();
+	const double b = 4 * FVector::DotProduct(acceleration, velocity);
+	const double c = velocity.SizeSquared();
+
+	// Control point on the chord (straight path), or a path that doubles back through a cusp
+	const double chord = FVector::Dist(start, end);
+	if (a < UE_KINDA_SMALL_NUMBER || c < UE_KINDA_SMALL_NUMBER)
+	{
+		return a < UE_KINDA_SMALL_NUMBER ? chord : FMath::Sqrt(a) * 0.5;
+	}
+
+	const double speedAtEnd = 2 * FMath::Sqrt(a + b + c);
+	const double sqrtA = FMath::Sqrt(a);
+	const double sqrtA3 = 2 * a * sqrtA;
+	const double speedAtStart = 2 * FMath::Sqrt(c);
+	const double bOverSqrtA = b / sqrtA;
+	const double logDenominator = bOverSqrtA + speedAtStart;
+
+	if (logDenominator <= UE_KINDA_SMALL_NUMBER)
+	{
+		return chord;
+	}
+
+	const double length = (sqrtA3 * speedAtEnd + sqrtA * b * (speedAtEnd - speedAtStart) + (4 * c * a - b * b) * FMath::Loge((2 * sqrtA + bOverSqrtA + speedAtEnd) / logDenominator)) / (4 * sqrtA3);
+
+	// Never shorter than the chord, rounding on an almost straight path can undershoot it
+	return FMath::Max(length, chord);
+}
+// Seconds to travel the path at averageSpeed, a path of zero length still takes one frame or so
+float FThrowingWeaponSimulation::CalculateReturnDuration(float pathLength, float averageSpeed)
+{
+	const float minDuration = 0.05f;
+
+	if (averageSpeed <= 0)
+	{
+		return minDuration;
+	}
+	return FMath::Max(pathLength / averageSpeed, minDuration);
+}
+// Play rate that finishes the return curve exactly when the weapon arrives
+float FThrowingWeaponSimulation::CalculateReturnPlayRate(float returnDuration, float curveEndTime)
+{
+	return curveEndTime / FMath::Max(returnDuration, UE_KINDA_SMALL_NUMBER);
+}
+// Flight between two traces split at maxStepTime, then lookAheadDistance along the velocity. The points in between come from the
+// cubic Hermite curve through both samples, which is exact for a flight under constant gravity however the flight was substepped
+void FThrowingWeaponSimulation::BuildSweepPath(const FThrowingWeaponFlightSample& from, const FThrowingWeaponFlightSample& to, float maxStepTime, float lookAheadDistance, FThrowingWeaponSweepPath& outPath)
+{
+	outPath.Reset();
+	outPath.Add(from.Location);
+
+	const float elapsedTime = static_cast<float>(to.Time - from.Time);
+	const int32 numSubsteps = elapsedTime > 0 && maxStepTime > 0 ? FMath::Clamp(FMath::CeilToInt(elapsedTime / maxStepTime), 1, MaxSweepSubsteps) : 1;
+
+	for (int32 i = 1; i < numSubsteps; i++)
+	{
+		const float s = static_cast<float>(i) / numSubsteps;
+		const float s2 = s * s;
+		const float s3 = s2 * s;
+
+		outPath.Add(from.Location * (2 * s3 - 3 * s2 + 1) + from.Velocity * (elapsedTime * (s3 - 2 * s2 + s))
+			+ to.Location * (3 * s2 - 2 * s3) + to.Velocity * (elapsedTime * (s3 - s2)));
+	}
+	outPath.Add(to.Location);
+
+	if (lookAheadDistance > 0 && !to.Velocity.IsNearlyZero())
+	{
+		outPath.Add(to.Location + to.Velocity.GetSafeNormal() * lookAheadDistance);
+	}
+}
+// ReturnOptimalDistance per play of the return curve at returnSpeed
+float FThrowingWeaponSimulation::CalculateReturnAverageSpeed(float returnSpeed, float curveEndTime)
+{
+	return ReturnOptimalDistance * returnSpeed / GetReturnCurveEndTime(curveEndTime);
+}
+// Time the return curve is played to, a constant curve has no duration and is played over one second instead
+float FThrowingWeaponSimulation::GetReturnCurveEndTime(float curveEndTime)
+{
+	return curveEndTime > 0 ? curveEndTime : 1;
+}
+// Progress along the return path. A constant curve has no shape to follow, so the weapon moves linearly in time
+float FThrowingWeaponSimulation::CalculateReturnAlpha(float curveValue, float returnTime, float curveEndTime)
+{
+	return curveEndTime > 0 ? curveValue : FMath::Clamp(returnTime, 0.f, 1.f);
+}
+// Has the return curve played to its (guarded) end?
+bool FThrowingWeaponSimulation::IsReturnFinished(float returnTime, float curveEndTime)
+{
+	return returnTime >= GetReturnCurveEndTime(curveEndTime);
+}
+// Pose at returnAlpha (0 start, 1 at the player). The player moving since the recall is blended in along the path
+FThrowingWeaponReturnPose FThrowingWeaponSimulation::CalculateReturnPose(const FThrowingWeaponReturnPath& path, const FVector& gripPointLocation, const FRotator& gripPointRotation, float returnAlpha)
+{
+	const float inverseAlpha = 1 - returnAlpha;
+	const FVector retarget = gripPointLocation + path.EndOffset - path.End;
+
+	FThrowingWeaponReturnPose pose;
+	pose.Location = path.Start * (inverseAlpha * inverseAlpha) + path.Control * (2 * inverseAlpha * returnAlpha) + path.End * (returnAlpha * returnAlpha) + retarget * returnAlpha;
+	pose.Rotation = gripPointRotation;
+	return pose;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/// <summary>
+/// Weapon.Simulation.Benchmark, runs without a world. The known answers are automation tests (Weapon.Simulation)
+/// </summary>
+struct FThrowingWeaponSimulationChecks
+{
+	static void Benchmark(const TArray<FString>& args); // Nanoseconds per call of every function
+
+	template<typename FunctionType>
+	static double TimeNanosecondsPerCall(int32 iterations, FunctionType&& function); // Run function(i) for every iteration
+};
+
+template<typename FunctionType>
+double FThrowingWeaponSimulationChecks::TimeNanosecondsPerCall(int32 iterations, FunctionType&& function)
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+
+	for (int32 i = 0; i < iterations; i++)
+	{
+		function(i);
+	}
+
+	return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles) * 1000000.0 / iterations;
+}
+
+void FThrowingWeaponSimulationChecks::Benchmark(const TArray<FString>& args)
+{
+	const int32 iterations = args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*args[0])) : 1000000;
+
+	// Inputs are made before timing, a small power of two set keeps them in cache and the index a mask
+	const int32 numInputs = 1024;
+	TArray<FThrowingWeaponImpact> impacts;
+	TArray<FThrowingWeaponReturn> returns;
+	TArray<FThrowingWeaponReturnPath> paths;
+
+	FRandomStream random(0);
+	for (int32 i = 0; i < numInputs; i++)
+	{
+		FThrowingWeaponImpact& impact = impacts.AddDefaulted_GetRef();
+		impact.ImpactNormal = random.GetUnitVector();
+		impact.ImpactLocation = random.GetUnitVector() * 1000;
+		impact.ActorLocation = random.GetUnitVector() * 1000;
+		impact.LodgePointLocation = impact.ActorLocation + random.GetUnitVector() * 20;
+
+		FThrowingWeaponReturn& weaponReturn = returns.AddDefaulted_GetRef();
+		weaponReturn.InitialLocation = random.GetUnitVector() * 2000;
+		weaponReturn.GripPointLocation = random.GetUnitVector() * 100;
+		weaponReturn.GripPointRotation = random.GetUnitVector().Rotation();
+		weaponReturn.CameraRightVector = random.GetUnitVector();
+
+		paths.Add(FThrowingWeaponSimulation::BuildReturnPath(weaponReturn, 0.25f, 1400));
+	}
+
+	// Summed into a volatile so the calls aren't optimized away
+	double sink = 0;
+	const int32 mask = numInputs - 1;
+
+	const double rotationNs = TimeNanosecondsPerCall(iterations, [&](int32 i) { sink += FThrowingWeaponSimulation::MakeRotationFromAxes(impacts[i & mask].ImpactNormal, FVector::ZeroVector, FVector::ZeroVector).Pitch; });
+	const double locationNs = TimeNanosecondsPerCall(iterations, [&](int32 i) { sink += FThrowingWeaponSimulation::AdjustImpactLocation(impacts[i & mask]).X; });
+	const double pitchNs = TimeNanosecondsPerCall(iterations, [&](int32 i) { sink += FThrowingWeaponSimulation::AdjustImpactPitch(impacts[i & mask].ImpactNormal, -40, -30); });
+	const double pathNs = TimeNanosecondsPerCall(iterations, [&](int32 i) { sink += FThrowingWeaponSimulation::BuildReturnPath(returns[i & mask], 0.25f, 1400).Duration; });
+	const double poseNs = TimeNanosecondsPerCall(iterations, [&](int32 i) { sink += FThrowingWeaponSimulation::CalculateReturnPose(paths[i & mask], returns[i & mask].GripPointLocation, returns[i & mask].GripPointRotation, (i & mask) / static_cast<float>(mask)).Location.X; });
+
+	volatile double result = sink;
+	(void)result;
+
+	UE_LOG(LogTemp, Display, TEXT("Throwing weapon simulation benchmark (%d calls each, ns per call):"), iterations);
+	UE_LOG(LogTemp, Display, TEXT("  MakeRotationFromAxes    %8.2f"), rotationNs);
+	UE_LOG(LogTemp, Display, TEXT("  AdjustImpactLocation    %8.2f"), locationNs);
+	UE_LOG(LogTemp, Display, TEXT("  AdjustImpactPitch       %8.2f"), pitchNs);
+	UE_LOG(LogTemp, Display, TEXT("  BuildReturnPath         %8.2f"), pathNs);
+	UE_LOG(LogTemp, Display, TEXT("  CalculateReturnPose     %8.2f"), poseNs);
+}
+
+static FAutoConsoleCommand CmdThrowingWeaponSimulationBenchmark(
+	TEXT("Weapon.Simulation.Benchmark"),
+	TEXT("Time every throwing weapon lodge and return function. Optional argument: calls per function (default 1000000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FThrowingWeaponSimulationChecks::Benchmark));
+
+#endif
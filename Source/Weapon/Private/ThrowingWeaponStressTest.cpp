@@ -0,0 +1,397 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponStressTest.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThrowingWeaponSubsystem.h"
+#include "Containers/Ticker.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+
+/// <summary>
+/// Budgets the stress test fails on, 0 turns a budget off. The defaults hold for 100 weapons in a Development build with
+/// -nullrhi, set them in DefaultEngine.ini [ConsoleVariables] or on the command line for other machines
+/// </summary>
+
+static float GThrowingWeaponStressBudgetMedianMs = 8;
+static FAutoConsoleVariableRef CVarThrowingWeaponStressBudgetMedianMs(
+	TEXT("Weapon.Stress.BudgetMedianMs"),
+	GThrowingWeaponStressBudgetMedianMs,
+	TEXT("Fail the throwing weapon stress test when the median game thread frame is slower than this (ms, 0: no budget)"));
+
+static float GThrowingWeaponStressBudgetP99Ms = 20;
+static FAutoConsoleVariableRef CVarThrowingWeaponStressBudgetP99Ms(
+	TEXT("Weapon.Stress.BudgetP99Ms"),
+	GThrowingWeaponStressBudgetP99Ms,
+	TEXT("Fail the throwing weapon stress test when the 99th percentile game thread frame is slower than this (ms, 0: no budget)"));
+
+static float GThrowingWeaponStressBudgetMemoryMB = 32;
+static FAutoConsoleVariableRef CVarThrowingWeaponStressBudgetMemoryMB(
+	TEXT("Weapon.Stress.BudgetMemoryMB"),
+	GThrowingWeaponStressBudgetMemoryMB,
+	TEXT("Fail the throwing weapon stress test when used physical memory grows by more than this over the run (MB, 0: no budget)"));
+
+// Spawn every weapon on a grid above the player (or the world origin)
+void FThrowingWeaponStressTest::SpawnWeapons(UWorld* world)
+{
+	const int32 gridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumWeapons)));
+
+	for (int32 i = 0; i < NumWeapons; i++)
+	{
+		const FVector location = Origin + FVector((i % gridSize - gridSize / 2) * 150, (i / gridSize - gridSize / 2) * 150, 0);
+
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		spawnParameters.bDeferConstruction = true;
+
+		ADefaultThrowingWeapon* weapon = world->SpawnActor<ADefaultThrowingWeapon>(WeaponClass, FTransform(location), spawnParameters);
+		weapon->SetUseBatchedSimulation(bBatched);
+		weapon->FinishSpawning(FTransform(location));
+
+		Weapons.Add(weapon);
+		ThrowLocations.Add(location);
+	}
+}
+// Throw every weapon down at the ground so it lodges
+void FThrowingWeaponStressTest::ThrowWeapons()
+{
+	FRandomStream random(Cycle);
+
+	for (int32 i = 0; i < Weapons.Num(); i++)
+	{
+		if (ADefaultThrowingWeapon* weapon = Weapons[i].Get())
+		{
+			const FVector throwDirection = FVector(random.FRandRange(-0.3f, 0.3f), random.FRandRange(-0.3f, 0.3f), -1).GetSafeNormal();
+			weapon->ThrowWeapon(throwDirection.Rotation(), throwDirection, ThrowLocations[i], 0);
+		}
+	}
+}
+// Recall every weapon, lodged ones wiggle loose first
+void FThrowingWeaponStressTest::RecallWeapons()
+{
+	for (const TWeakObjectPtr<ADefaultThrowingWeapon>& weapon : Weapons)
+	{
+		if (weapon.IsValid())
+		{
+			weapon->RecallThrowingWeapon();
+		}
+	}
+}
+
+bool FThrowingWeaponStressTest::AreAllWeaponsInState(ThrowingWeaponState state) const
+{
+	for (const TWeakObjectPtr<ADefaultThrowingWeapon>& weapon : Weapons)
+	{
+		if (weapon.IsValid() && weapon->CurrentThrowingWeaponState != state)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+// Step the test once per engine frame, false once it is finished
+bool FThrowingWeaponStressTest::Tick(float deltaTime)
+{
+	if (!World.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Throwing weapon stress test stopped, its world is gone"));
+		return false;
+	}
+
+	// GGameThreadTime is the previous frame, so the first frame after spawning isn't measured
+	if (Frame > 0)
+	{
+		FrameMilliseconds.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+		const UThrowingWeaponSubsystem* throwingWeaponSubsystem = UWorld::GetSubsystem<UThrowingWeaponSubsystem>(World.Get());
+		if (bBatched && throwingWeaponSubsystem != nullptr)
+		{
+			SimulationMilliseconds.Add(throwingWeaponSubsystem->GetLastSimulationMilliseconds());
+		}
+	}
+	PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	Frame++;
+	PhaseFrame++;
+
+	switch (Phase)
+	{
+	case EPhase::Flight:
+		// Weapons that never hit anything are recalled out of the air
+		if (AreAllWeaponsInState(ThrowingWeaponState::Lodged) || PhaseFrame >= MaxPhaseFrames)
+		{
+			NumTimedOutPhases += PhaseFrame >= MaxPhaseFrames ? 1 : 0;
+			RecallWeapons();
+			Phase = EPhase::Return;
+			PhaseFrame = 0;
+		}
+		break;
+
+	case EPhase::Return:
+		if (AreAllWeaponsInState(ThrowingWeaponState::Idle) || PhaseFrame >= MaxPhaseFrames)
+		{
+			NumTimedOutPhases += PhaseFrame >= MaxPhaseFrames ? 1 : 0;
+
+			for (const TWeakObjectPtr<ADefaultThrowingWeapon>& weapon : Weapons)
+			{
+				if (weapon.IsValid())
+				{
+					weapon->SetThrowingWeaponState(ThrowingWeaponState::Idle);
+				}
+			}
+
+			Cycle++;
+			if (Cycle >= NumCycles)
+			{
+				Finish();
+				return false;
+			}
+
+			ThrowWeapons();
+			Phase = EPhase::Flight;
+			PhaseFrame = 0;
+		}
+		break;
+	}
+	return true;
+}
+// Nearest rank percentile of already sorted values
+float FThrowingWeaponStressTest::GetPercentile(const TArray<float>& sortedValues, float percentile)
+{
+	if (sortedValues.Num() == 0)
+	{
+		return 0;
+	}
+
+	const int32 index = FMath::Clamp(FMath::CeilToInt(percentile * sortedValues.Num()) - 1, 0, sortedValues.Num() - 1);
+	return sortedValues[index];
+}
+// Check the budgets, write the report and clean up
+void FThrowingWeaponStressTest::Finish()
+{
+	TArray<float> sortedMilliseconds = FrameMilliseconds;
+	sortedMilliseconds.Sort();
+
+	MedianMs = GetPercentile(sortedMilliseconds, 0.5f);
+	const float p90Ms = GetPercentile(sortedMilliseconds, 0.9f);
+	P99Ms = GetPercentile(sortedMilliseconds, 0.99f);
+	const float maxMs = sortedMilliseconds.Num() > 0 ? sortedMilliseconds.Last() : 0;
+
+	TArray<float> sortedSimulationMilliseconds = SimulationMilliseconds;
+	sortedSimulationMilliseconds.Sort();
+
+	const float simulationMedianMs = GetPercentile(sortedSimulationMilliseconds, 0.5f);
+	const float simulationP99Ms = GetPercentile(sortedSimulationMilliseconds, 0.99f);
+	MemoryGrowthMB = ToMB(FPlatformMemory::GetStats().UsedPhysical) - ToMB(UsedPhysicalAtStart);
+
+	bPassed = true;
+
+	auto checkBudget = [this](const TCHAR* name, double value, float budget)
+	{
+		if (budget > 0 && value > budget)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Throwing weapon stress test over budget: %s %.3f > %.3f"), name, value, budget);
+			bPassed = false;
+		}
+	};
+
+	checkBudget(TEXT("median ms"), MedianMs, GThrowingWeaponStressBudgetMedianMs);
+	checkBudget(TEXT("p99 ms"), P99Ms, GThrowingWeaponStressBudgetP99Ms);
+	checkBudget(TEXT("memory growth MB"), MemoryGrowthMB, GThrowingWeaponStressBudgetMemoryMB);
+
+	UE_LOG(LogTemp, Display, TEXT("Throwing weapon stress test: %d weapons (%s), %d cycles, %d frames: median %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms, memory +%.1f MB (spawn +%.1f MB), %s"),
+		NumWeapons, bBatched ? TEXT("batched") : TEXT("per actor"), NumCycles, FrameMilliseconds.Num(),
+		MedianMs, p90Ms, P99Ms, maxMs, MemoryGrowthMB, ToMB(UsedPhysicalAfterSpawn) - ToMB(UsedPhysicalAtStart), bPassed ? TEXT("passed") : TEXT("FAILED"));
+
+	if (bBatched)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Throwing weapon stress test batched simulation: median %.3f ms, p99 %.3f ms (%d max tasks, %d worker threads)"),
+			simulationMedianMs, simulationP99Ms, ParallelTasks, FTaskGraphInterface::Get().GetNumWorkerThreads());
+	}
+
+	if (NumTimedOutPhases > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Throwing weapon stress test: %d phases timed out after %d frames, some weapons never lodged or arrived"), NumTimedOutPhases, MaxPhaseFrames);
+	}
+
+	if (!WriteReport(p90Ms, maxMs, simulationMedianMs, simulationP99Ms))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write the throwing weapon stress report to %s"), *ReportPath);
+	}
+
+	for (const TWeakObjectPtr<ADefaultThrowingWeapon>& weapon : Weapons)
+	{
+		if (weapon.IsValid())
+		{
+			weapon->Destroy();
+		}
+	}
+	Weapons.Reset();
+
+	if (ParallelTasks >= 0)
+	{
+		if (IConsoleVariable* parallelTasksVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("Weapon.Batch.ParallelMaxTasks")))
+		{
+			parallelTasksVariable->Set(PreviousParallelTasks, ECVF_SetByCode);
+		}
+	}
+
+	if (bQuitWhenFinished)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+// Machine readable result: settings, frame time percentiles, memory, budgets and every frame time
+bool FThrowingWeaponStressTest::WriteReport(float p90Ms, float maxMs, float simulationMedianMs, float simulationP99Ms) const
+{
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+
+	writer->WriteObjectStart();
+	writer->WriteValue(TEXT("map"), World.IsValid() ? World->GetMapName() : FString());
+	writer->WriteValue(TEXT("buildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	writer->WriteValue(TEXT("weapons"), NumWeapons);
+	writer->WriteValue(TEXT("cycles"), NumCycles);
+	writer->WriteValue(TEXT("batched"), bBatched);
+	writer->WriteValue(TEXT("parallelTasks"), ParallelTasks);
+	writer->WriteValue(TEXT("workerThreads"), FTaskGraphInterface::Get().GetNumWorkerThreads());
+	writer->WriteValue(TEXT("frames"), FrameMilliseconds.Num());
+	writer->WriteValue(TEXT("timedOutPhases"), NumTimedOutPhases);
+
+	writer->WriteObjectStart(TEXT("gameThreadMs"));
+	writer->WriteValue(TEXT("median"), MedianMs);
+	writer->WriteValue(TEXT("p90"), p90Ms);
+	writer->WriteValue(TEXT("p99"), P99Ms);
+	writer->WriteValue(TEXT("max"), maxMs);
+	writer->WriteObjectEnd();
+
+	writer->WriteObjectStart(TEXT("simulationMs"));
+	writer->WriteValue(TEXT("median"), simulationMedianMs);
+	writer->WriteValue(TEXT("p99"), simulationP99Ms);
+	writer->WriteObjectEnd();
+
+	writer->WriteObjectStart(TEXT("memoryMB"));
+	writer->WriteValue(TEXT("usedAtStart"), ToMB(UsedPhysicalAtStart));
+	writer->WriteValue(TEXT("usedAfterSpawn"), ToMB(UsedPhysicalAfterSpawn));
+	writer->WriteValue(TEXT("peakUsed"), ToMB(PeakUsedPhysical));
+	writer->WriteValue(TEXT("growth"), MemoryGrowthMB);
+	writer->WriteObjectEnd();
+
+	writer->WriteObjectStart(TEXT("budgets"));
+	writer->WriteValue(TEXT("medianMs"), GThrowingWeaponStressBudgetMedianMs);
+	writer->WriteValue(TEXT("p99Ms"), GThrowingWeaponStressBudgetP99Ms);
+	writer->WriteValue(TEXT("memoryMB"), GThrowingWeaponStressBudgetMemoryMB);
+	writer->WriteObjectEnd();
+
+	writer->WriteValue(TEXT("passed"), bPassed);
+
+	writer->WriteArrayStart(TEXT("frameMs"));
+	for (float milliseconds : FrameMilliseconds)
+	{
+		writer->WriteValue(milliseconds);
+	}
+	writer->WriteArrayEnd();
+
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	const bool bWritten = FFileHelper::SaveStringToFile(json, *ReportPath);
+	if (bWritten)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Throwing weapon stress report written to %s"), *ReportPath);
+	}
+	return bWritten;
+}
+// Spawn and throw the weapons, null without a game world
+TSharedPtr<FThrowingWeaponStressTest> FThrowingWeaponStressTest::Start(const FString& arguments, UWorld* world)
+{
+	if (world == nullptr || !world->IsGameWorld())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The throwing weapon stress test needs a game world"));
+		return nullptr;
+	}
+
+	TSharedRef<FThrowingWeaponStressTest> test = MakeShared<FThrowingWeaponStressTest>();
+	test->World = world;
+	test->WeaponClass = ADefaultThrowingWeapon::StaticClass();
+
+	FParse::Value(*arguments, TEXT("Weapons="), test->NumWeapons);
+	FParse::Value(*arguments, TEXT("Cycles="), test->NumCycles);
+	FParse::Value(*arguments, TEXT("MaxPhaseFrames="), test->MaxPhaseFrames);
+	FParse::Bool(*arguments, TEXT("Batched="), test->bBatched);
+	FParse::Value(*arguments, TEXT("Tasks="), test->ParallelTasks);
+	test->bQuitWhenFinished = FParse::Param(*arguments, TEXT("Quit"));
+	test->NumWeapons = FMath::Max(1, test->NumWeapons);
+	test->NumCycles = FMath::Max(1, test->NumCycles);
+
+	FString reportName = FString::Printf(TEXT("ThrowingWeaponStress-%s.json"), *FDateTime::Now().ToString());
+	FParse::Value(*arguments, TEXT("Report="), reportName);
+	test->ReportPath = FPaths::IsRelative(reportName) ? FPaths::Combine(FPaths::ProfilingDir(), reportName) : reportName;
+
+	// Throw the weapon the level already uses so the Blueprint curves and mesh are measured
+	for (TActorIterator<ADefaultThrowingWeapon> it(world); it; ++it)
+	{
+		test->WeaponClass = it->GetClass();
+		break;
+	}
+
+	if (APlayerController* playerController = world->GetFirstPlayerController())
+	{
+		if (APawn* pawn = playerController->GetPawn())
+		{
+			test->Origin = pawn->GetActorLocation();
+		}
+	}
+	test->Origin.Z += 300;
+
+	// Running the same batched test with Tasks=1, 2, 4, ... shows how the simulation scales with cores
+	if (test->ParallelTasks >= 0)
+	{
+		if (IConsoleVariable* parallelTasksVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("Weapon.Batch.ParallelMaxTasks")))
+		{
+			test->PreviousParallelTasks = parallelTasksVariable->GetInt();
+			parallelTasksVariable->Set(test->ParallelTasks, ECVF_SetByCode);
+		}
+	}
+
+	test->UsedPhysicalAtStart = FPlatformMemory::GetStats().UsedPhysical;
+	test->SpawnWeapons(world);
+	test->UsedPhysicalAfterSpawn = FPlatformMemory::GetStats().UsedPhysical;
+	test->PeakUsedPhysical = test->UsedPhysicalAfterSpawn;
+
+	test->ThrowWeapons();
+
+	return test;
+}
+// Weapon.Stress.Run console command
+void FThrowingWeaponStressTest::Run(const TArray<FString>& args, UWorld* world)
+{
+	const TSharedPtr<FThrowingWeaponStressTest> test = Start(FString::Join(args, TEXT(" ")), world);
+	if (!test.IsValid())
+	{
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([test](float deltaTime)
+	{
+		return test->Tick(deltaTime);
+	}));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdThrowingWeaponStressRun(
+	TEXT("Weapon.Stress.Run"),
+	TEXT("Throw/lodge/recall N throwing weapons and write a JSON report with game thread frame times and memory. ")
+	TEXT("Arguments: Weapons=100 Cycles=5 MaxPhaseFrames=600 Batched=false Tasks=<batched simulation worker tasks, 0 one per core> Report=<file> -Quit (exit with 0 passed, 1 over budget)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FThrowingWeaponStressTest::Run));
+
+#endif
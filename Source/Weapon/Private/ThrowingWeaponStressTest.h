@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "DefaultThrowingWeapon.h"
+
+/// <summary>
+/// Weapon.Stress.Run: spawns N throwing weapons and runs them through throw/lodge/wiggle/recall cycles while recording
+/// game thread time per frame and memory. Works headless (-nullrhi), writes a JSON report and can exit with the result.
+/// The Weapon.Stress automation tests run it with the default settings and fail on the budgets
+/// </summary>
+struct FThrowingWeaponStressTest
+{
+	enum class EPhase : uint8
+	{
+		Flight, // Thrown, waiting for the weapons to lodge
+		Return, // Recalled, waiting for the weapons to arrive
+	};
+
+	TWeakObjectPtr<UWorld> World;
+	TSubclassOf<ADefaultThrowingWeapon> WeaponClass; // Class of the weapons thrown
+	TArray<TWeakObjectPtr<ADefaultThrowingWeapon>> Weapons;
+	TArray<FVector> ThrowLocations; // Where each weapon is thrown from every cycle
+	FVector Origin = FVector::ZeroVector; // Center of the weapon grid
+
+	int32 NumWeapons = 100;
+	int32 NumCycles = 5;
+	int32 MaxPhaseFrames = 600; // A phase ends after this many frames even if some weapons never lodged or arrived
+	bool bBatched = false; // Use UThrowingWeaponSubsystem instead of per actor ticks
+	int32 ParallelTasks = -1; // Weapon.Batch.ParallelMaxTasks during the run (0: one per core), -1 leaves it as it is
+	int32 PreviousParallelTasks = 0; // Restored when the run ends
+	bool bQuitWhenFinished = false; // Exit the process with the result (0 passed, 1 failed)
+	FString ReportPath;
+
+	int32 Cycle = 0;
+	EPhase Phase = EPhase::Flight;
+	int32 PhaseFrame = 0;
+	int32 Frame = 0;
+	int32 NumTimedOutPhases = 0; // Phases ended by MaxPhaseFrames, some weapons never lodged or arrived
+
+	TArray<float> FrameMilliseconds; // Game thread time of every measured frame
+	TArray<float> SimulationMilliseconds; // Batched simulation time of every measured frame, workers included (batched runs only)
+	uint64 UsedPhysicalAtStart = 0;
+	uint64 UsedPhysicalAfterSpawn = 0;
+	uint64 PeakUsedPhysical = 0;
+
+	// Results, set once the test is finished
+	float MedianMs = 0;
+	float P99Ms = 0;
+	double MemoryGrowthMB = 0;
+	bool bPassed = false;
+
+	bool Tick(float deltaTime); // Step the test, false once it is finished
+
+	void SpawnWeapons(UWorld* world);
+	void ThrowWeapons();
+	void RecallWeapons();
+	bool AreAllWeaponsInState(ThrowingWeaponState state) const;
+	void Finish();
+	bool WriteReport(float p90Ms, float maxMs, float simulationMedianMs, float simulationP99Ms) const;
+
+	static float GetPercentile(const TArray<float>& sortedValues, float percentile);
+	static double ToMB(uint64 bytes) { return bytes / (1024.0 * 1024.0); }
+
+	static TSharedPtr<FThrowingWeaponStressTest> Start(const FString& arguments, UWorld* world); // Spawn and throw the weapons, null without a game world
+
+	static void Run(const TArray<FString>& args, UWorld* world); // Weapon.Stress.Run console command
+};
+
+#endif
@@ -0,0 +1,813 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponSubsystem.h"
+#include "GameFrameWork/ProjectileMovementComponent.h"
+#include "Struct/public/BakedCurve.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "CoreGlobals.h"
+#include "DefaultThrowingWeapon.h"
+#include "PlayerCharacter/Public/PlayerCharacterBase.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Async/ParallelFor.h"
+#include "WeaponStats.h"
+
+static bool GThrowingWeaponParallelSimulation = true;
+static FAutoConsoleVariableRef CVarThrowingWeaponParallelSimulation(
+	TEXT("Weapon.Batch.Parallel"),
+	GThrowingWeaponParallelSimulation,
+	TEXT("Run the pure part of the batched throwing weapon simulation on task graph workers (0: all of it on the game thread)"));
+
+static int32 GThrowingWeaponParallelMinChunk = 64;
+static FAutoConsoleVariableRef CVarThrowingWeaponParallelMinChunk(
+	TEXT("Weapon.Batch.ParallelMinChunk"),
+	GThrowingWeaponParallelMinChunk,
+	TEXT("Fewest weapons per worker task of the batched simulation, smaller batches stay on the game thread"));
+
+static int32 GThrowingWeaponParallelMaxTasks = 0;
+static FAutoConsoleVariableRef CVarThrowingWeaponParallelMaxTasks(
+	TEXT("Weapon.Batch.ParallelMaxTasks"),
+	GThrowingWeaponParallelMaxTasks,
+	TEXT("Most worker tasks per batch of the batched simulation (0: one per worker thread and one for the game thread)"));
+
+#if !UE_BUILD_SHIPPING
+
+/// <summary>
+/// Weapon.Batch.Benchmark: throws the same number of weapons with and without batched simulation and compares game thread time
+/// </summary>
+struct FThrowingWeaponBatchBenchmark
+{
+	TSubclassOf<ADefaultThrowingWeapon> WeaponClass; // Class of the weapons thrown
+	TArray<int32> WeaponCounts; // How many weapons each run throws, 0 is the empty baseline
+	TArray<ADefaultThrowingWeapon*> SpawnedWeapons; // Weapons of the current run
+	TArray<double> GameThreadMilliseconds; // Average game thread time per run, same order as the runs
+	int32 FramesPerRun = 120; // Measured frames per run (launched for the first half, returning for the second)
+	int32 WarmupFrames = 5; // Frames skipped after spawning
+	int32 RunIndex = 0; // Index into WeaponCounts * 2 (per actor, then batched)
+	int32 RunFrame = 0; // Frame inside the current run
+	double AccumulatedMilliseconds = 0;
+	FVector Origin = FVector::ZeroVector; // Where the weapons are thrown from
+
+	int32 GetNumRuns() const { return WeaponCounts.Num() * 2; }
+	int32 GetWeaponCount(int32 runIndex) const { return WeaponCounts[runIndex / 2]; }
+	bool IsBatchedRun(int32 runIndex) const { return runIndex % 2 == 1; }
+
+	static void Tick(UThrowingWeaponSubsystem& subsystem); // Step the running benchmark, called once per subsystem tick
+	static void StartRun(UThrowingWeaponSubsystem& subsystem, FThrowingWeaponBatchBenchmark& benchmark); // Throw every weapon of the run
+	static void FinishRun(FThrowingWeaponBatchBenchmark& benchmark); // Destroy the weapons of the finished run
+	static void LogResults(const FThrowingWeaponBatchBenchmark& benchmark); // Print per actor against batched cost
+	static void Run(const TArray<FString>& args, UWorld* world); // Weapon.Batch.Benchmark console command
+};
+
+#endif
+
+// Evaluate one curve per weapon of [start, start + count), every run of weapons sharing a table goes through the vectorized batch evaluator
+static void EvaluateBatchedCurves(const TArray<FThrowingWeaponBatchParams>& params, const FBakedCurve* FThrowingWeaponBatchParams::* curve, const TArray<float>& times, TArray<float>& outValues, int32 start, int32 count)
+{
+	const int32 end = start + count;
+
+	int32 runStart = start;
+	while (runStart < end)
+	{
+		const FBakedCurve* runCurve = params[runStart].*curve;
+
+		int32 runEnd = runStart + 1;
+		while (runEnd < end && params[runEnd].*curve == runCurve)
+		{
+			runEnd++;
+		}
+
+		runCurve->EvaluateBatch(times.GetData() + runStart, outValues.GetData() + runStart, runEnd - runStart);
+		runStart = runEnd;
+	}
+}
+
+// Split numWeapons into contiguous chunks and run function(start, count) for each on the task graph workers, the game thread
+// takes a chunk too and waits for the rest. Chunks write only their own slots, so the batch arrays need no locks
+static void ForEachSimulationChunk(int32 numWeapons, TFunctionRef<void(int32, int32)> function)
+{
+	if (numWeapons == 0)
+	{
+		return;
+	}
+
+	const int32 maxTasks = GThrowingWeaponParallelMaxTasks > 0 ? GThrowingWeaponParallelMaxTasks : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 numChunks = GThrowingWeaponParallelSimulation ? FMath::Clamp(numWeapons / FMath::Max(GThrowingWeaponParallelMinChunk, 1), 1, maxTasks) : 1;
+	const int32 chunkSize = FMath::DivideAndRoundUp(numWeapons, numChunks);
+
+	ParallelFor(numChunks, [&](int32 chunkIndex)
+	{
+		const int32 start = chunkIndex * chunkSize;
+		if (start < numWeapons)
+		{
+			function(start, FMath::Min(chunkSize, numWeapons - start));
+		}
+	}, numChunks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+// Append a weapon, filling every array from its current state
+int32 FThrowingWeaponBatch::Add(AThrowingWeaponBase* weapon)
+{
+	FThrowingWeaponBatchParams params;
+	params.SpinCurve = weapon->SpinCurveTable.Get();
+	params.ReturnSpeedCurve = weapon->ReturnSpeedCurveTable.Get();
+	params.WiggleCurve = weapon->WiggleCurveTable.Get();
+	params.SpinRate = weapon->ThrowingWeaponSpinRate;
+	params.SpinMultiplier = weapon->ThrowingWeaponRotationMultiplier;
+	params.GravityZ = weapon->ProjectileMovementComponent->ShouldApplyGravity()
+		? weapon->GetWorld()->GetGravityZ() * weapon->ProjectileMovementComponent->ProjectileGravityScale : 0;
+	params.MaxSpeed = weapon->ProjectileMovementComponent->GetMaxSpeed();
+	params.ReturnPlayRate = weapon->ReturnPlayRate;
+	params.LodgePointBaseRotation = weapon->LodgePointBaseRotation;
+
+	const bool bIsLaunched = weapon->CurrentThrowingWeaponState == ThrowingWeaponState::Launched;
+
+	Weapons.Add(weapon);
+	Locations.Add(bIsLaunched ? weapon->GetActorLocation() : weapon->InitialLocation);
+	Velocities.Add(weapon->ProjectileMovementComponent->Velocity);
+	StateTimes.Add(0);
+	ReturnTimes.Add(0);
+	return Params.Add(params);
+}
+// Remove a weapon, the last weapon moves into its slot
+void FThrowingWeaponBatch::RemoveAtSwap(int32 index)
+{
+	Weapons.RemoveAtSwap(index, 1, false);
+	Locations.RemoveAtSwap(index, 1, false);
+	Velocities.RemoveAtSwap(index, 1, false);
+	StateTimes.RemoveAtSwap(index, 1, false);
+	ReturnTimes.RemoveAtSwap(index, 1, false);
+	Params.RemoveAtSwap(index, 1, false);
+
+	if (Weapons.IsValidIndex(index))
+	{
+		Weapons[index]->BatchedSimulationIndex = index;
+	}
+}
+
+void UThrowingWeaponSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+}
+
+void UThrowingWeaponSubsystem::Deinitialize()
+{
+#if !UE_BUILD_SHIPPING
+	Benchmark.Reset();
+#endif
+
+	SimulationTickFunction.GetPrerequisites().Reset();
+	SimulationPrerequisiteCounts.Reset();
+
+	if (SimulationTickFunction.IsTickFunctionRegistered())
+	{
+		SimulationTickFunction.UnRegisterTickFunction();
+	}
+
+	Super::Deinitialize();
+}
+// Register the simulation tick, it runs in the pre physics group like character movement and waits for it through prerequisites
+void UThrowingWeaponSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	SimulationTickFunction.Subsystem = this;
+	SimulationTickFunction.TickGroup = TG_PrePhysics;
+	SimulationTickFunction.bCanEverTick = true;
+	SimulationTickFunction.bStartWithTickEnabled = true;
+	SimulationTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+TStatId UThrowingWeaponSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UThrowingWeaponSubsystem, STATGROUP_Tickables);
+}
+// Only game worlds have throwing weapons in flight
+bool UThrowingWeaponSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+// Impacts, flight traces and stats of the frame, the simulation itself already ran in SimulationTickFunction
+void UThrowingWeaponSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Tickables run after every actor, so this is after the per actor weapons published their impacts too
+	DrainImpacts();
+
+	SubmitFlightTraces();
+	ReportFlightTraceStats();
+
+#if !UE_BUILD_SHIPPING
+	FThrowingWeaponBatchBenchmark::Tick(*this);
+#endif
+}
+void FThrowingWeaponSimulationTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem != nullptr && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Subsystem->TickSimulation(DeltaTime);
+	}
+}
+
+FString FThrowingWeaponSimulationTickFunction::DiagnosticMessage()
+{
+	return TEXT("FThrowingWeaponSimulationTickFunction");
+}
+
+FName FThrowingWeaponSimulationTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("ThrowingWeaponSimulation"));
+}
+// Advance every batched throwing weapon in one pass per state
+void UThrowingWeaponSubsystem::TickSimulation(float deltaTime)
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponBatchedSimulation);
+
+	const uint64 startCycles = FPlatformTime::Cycles64();
+
+	AdvanceLaunched(deltaTime);
+	AdvanceWiggle(deltaTime);
+	AdvanceReturning(deltaTime);
+
+	// The return goes on in the returning batch, which also catches a weapon that arrived while still wiggling. Moved only after
+	// AdvanceReturning, so the return of a weapon that just stopped wiggling does not advance twice this frame
+	for (AThrowingWeaponBase* weapon : FinishedWiggles)
+	{
+		weapon->ThrowingWeaponWiggleFinished();
+	}
+	FinishedWiggles.Reset();
+
+	LastSimulationMilliseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles);
+}
+// Keep the simulation after the movement of the weapon's owner and the mesh tick that finalizes its pose (and with it the
+// cached grip point), so a return heads for this frame's grip point. Counted per owner, since one owner can have several
+// weapons in the batches
+void UThrowingWeaponSubsystem::AddSimulationPrerequisite(AThrowingWeaponBase* weapon, FThrowingWeaponBatchParams& params)
+{
+	ACharacter* owner = weapon->PlayerReference;
+	if (!SimulationTickFunction.IsTickFunctionRegistered() || owner == nullptr)
+	{
+		return;
+	}
+
+	params.SimulationOwner = owner;
+
+	int32& numWeapons = SimulationPrerequisiteCounts.FindOrAdd(owner);
+	if (numWeapons++ > 0)
+	{
+		return;
+	}
+
+	if (UCharacterMovementComponent* characterMovement = owner->GetCharacterMovement())
+	{
+		SimulationTickFunction.AddPrerequisite(characterMovement, characterMovement->PrimaryComponentTick);
+	}
+	if (USkeletalMeshComponent* mesh = owner->GetMesh())
+	{
+		SimulationTickFunction.AddPrerequisite(mesh, mesh->PrimaryComponentTick);
+	}
+}
+// Stop waiting for the owner's movement and pose once the last of its weapons left the batches
+void UThrowingWeaponSubsystem::RemoveSimulationPrerequisite(const FThrowingWeaponBatchParams& params)
+{
+	int32* numWeapons = SimulationPrerequisiteCounts.Find(params.SimulationOwner);
+	if (numWeapons == nullptr || --(*numWeapons) > 0)
+	{
+		return;
+	}
+
+	SimulationPrerequisiteCounts.Remove(params.SimulationOwner);
+
+	if (ACharacter* owner = params.SimulationOwner.Get())
+	{
+		if (UCharacterMovementComponent* characterMovement = owner->GetCharacterMovement())
+		{
+			SimulationTickFunction.RemovePrerequisite(characterMovement, characterMovement->PrimaryComponentTick);
+		}
+		if (USkeletalMeshComponent* mesh = owner->GetMesh())
+		{
+			SimulationTickFunction.RemovePrerequisite(mesh, mesh->PrimaryComponentTick);
+		}
+	}
+	else
+	{
+		// The character is gone, drop every prerequisite that no longer points at a tick function
+		SimulationTickFunction.GetPrerequisites().RemoveAllSwap([](FTickPrerequisite& prerequisite) { return prerequisite.Get() == nullptr; });
+	}
+}
+// Move a batched weapon to the batch of its new state (Idle removes it)
+void UThrowingWeaponSubsystem::SetWeaponState(AThrowingWeaponBase* weapon, ThrowingWeaponState newState)
+{
+	float returnTime = 0;
+	if (FThrowingWeaponBatch* oldBatch = GetBatch(weapon->BatchedSimulationState))
+	{
+		if (weapon->BatchedSimulationIndex != INDEX_NONE)
+		{
+			returnTime = oldBatch->ReturnTimes[weapon->BatchedSimulationIndex];
+		}
+	}
+
+	RemoveWeapon(weapon);
+
+	if (FThrowingWeaponBatch* newBatch = GetBatch(newState))
+	{
+		weapon->BatchedSimulationIndex = newBatch->Add(weapon);
+		weapon->BatchedSimulationState = newState;
+
+		AddSimulationPrerequisite(weapon, newBatch->Params[weapon->BatchedSimulationIndex]);
+
+		// Wiggle starts the return, so the return carries on where it was when the wiggle ends
+		newBatch->ReturnTimes[weapon->BatchedSimulationIndex] = returnTime;
+	}
+}
+// Stop simulating a weapon
+void UThrowingWeaponSubsystem::RemoveWeapon(AThrowingWeaponBase* weapon)
+{
+	FThrowingWeaponBatch* batch = GetBatch(weapon->BatchedSimulationState);
+
+	if (batch != nullptr && batch->Weapons.IsValidIndex(weapon->BatchedSimulationIndex) && batch->Weapons[weapon->BatchedSimulationIndex] == weapon)
+	{
+		RemoveSimulationPrerequisite(batch->Params[weapon->BatchedSimulationIndex]);
+		batch->RemoveAtSwap(weapon->BatchedSimulationIndex);
+	}
+
+	weapon->BatchedSimulationIndex = INDEX_NONE;
+	weapon->BatchedSimulationState = ThrowingWeaponState::Idle;
+}
+// Point the batch at the weapon's current curve tables after a variant swap
+void UThrowingWeaponSubsystem::RefreshWeaponCurves(AThrowingWeaponBase* weapon)
+{
+	FThrowingWeaponBatch* batch = GetBatch(weapon->BatchedSimulationState);
+
+	if (batch != nullptr && batch->Weapons.IsValidIndex(weapon->BatchedSimulationIndex) && batch->Weapons[weapon->BatchedSimulationIndex] == weapon)
+	{
+		FThrowingWeaponBatchParams& params = batch->Params[weapon->BatchedSimulationIndex];
+		params.SpinCurve = weapon->SpinCurveTable.Get();
+		params.ReturnSpeedCurve = weapon->ReturnSpeedCurveTable.Get();
+		params.WiggleCurve = weapon->WiggleCurveTable.Get();
+	}
+}
+// How many weapons are in the batch of a state
+int32 UThrowingWeaponSubsystem::GetNumWeapons(ThrowingWeaponState state) const
+{
+	const FThrowingWeaponBatch* batch = GetBatch(state);
+	return batch != nullptr ? batch->Num() : 0;
+}
+// Submitted with every other queued trace at the end of this frame's tick
+void UThrowingWeaponSubsystem::QueueFlightTrace(const FThrowingWeaponFlightTrace& trace)
+{
+	QueuedFlightTraces.Add(trace);
+}
+// Cost of a game thread flight trace, the baseline for the time saved stat
+void UThrowingWeaponSubsystem::RecordSyncFlightTrace(uint64 cycles)
+{
+	AverageSyncFlightTraceCycles = AverageSyncFlightTraceCycles > 0 ? FMath::Lerp(AverageSyncFlightTraceCycles, static_cast<double>(cycles), 0.05) : cycles;
+}
+// Result of an async flight trace was used (or lost and traced again)
+void UThrowingWeaponSubsystem::RecordAsyncFlightTrace(uint64 consumeCycles, double latencySeconds, bool bIsFallback)
+{
+	FrameAsyncFlightTraceCycles += consumeCycles;
+
+	if (bIsFallback)
+	{
+		FrameAsyncFlightTraceFallbacks++;
+		return;
+	}
+
+	FrameAsyncFlightTraces++;
+	FrameMaxAsyncFlightTraceLatency = FMath::Max(FrameMaxAsyncFlightTraceLatency, latencySeconds);
+}
+// Thread safe: the queue is multi producer and only the depth counter is shared
+void UThrowingWeaponSubsystem::PublishImpact(AThrowingWeaponBase* weapon, const FHitResult& hitResult, const FVector& velocity)
+{
+	FThrowingWeaponImpactEvent impact;
+	impact.Weapon = weapon;
+	impact.HitResult = hitResult;
+	impact.Velocity = velocity;
+	impact.PublishCycles = FPlatformTime::Cycles64();
+
+	ImpactQueue.Enqueue(MoveTemp(impact));
+	ImpactQueueDepth.fetch_add(1, std::memory_order_relaxed);
+}
+// Lodge, damage and effects of every impact published since the last drain. Each is one pass over all weapons that hit something
+void UThrowingWeaponSubsystem::DrainImpacts()
+{
+	WEAPON_PROFILE_SCOPE(STAT_WeaponImpactDrain);
+
+	check(IsInGameThread());
+
+	SET_DWORD_STAT(STAT_WeaponImpactQueueDepth, GetImpactQueueDepth());
+
+	const uint64 drainCycles = FPlatformTime::Cycles64();
+	uint64 maxLatencyCycles = 0;
+
+	DrainedImpacts.Reset();
+
+	FThrowingWeaponImpactEvent impact;
+	while (ImpactQueue.Dequeue(impact))
+	{
+		ImpactQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+		maxLatencyCycles = FMath::Max(maxLatencyCycles, drainCycles - FMath::Min(impact.PublishCycles, drainCycles));
+
+		// A weapon hit twice (game thread trace and a collision callback) or recalled since only lodges once
+		AThrowingWeaponBase* weapon = impact.Weapon.Get();
+		if (weapon != nullptr && weapon->CurrentThrowingWeaponState == ThrowingWeaponState::Launched)
+		{
+			weapon->HandleThrowingWeaponImpact(impact.HitResult, impact.Velocity);
+			DrainedImpacts.Add(MoveTemp(impact));
+		}
+		else if (weapon != nullptr)
+		{
+			weapon->bIsImpactPending = false;
+		}
+	}
+
+	// Damage and effects after every weapon lodged, so a damage handler sees all of this frame's lodges
+	for (const FThrowingWeaponImpactEvent& drainedImpact : DrainedImpacts)
+	{
+		if (AThrowingWeaponBase* weapon = drainedImpact.Weapon.Get())
+		{
+			weapon->ApplyThrowingWeaponImpactEffects(drainedImpact.HitResult, drainedImpact.Velocity);
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_WeaponImpactsDrained, DrainedImpacts.Num());
+	SET_FLOAT_STAT(STAT_WeaponImpactLatency, FPlatformTime::ToMilliseconds64(maxLatencyCycles));
+}
+// Integrate flight, spin and impact traces of every launched weapon
+void UThrowingWeaponSubsystem::AdvanceLaunched(float deltaTime)
+{
+	FThrowingWeaponBatch& batch = LaunchedBatch;
+	const int32 numWeapons = batch.Num();
+
+	CurveValues.SetNumUninitialized(numWeapons, false);
+
+	// Flight integration and spin only touch the location/velocity/time arrays, so they run on the workers
+	ForEachSimulationChunk(numWeapons, [&](int32 start, int32 count)
+	{
+		for (int32 i = start; i < start + count; i++)
+		{
+			const FThrowingWeaponBatchParams& params = batch.Params[i];
+
+			FThrowingWeaponSimulation::AdvanceFlight(batch.Locations[i], batch.Velocities[i], params.GravityZ, params.MaxSpeed, deltaTime);
+			batch.StateTimes[i] = FThrowingWeaponSimulation::AdvanceSpin(batch.StateTimes[i], deltaTime, params.SpinRate, params.SpinCurve->GetEndTime());
+		}
+
+		EvaluateBatchedCurves(batch.Params, &FThrowingWeaponBatchParams::SpinCurve, batch.StateTimes, CurveValues, start, count);
+	});
+
+	// Commit the results to the actors (game thread)
+	for (int32 i = 0; i < numWeapons; i++)
+	{
+		AThrowingWeaponBase* weapon = batch.Weapons[i];
+		const FThrowingWeaponBatchParams& params = batch.Params[i];
+
+		weapon->SetActorLocationAndRotation(batch.Locations[i], batch.Velocities[i].Rotation());
+		weapon->PivotPointComponent->SetRelativeRotation(FRotator(CurveValues[i] * params.SpinMultiplier, 0, 0));
+	}
+
+	// Look for impacts once every transform is in. Async weapons only read last frame's result and queue this frame's trace for
+	// SubmitFlightTraces, the others still sweep here on the game thread
+	for (int32 i = 0; i < numWeapons; i++)
+	{
+		AThrowingWeaponBase* weapon = batch.Weapons[i];
+
+		// Lodging changes batches, the queue keeps that out of this loop
+		FHitResult hitResult;
+		if (!weapon->bIsImpactPending && weapon->TraceThrowingWeaponFlight(batch.Velocities[i], hitResult))
+		{
+			weapon->PublishThrowingWeaponImpact(hitResult, batch.Velocities[i]);
+		}
+	}
+}
+// Wiggle every weapon being pulled out of a surface while it starts returning
+void UThrowingWeaponSubsystem::AdvanceWiggle(float deltaTime)
+{
+	FThrowingWeaponBatch& batch = WiggleBatch;
+	const int32 numWeapons = batch.Num();
+
+	CurveValues.SetNumUninitialized(numWeapons, false);
+	ReturnCurveValues.SetNumUninitialized(numWeapons, false);
+	ReturnPoses.SetNumUninitialized(numWeapons, false);
+
+	// Curves and return poses on the workers, the return pose only reads the weapon's path and its owner's cached grip point
+	ForEachSimulationChunk(numWeapons, [&](int32 start, int32 count)
+	{
+		for (int32 i = start; i < start + count; i++)
+		{
+			const FThrowingWeaponBatchParams& params = batch.Params[i];
+
+			batch.StateTimes[i] += deltaTime * FThrowingWeaponSimulation::WigglePlayRate;
+			batch.ReturnTimes[i] += deltaTime * params.ReturnPlayRate;
+		}
+
+		EvaluateBatchedCurves(batch.Params, &FThrowingWeaponBatchParams::WiggleCurve, batch.StateTimes, CurveValues, start, count);
+		EvaluateBatchedCurves(batch.Params, &FThrowingWeaponBatchParams::ReturnSpeedCurve, batch.ReturnTimes, ReturnCurveValues, start, count);
+
+		for (int32 i = start; i < start + count; i++)
+		{
+			const float returnAlpha = FThrowingWeaponSimulation::CalculateReturnAlpha(ReturnCurveValues[i], batch.ReturnTimes[i], batch.Params[i].ReturnSpeedCurve->GetEndTime());
+			ReturnPoses[i] = batch.Weapons[i]->CalculateThrowingWeaponReturnPose(returnAlpha);
+		}
+	});
+
+	for (int32 i = 0; i < numWeapons; i++)
+	{
+		AThrowingWeaponBase* weapon = batch.Weapons[i];
+		const FThrowingWeaponBatchParams& params = batch.Params[i];
+
+		weapon->LodgePointComponent->SetRelativeRotation(FThrowingWeaponSimulation::CalculateWiggleRotation(params.LodgePointBaseRotation, CurveValues[i]));
+		weapon->CommitThrowingWeaponReturnPose(ReturnPoses[i]);
+
+		if (batch.StateTimes[i] >= params.WiggleCurve->GetEndTime() || FThrowingWeaponSimulation::IsReturnFinished(batch.ReturnTimes[i], params.ReturnSpeedCurve->GetEndTime()))
+		{
+			FinishedWiggles.Add(weapon);
+		}
+	}
+}
+// Move every returning weapon towards its owner
+void UThrowingWeaponSubsystem::AdvanceReturning(float deltaTime)
+{
+	FThrowingWeaponBatch& batch = ReturningBatch;
+	const int32 numWeapons = batch.Num();
+
+	ReturnCurveValues.SetNumUninitialized(numWeapons, false);
+	ReturnPoses.SetNumUninitialized(numWeapons, false);
+
+	ForEachSimulationChunk(numWeapons, [&](int32 start, int32 count)
+	{
+		for (int32 i = start; i < start + count; i++)
+		{
+			batch.ReturnTimes[i] += deltaTime * batch.Params[i].ReturnPlayRate;
+		}
+
+		EvaluateBatchedCurves(batch.Params, &FThrowingWeaponBatchParams::ReturnSpeedCurve, batch.ReturnTimes, ReturnCurveValues, start, count);
+
+		for (int32 i = start; i < start + count; i++)
+		{
+			const float returnAlpha = FThrowingWeaponSimulation::CalculateReturnAlpha(ReturnCurveValues[i], batch.ReturnTimes[i], batch.Params[i].ReturnSpeedCurve->GetEndTime());
+			ReturnPoses[i] = batch.Weapons[i]->CalculateThrowingWeaponReturnPose(returnAlpha);
+		}
+	});
+
+	for (int32 i = 0; i < numWeapons; i++)
+	{
+		AThrowingWeaponBase* weapon = batch.Weapons[i];
+		const FThrowingWeaponBatchParams& params = batch.Params[i];
+
+		weapon->CommitThrowingWeaponReturnPose(ReturnPoses[i]);
+
+		if (FThrowingWeaponSimulation::IsReturnFinished(batch.ReturnTimes[i], params.ReturnSpeedCurve->GetEndTime()))
+		{
+			PendingStateChanges.Add(weapon);
+		}
+	}
+
+	for (AThrowingWeaponBase* weapon : PendingStateChanges)
+	{
+		// Out of the batch before the owner catches it and sets it Idle
+		RemoveWeapon(weapon);
+		weapon->ThrowingWeaponReturnFinished();
+	}
+	PendingStateChanges.Reset();
+}
+// Submit every flight trace queued this frame, the world runs them off the game thread and the weapons read the results next frame
+void UThrowingWeaponSubsystem::SubmitFlightTraces()
+{
+	if (QueuedFlightTraces.Num() == 0)
+	{
+		return;
+	}
+
+	WEAPON_PROFILE_SCOPE(STAT_ThrowTraceAsyncSubmit);
+	const uint64 startCycles = FPlatformTime::Cycles64();
+
+	UWorld* world = GetWorld();
+
+	for (const FThrowingWeaponFlightTrace& trace : QueuedFlightTraces)
+	{
+		AThrowingWeaponBase* weapon = trace.Weapon.Get();
+
+		// Recalled or destroyed after queueing
+		if (weapon == nullptr || weapon->CurrentThrowingWeaponState != ThrowingWeaponState::Launched)
+		{
+			continue;
+		}
+
+		for (int32 i = 1; i < trace.Path.Num(); i++)
+		{
+			weapon->AsyncThrowTraceHandles.Add(trace.bSwept
+				? world->AsyncSweepByChannel(EAsyncTraceType::Single, trace.Path[i - 1], trace.Path[i], trace.Rotation, ECC_Visibility, trace.Shape, weapon->ThrowTraceQueryParams)
+				: world->AsyncLineTraceByChannel(EAsyncTraceType::Single, trace.Path[i - 1], trace.Path[i], ECC_Visibility, weapon->ThrowTraceQueryParams));
+		}
+		weapon->AsyncThrowTraceSubmitCycles = FPlatformTime::Cycles64();
+	}
+	QueuedFlightTraces.Reset();
+
+	FrameAsyncFlightTraceCycles += FPlatformTime::Cycles64() - startCycles;
+}
+// Publish this frame's async trace stats and start counting the next frame
+void UThrowingWeaponSubsystem::ReportFlightTraceStats()
+{
+#if STATS
+	// Time saved is what the used async results would have cost as sync traces minus what submitting and reading them cost
+	const double savedCycles = FrameAsyncFlightTraces * AverageSyncFlightTraceCycles - static_cast<double>(FrameAsyncFlightTraceCycles);
+
+	SET_DWORD_STAT(STAT_ThrowTraceAsyncCount, FrameAsyncFlightTraces);
+	SET_DWORD_STAT(STAT_ThrowTraceAsyncFallbacks, FrameAsyncFlightTraceFallbacks);
+	SET_FLOAT_STAT(STAT_ThrowTraceAsyncLatency, FrameMaxAsyncFlightTraceLatency * 1000);
+	SET_FLOAT_STAT(STAT_ThrowTraceTimeSaved, savedCycles * FPlatformTime::GetSecondsPerCycle64() * 1000);
+#endif
+
+	FrameAsyncFlightTraceCycles = 0;
+	FrameAsyncFlightTraces = 0;
+	FrameAsyncFlightTraceFallbacks = 0;
+	FrameMaxAsyncFlightTraceLatency = 0;
+}
+// The batch of a state, nullptr for Idle
+FThrowingWeaponBatch* UThrowingWeaponSubsystem::GetBatch(ThrowingWeaponState state)
+{
+	return const_cast<FThrowingWeaponBatch*>(static_cast<const UThrowingWeaponSubsystem*>(this)->GetBatch(state));
+}
+
+const FThrowingWeaponBatch* UThrowingWeaponSubsystem::GetBatch(ThrowingWeaponState state) const
+{
+	switch (state)
+	{
+	case ThrowingWeaponState::Launched:
+		return &LaunchedBatch;
+
+	case ThrowingWeaponState::Lodged:
+		return &LodgedBatch;
+
+	case ThrowingWeaponState::Wiggle:
+		return &WiggleBatch;
+
+	case ThrowingWeaponState::Returning:
+		return &ReturningBatch;
+
+	default:
+		return nullptr;
+	}
+}
+#if !UE_BUILD_SHIPPING
+
+// Throw every weapon of the run upwards so nothing hits the level while it is measured
+void FThrowingWeaponBatchBenchmark::StartRun(UThrowingWeaponSubsystem& subsystem, FThrowingWeaponBatchBenchmark& benchmark)
+{
+	UWorld* world = subsystem.GetWorld();
+	const int32 weaponCount = benchmark.GetWeaponCount(benchmark.RunIndex);
+	const bool bBatched = benchmark.IsBatchedRun(benchmark.RunIndex);
+	const int32 gridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(weaponCount)));
+
+	FRandomStream random(benchmark.RunIndex);
+
+	for (int32 i = 0; i < weaponCount; i++)
+	{
+		const FVector location = benchmark.Origin + FVector((i % gridSize) * 200, (i / gridSize) * 200, 0);
+
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		spawnParameters.bDeferConstruction = true;
+
+		ADefaultThrowingWeapon* weapon = world->SpawnActor<ADefaultThrowingWeapon>(benchmark.WeaponClass, FTransform(location), spawnParameters);
+		weapon->SetUseBatchedSimulation(bBatched);
+		weapon->FinishSpawning(FTransform(location));
+
+		const FVector throwDirection = FVector(random.FRandRange(-0.2f, 0.2f), random.FRandRange(-0.2f, 0.2f), 1).GetSafeNormal();
+		weapon->ThrowWeapon(throwDirection.Rotation(), throwDirection, location, 0);
+
+		benchmark.SpawnedWeapons.Add(weapon);
+	}
+
+	benchmark.RunFrame = 0;
+	benchmark.AccumulatedMilliseconds = 0;
+}
+// Destroy the weapons of the finished run and remember its average
+void FThrowingWeaponBatchBenchmark::FinishRun(FThrowingWeaponBatchBenchmark& benchmark)
+{
+	for (ADefaultThrowingWeapon* weapon : benchmark.SpawnedWeapons)
+	{
+		if (IsValid(weapon))
+		{
+			weapon->Destroy();
+		}
+	}
+	benchmark.SpawnedWeapons.Reset();
+
+	benchmark.GameThreadMilliseconds.Add(benchmark.AccumulatedMilliseconds / benchmark.FramesPerRun);
+}
+// Print per actor against batched cost of every weapon count
+void FThrowingWeaponBatchBenchmark::LogResults(const FThrowingWeaponBatchBenchmark& benchmark)
+{
+	const double baselineMilliseconds = FMath::Min(benchmark.GameThreadMilliseconds[0], benchmark.GameThreadMilliseconds[1]);
+
+	UE_LOG(LogTemp, Display, TEXT("Throwing weapon batch benchmark (%d frames per run, empty frame %.3f ms)"), benchmark.FramesPerRun, baselineMilliseconds);
+
+	for (int32 countIndex = 1; countIndex < benchmark.WeaponCounts.Num(); countIndex++)
+	{
+		const int32 weaponCount = benchmark.WeaponCounts[countIndex];
+		const double perActorMilliseconds = benchmark.GameThreadMilliseconds[countIndex * 2] - baselineMilliseconds;
+		const double batchedMilliseconds = benchmark.GameThreadMilliseconds[countIndex * 2 + 1] - baselineMilliseconds;
+
+		UE_LOG(LogTemp, Display, TEXT("  %5d weapons: per actor %.3f ms (%.2f us/weapon), batched %.3f ms (%.2f us/weapon), speedup %.2fx"),
+			weaponCount,
+			perActorMilliseconds, perActorMilliseconds * 1000 / weaponCount,
+			batchedMilliseconds, batchedMilliseconds * 1000 / weaponCount,
+			batchedMilliseconds > 0 ? perActorMilliseconds / batchedMilliseconds : 0.0);
+	}
+}
+// Step the running benchmark, called once per subsystem tick
+void FThrowingWeaponBatchBenchmark::Tick(UThrowingWeaponSubsystem& subsystem)
+{
+	if (!subsystem.Benchmark.IsValid())
+	{
+		return;
+	}
+
+	FThrowingWeaponBatchBenchmark& benchmark = *subsystem.Benchmark;
+
+	// GGameThreadTime is the previous frame, so the first frame after spawning is part of the warmup
+	if (benchmark.RunFrame >= benchmark.WarmupFrames)
+	{
+		benchmark.AccumulatedMilliseconds += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	}
+
+	benchmark.RunFrame++;
+
+	// Recall halfway so the returning path is measured too
+	if (benchmark.RunFrame == benchmark.WarmupFrames + benchmark.FramesPerRun / 2)
+	{
+		for (ADefaultThrowingWeapon* weapon : benchmark.SpawnedWeapons)
+		{
+			weapon->RecallThrowingWeapon();
+		}
+	}
+
+	if (benchmark.RunFrame < benchmark.WarmupFrames + benchmark.FramesPerRun)
+	{
+		return;
+	}
+
+	FinishRun(benchmark);
+	benchmark.RunIndex++;
+
+	if (benchmark.RunIndex < benchmark.GetNumRuns())
+	{
+		StartRun(subsystem, benchmark);
+		return;
+	}
+
+	LogResults(benchmark);
+	subsystem.Benchmark.Reset();
+}
+// Weapon.Batch.Benchmark console command
+void FThrowingWeaponBatchBenchmark::Run(const TArray<FString>& args, UWorld* world)
+{
+	UThrowingWeaponSubsystem* subsystem = UWorld::GetSubsystem<UThrowingWeaponSubsystem>(world);
+	if (subsystem == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Weapon.Batch.Benchmark needs a game world"));
+		return;
+	}
+
+	TSharedPtr<FThrowingWeaponBatchBenchmark> benchmark = MakeShared<FThrowingWeaponBatchBenchmark>();
+	benchmark->WeaponClass = ADefaultThrowingWeapon::StaticClass();
+
+	// Throw the weapon the level already uses so the Blueprint curves and mesh are measured
+	for (TActorIterator<ADefaultThrowingWeapon> it(world); it; ++it)
+	{
+		benchmark->WeaponClass = it->GetClass();
+		benchmark->Origin = it->GetActorLocation() + FVector(0, 0, 5000);
+		break;
+	}
+
+	if (args.Num() > 0)
+	{
+		benchmark->FramesPerRun = FMath::Max(2, FCString::Atoi(*args[0]));
+	}
+
+	benchmark->WeaponCounts.Add(0);
+	for (int32 i = 1; i < args.Num(); i++)
+	{
+		benchmark->WeaponCounts.Add(FMath::Max(1, FCString::Atoi(*args[i])));
+	}
+	if (benchmark->WeaponCounts.Num() == 1)
+	{
+		benchmark->WeaponCounts.Append({ 10, 100, 1000 });
+	}
+
+	subsystem->Benchmark = benchmark;
+	StartRun(*subsystem, *benchmark);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdThrowingWeaponBatchBenchmark(
+	TEXT("Weapon.Batch.Benchmark"),
+	TEXT("Compare per actor and batched throwing weapon simulation at 10/100/1000 weapons. Optional arguments: frames per run, weapon counts..."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FThrowingWeaponBatchBenchmark::Run));
+
+#endif
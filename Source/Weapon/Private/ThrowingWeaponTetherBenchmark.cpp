@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponTetherBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThrowingWeaponTetherComponent.h"
+#include "CableComponent.h"
+#include "Containers/Ticker.h"
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+// Spawn the tethers of the current run, each one between a fixed anchor and a swinging end
+void FThrowingWeaponTetherBenchmark::StartRun()
+{
+	UWorld* world = World.Get();
+	const FRun& run = Runs[RunIndex];
+	const int32 gridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(FMath::Max(run.Count, 1))));
+
+	// Both simulate the same resolution, and the native tether stays at its closest LOD
+	const UThrowingWeaponTetherComponent* tetherDefaults = GetDefault<UThrowingWeaponTetherComponent>();
+
+	for (int32 i = 0; i < run.Count; i++)
+	{
+		const FVector location = FVector((i % gridSize) * 300, (i / gridSize) * 300, 5000);
+
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		AActor* actor = world->SpawnActor<AActor>(AActor::StaticClass(), FTransform(location), spawnParameters);
+
+		USceneComponent* anchor = NewObject<USceneComponent>(actor);
+		actor->SetRootComponent(anchor);
+		anchor->RegisterComponent();
+		anchor->SetWorldLocation(location);
+
+		USceneComponent* tetherEnd = NewObject<USceneComponent>(actor);
+		tetherEnd->SetupAttachment(anchor);
+		tetherEnd->RegisterComponent();
+
+		if (run.Type == ETetherType::Cable)
+		{
+			UCableComponent* cable = NewObject<UCableComponent>(actor);
+			cable->SetupAttachment(anchor);
+			cable->CableLength = tetherDefaults->TetherLength;
+			cable->NumSegments = tetherDefaults->MaxSegments;
+			cable->SolverIterations = tetherDefaults->MaxIterations;
+			cable->bAttachEnd = true;
+			cable->SetAttachEndToComponent(tetherEnd);
+			cable->RegisterComponent();
+		}
+		else
+		{
+			UThrowingWeaponTetherComponent* tether = NewObject<UThrowingWeaponTetherComponent>(actor);
+			tether->SetupAttachment(anchor);
+			tether->LODNearDistance = TNumericLimits<float>::Max() / 2;
+			tether->LODFarDistance = TNumericLimits<float>::Max();
+			tether->RegisterComponent();
+			tether->SetTetherEnd(tetherEnd, NAME_None);
+			tether->SetThrowingWeaponState(ThrowingWeaponState::Launched);
+		}
+
+		SpawnedActors.Add(actor);
+		TetherEnds.Add(tetherEnd);
+	}
+
+	RunFrame = 0;
+	AccumulatedMilliseconds = 0;
+}
+// Destroy the tethers of the finished run and remember its average
+void FThrowingWeaponTetherBenchmark::FinishRun()
+{
+	for (const TWeakObjectPtr<AActor>& actor : SpawnedActors)
+	{
+		if (actor.IsValid())
+		{
+			actor->Destroy();
+		}
+	}
+	SpawnedActors.Reset();
+	TetherEnds.Reset();
+
+	GameThreadMilliseconds.Add(AccumulatedMilliseconds / FramesPerRun);
+}
+// Print cable against native cost of every tether count
+void FThrowingWeaponTetherBenchmark::LogResults() const
+{
+	const double baselineMilliseconds = GameThreadMilliseconds[0];
+
+	UE_LOG(LogTemp, Display, TEXT("Tether benchmark (%d frames per run, empty frame %.3f ms)"), FramesPerRun, baselineMilliseconds);
+
+	for (int32 i = 1; i + 1 < Runs.Num(); i += 2)
+	{
+		const int32 count = Runs[i].Count;
+		const double cableMilliseconds = GameThreadMilliseconds[i] - baselineMilliseconds;
+		const double nativeMilliseconds = GameThreadMilliseconds[i + 1] - baselineMilliseconds;
+
+		UE_LOG(LogTemp, Display, TEXT("  %4d tethers: cable %.3f ms (%.2f us/tether), native %.3f ms (%.2f us/tether), speedup %.2fx"),
+			count,
+			cableMilliseconds, cableMilliseconds * 1000 / count,
+			nativeMilliseconds, nativeMilliseconds * 1000 / count,
+			nativeMilliseconds > 0 ? cableMilliseconds / nativeMilliseconds : 0.0);
+	}
+}
+// Average above the empty baseline of a finished run, negative if there was none
+double FThrowingWeaponTetherBenchmark::GetRunMilliseconds(ETetherType type, int32 count) const
+{
+	for (int32 i = 1; i < GameThreadMilliseconds.Num(); i++)
+	{
+		if (Runs[i].Type == type && Runs[i].Count == count)
+		{
+			return GameThreadMilliseconds[i] - GameThreadMilliseconds[0];
+		}
+	}
+	return -1;
+}
+// Step the benchmark, false once it is finished
+bool FThrowingWeaponTetherBenchmark::Tick(float deltaTime)
+{
+	if (!World.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Tether benchmark stopped, its world went away"));
+		return false;
+	}
+
+	// GGameThreadTime is the previous frame, so the first frames after spawning are the warmup
+	if (RunFrame >= WarmupFrames)
+	{
+		AccumulatedMilliseconds += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	}
+
+	Time += deltaTime;
+
+	for (int32 i = 0; i < TetherEnds.Num(); i++)
+	{
+		if (USceneComponent* tetherEnd = TetherEnds[i].Get())
+		{
+			const float angle = Time * 3 + i;
+			tetherEnd->SetRelativeLocation(FVector(FMath::Cos(angle) * 80, FMath::Sin(angle) * 80, -60));
+		}
+	}
+
+	RunFrame++;
+
+	if (RunFrame < WarmupFrames + FramesPerRun)
+	{
+		return true;
+	}
+
+	FinishRun();
+	RunIndex++;
+
+	if (RunIndex < Runs.Num())
+	{
+		StartRun();
+		return true;
+	}
+
+	LogResults();
+	return false;
+}
+// Spawn the first run, null without a game world
+TSharedPtr<FThrowingWeaponTetherBenchmark> FThrowingWeaponTetherBenchmark::Start(UWorld* world, int32 framesPerRun, const TArray<int32>& counts)
+{
+	if (world == nullptr || !world->IsGameWorld())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The tether benchmark needs a game world"));
+		return nullptr;
+	}
+
+	TSharedPtr<FThrowingWeaponTetherBenchmark> benchmark = MakeShared<FThrowingWeaponTetherBenchmark>();
+	benchmark->World = world;
+	benchmark->FramesPerRun = framesPerRun;
+
+	benchmark->Runs.Add({ ETetherType::None, 0 });
+	for (const int32 count : counts)
+	{
+		benchmark->Runs.Add({ ETetherType::Cable, count });
+		benchmark->Runs.Add({ ETetherType::Native, count });
+	}
+
+	benchmark->StartRun();
+	return benchmark;
+}
+// Weapon.Tether.Benchmark console command
+static void RunThrowingWeaponTetherBenchmark(const TArray<FString>& args, UWorld* world)
+{
+	const int32 framesPerRun = args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*args[0])) : 300;
+
+	TArray<int32> counts;
+	for (int32 i = 1; i < args.Num(); i++)
+	{
+		counts.Add(FMath::Max(1, FCString::Atoi(*args[i])));
+	}
+	if (counts.Num() == 0)
+	{
+		counts = { 1, 100 };
+	}
+
+	TSharedPtr<FThrowingWeaponTetherBenchmark> benchmark = FThrowingWeaponTetherBenchmark::Start(world, framesPerRun, counts);
+	if (!benchmark.IsValid())
+	{
+		return;
+	}
+
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([benchmark](float deltaTime)
+	{
+		return benchmark->Tick(deltaTime);
+	}));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdThrowingWeaponTetherBenchmark(
+	TEXT("Weapon.Tether.Benchmark"),
+	TEXT("Compare UCableComponent and the native tether at 1 and 100 tethers. Optional arguments: frames per run, tether counts..."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunThrowingWeaponTetherBenchmark));
+
+#endif
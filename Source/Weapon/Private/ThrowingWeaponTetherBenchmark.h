@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class AActor;
+class USceneComponent;
+class UWorld;
+
+/// <summary>
+/// Weapon.Tether.Benchmark: swings the same number of tethers simulated by UCableComponent and by UThrowingWeaponTetherComponent
+/// (at the same segment and iteration count) and compares game thread time per frame against an empty baseline. The
+/// Weapon.Tether.Benchmark automation test fails when the native tether is slower than the cable at 100 tethers
+/// </summary>
+struct FThrowingWeaponTetherBenchmark
+{
+	enum class ETetherType : uint8
+	{
+		None, // Baseline without tethers
+		Cable,
+		Native,
+	};
+
+	struct FRun
+	{
+		ETetherType Type;
+		int32 Count;
+	};
+
+	TWeakObjectPtr<UWorld> World;
+	TArray<FRun> Runs;
+	TArray<double> GameThreadMilliseconds; // Average of every run
+
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+	TArray<TWeakObjectPtr<USceneComponent>> TetherEnds; // Moved every frame so the tethers never settle
+
+	int32 FramesPerRun = 300;
+	int32 WarmupFrames = 10;
+	int32 RunIndex = 0;
+	int32 RunFrame = 0;
+	double AccumulatedMilliseconds = 0;
+	float Time = 0;
+
+	bool Tick(float deltaTime); // Step the benchmark, false once it is finished
+
+	void StartRun();
+	void FinishRun();
+	void LogResults() const;
+
+	double GetRunMilliseconds(ETetherType type, int32 count) const; // Average above the empty baseline of a finished run, negative if there was none
+
+	static TSharedPtr<FThrowingWeaponTetherBenchmark> Start(UWorld* world, int32 framesPerRun, const TArray<int32>& counts); // Null without a game world
+};
+
+#endif
@@ -0,0 +1,308 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponTetherComponent.h"
+#include "PrimitiveSceneProxy.h"
+#include "DynamicMeshBuilder.h"
+#include "SceneManagement.h"
+#include "Materials/Material.h"
+#include "Kismet/GameplayStatics.h"
+#include "Camera/PlayerCameraManager.h"
+#include "WeaponStats.h"
+
+/// <summary>
+/// Renders the tether particles as a tube, rebuilt every frame from the last simulated particles
+/// </summary>
+class FThrowingWeaponTetherSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+
+	SIZE_T GetTypeHash() const override
+	{
+		static size_t UniquePointer;
+		return reinterpret_cast<size_t>(&UniquePointer);
+	}
+
+	FThrowingWeaponTetherSceneProxy(UThrowingWeaponTetherComponent* component)
+		: FPrimitiveSceneProxy(component)
+		, Material(component->GetMaterial(0))
+		, MaterialRelevance(component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
+		, Width(component->Width)
+		, NumSides(FMath::Clamp(component->NumSides, 1, 16))
+		, TileMaterial(component->TileMaterial)
+	{
+		if (Material == nullptr)
+		{
+			Material = UMaterial::GetDefaultMaterial(MD_Surface);
+		}
+	}
+
+	void SetParticles_RenderThread(TArray<FVector3f>&& particles)
+	{
+		check(IsInRenderingThread());
+
+		Particles = MoveTemp(particles);
+	}
+
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+	{
+		const int32 numParticles = Particles.Num();
+
+		if (numParticles < 2)
+		{
+			return;
+		}
+
+		FDynamicMeshBuilder meshBuilder(GetScene().GetFeatureLevel());
+
+		// Parallel transported ring frame, so the tube doesn't twist between segments
+		FVector3f right = FVector3f::ZeroVector;
+
+		for (int32 i = 0; i < numParticles; i++)
+		{
+			const FVector3f tangent = (Particles[FMath::Min(i + 1, numParticles - 1)] - Particles[FMath::Max(i - 1, 0)]).GetSafeNormal(UE_SMALL_NUMBER, FVector3f::UpVector);
+
+			right = (right - tangent * FVector3f::DotProduct(right, tangent)).GetSafeNormal();
+			if (right.IsNearlyZero())
+			{
+				right = FVector3f::CrossProduct(tangent, FMath::Abs(tangent.Z) < 0.99f ? FVector3f::UpVector : FVector3f::ForwardVector).GetSafeNormal();
+			}
+			const FVector3f up = FVector3f::CrossProduct(tangent, right);
+
+			const float alongTether = TileMaterial * i / (numParticles - 1);
+
+			for (int32 side = 0; side <= NumSides; side++)
+			{
+				const float angle = UE_TWO_PI * side / NumSides;
+				const FVector3f normal = right * FMath::Cos(angle) + up * FMath::Sin(angle);
+
+				meshBuilder.AddVertex(Particles[i] + normal * (Width * 0.5f), FVector2f(static_cast<float>(side) / NumSides, alongTether), FVector3f::CrossProduct(tangent, normal), tangent, normal, FColor::White);
+			}
+		}
+
+		const int32 ringSize = NumSides + 1;
+
+		for (int32 i = 0; i < numParticles - 1; i++)
+		{
+			for (int32 side = 0; side < NumSides; side++)
+			{
+				const int32 current = i * ringSize + side;
+				const int32 next = current + ringSize;
+
+				meshBuilder.AddTriangle(current, next, current + 1);
+				meshBuilder.AddTriangle(current + 1, next, next + 1);
+			}
+		}
+
+		// Particles are in world space
+		for (int32 viewIndex = 0; viewIndex < Views.Num(); viewIndex++)
+		{
+			if (VisibilityMap & (1 << viewIndex))
+			{
+				meshBuilder.GetMesh(FMatrix::Identity, Material->GetRenderProxy(), SDPG_World, false, false, viewIndex, Collector);
+			}
+		}
+	}
+
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+	{
+		FPrimitiveViewRelevance result;
+		result.bDrawRelevance = IsShown(View);
+		result.bShadowRelevance = IsShadowCast(View);
+		result.bDynamicRelevance = true;
+		result.bRenderInMainPass = ShouldRenderInMainPass();
+		result.bUsesLightingChannels = GetLightingChannelMask() != GetDefaultLightingChannelMask();
+		result.bRenderCustomDepth = ShouldRenderCustomDepth();
+		MaterialRelevance.SetPrimitiveViewRelevance(result);
+		return result;
+	}
+
+	virtual uint32 GetMemoryFootprint() const override { return sizeof(*this) + GetAllocatedSize(); }
+
+	uint32 GetAllocatedSize() const { return FPrimitiveSceneProxy::GetAllocatedSize() + Particles.GetAllocatedSize(); }
+
+private:
+
+	UMaterialInterface* Material;
+	FMaterialRelevance MaterialRelevance;
+
+	float Width;
+	int32 NumSides;
+	float TileMaterial;
+
+	TArray<FVector3f> Particles; // Render thread copy of the simulated particles
+};
+
+// Sets default values
+UThrowingWeaponTetherComponent::UThrowingWeaponTetherComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics; // After the weapon and the player moved this frame
+
+	bAutoActivate = true;
+	SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+	SetGenerateOverlapEvents(false);
+	SetHiddenInGame(false);
+
+	TetherLength = 100;
+	Width = 10;
+	NumSides = 4;
+	TileMaterial = 1;
+	GravityScale = 1;
+	Damping = 0.99f;
+
+	MaxSegments = 10;
+	MinSegments = 3;
+	MaxIterations = 8;
+	MinIterations = 2;
+	LODNearDistance = 1500;
+	LODFarDistance = 6000;
+
+	TetherEndSocketTransform = FTransform::Identity;
+	WeaponState = ThrowingWeaponState::Idle;
+	NumIterations = MaxIterations;
+	bIsSleeping = true;
+}
+// Asleep and hidden until the weapon leaves Idle
+void UThrowingWeaponTetherComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	Solver.Reset(MaxSegments, GetComponentLocation(), GetTetherEndLocation());
+
+	SetVisibility(!bIsSleeping);
+}
+// Attach the end of the tether to a component socket, the socket is only looked up here
+void UThrowingWeaponTetherComponent::SetTetherEnd(USceneComponent* endComponent, FName endSocketName)
+{
+	TetherEndComponent = endComponent;
+	TetherEndSocketTransform = endComponent != nullptr && endSocketName != NAME_None ? endComponent->GetSocketTransform(endSocketName, RTS_Component) : FTransform::Identity;
+}
+
+FVector UThrowingWeaponTetherComponent::GetTetherEndLocation() const
+{
+	if (const USceneComponent* endComponent = TetherEndComponent.Get())
+	{
+		return endComponent->GetComponentTransform().TransformPosition(TetherEndSocketTransform.GetLocation());
+	}
+	return GetComponentLocation();
+}
+// Sleep while Idle, otherwise wake up and pick the iterations for the state
+void UThrowingWeaponTetherComponent::SetThrowingWeaponState(ThrowingWeaponState state)
+{
+	WeaponState = state;
+
+	// Nothing to look at on a dedicated server
+	const bool bShouldSleep = state == ThrowingWeaponState::Idle || GetNetMode() == NM_DedicatedServer;
+
+	if (bShouldSleep == bIsSleeping)
+	{
+		return;
+	}
+
+	bIsSleeping = bShouldSleep;
+
+	if (!bIsSleeping)
+	{
+		// The weapon left the hand, start from a straight tether instead of wherever it went to sleep
+		UpdateLOD();
+		Solver.Reset(Solver.GetNumSegments(), GetComponentLocation(), GetTetherEndLocation());
+		MarkRenderDynamicDataDirty();
+	}
+
+	SetComponentTickEnabled(!bIsSleeping);
+	SetVisibility(!bIsSleeping);
+}
+// Segments from the camera distance, iterations from the state and the camera distance
+void UThrowingWeaponTetherComponent::UpdateLOD()
+{
+	float farAlpha = 0;
+
+	if (const APlayerCameraManager* cameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0))
+	{
+		const FVector tetherCenter = (GetComponentLocation() + GetTetherEndLocation()) * 0.5;
+		const float cameraDistance = FVector::Dist(cameraManager->GetCameraLocation(), tetherCenter);
+
+		farAlpha = FMath::GetRangePct(LODNearDistance, FMath::Max(LODFarDistance, LODNearDistance + 1), cameraDistance);
+		farAlpha = FMath::Clamp(farAlpha, 0.f, 1.f);
+	}
+
+	const int32 maxSegments = FMath::Max(MaxSegments, MinSegments);
+	const int32 maxIterations = FMath::Max(MaxIterations, MinIterations);
+
+	// A moving weapon pulls the tether taut and needs every iteration, a lodged one just lets it hang
+	const int32 stateIterations = WeaponState == ThrowingWeaponState::Lodged ? MinIterations : maxIterations;
+
+	Solver.SetNumSegments(FMath::RoundToInt(FMath::Lerp(static_cast<float>(maxSegments), static_cast<float>(MinSegments), farAlpha)));
+	NumIterations = FMath::Max(FMath::RoundToInt(FMath::Lerp(static_cast<float>(stateIterations), static_cast<float>(MinIterations), farAlpha)), 1);
+}
+// Simulate the tether between this component and the end socket
+void UThrowingWeaponTetherComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (bIsSleeping)
+	{
+		return;
+	}
+
+	WEAPON_PROFILE_SCOPE(STAT_TetherSimulate);
+
+	UpdateLOD();
+
+	// Long hitches would shoot the particles away, the tether just slows down instead
+	const float stepTime = FMath::Min(DeltaTime, 1.f / 30.f);
+	const FVector gravity = FVector(0, 0, GetWorld()->GetGravityZ() * GravityScale);
+	const float segmentLength = TetherLength / FMath::Max(Solver.GetNumSegments(), 1);
+
+	Solver.Simulate(GetComponentLocation(), GetTetherEndLocation(), segmentLength, gravity, stepTime, Damping, NumIterations);
+
+	INC_DWORD_STAT_BY(STAT_TetherParticles, Solver.GetNumParticles());
+
+	UpdateBounds();
+	MarkRenderTransformDirty();
+	MarkRenderDynamicDataDirty();
+}
+
+void UThrowingWeaponTetherComponent::CreateRenderState_Concurrent(FRegisterComponentContext* Context)
+{
+	Super::CreateRenderState_Concurrent(Context);
+
+	SendRenderDynamicData_Concurrent();
+}
+// Copy the particles over to the scene proxy
+void UThrowingWeaponTetherComponent::SendRenderDynamicData_Concurrent()
+{
+	Super::SendRenderDynamicData_Concurrent();
+
+	if (SceneProxy == nullptr)
+	{
+		return;
+	}
+
+	TArray<FVector3f> particles;
+	Solver.GetParticles(particles);
+
+	FThrowingWeaponTetherSceneProxy* tetherSceneProxy = static_cast<FThrowingWeaponTetherSceneProxy*>(SceneProxy);
+
+	ENQUEUE_RENDER_COMMAND(FSendThrowingWeaponTetherParticles)(
+		[tetherSceneProxy, particles = MoveTemp(particles)](FRHICommandListImmediate& RHICmdList) mutable
+		{
+			tetherSceneProxy->SetParticles_RenderThread(MoveTemp(particles));
+		});
+}
+
+FPrimitiveSceneProxy* UThrowingWeaponTetherComponent::CreateSceneProxy()
+{
+	return new FThrowingWeaponTetherSceneProxy(this);
+}
+// The particles are in world space, so is the box around them
+FBoxSphereBounds UThrowingWeaponTetherComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if (Solver.GetNumParticles() == 0)
+	{
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector(Width), Width);
+	}
+	return FBoxSphereBounds(Solver.GetBounds().ExpandBy(Width));
+}
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThrowingWeaponTrajectoryPreview.h"
+#include "ThrowingWeaponBase.h"
+#include "WeaponStats.h"
+
+// Step the preview, true when the visible arc changed
+bool FThrowingWeaponTrajectoryPreview::Update(const AThrowingWeaponBase& weapon, const FVector& throwDirection, const FVector& cameraLocation)
+{
+	WEAPON_PROFILE_SCOPE(STAT_ThrowPreview);
+
+	FVector launchLocation;
+	FVector launchVelocity;
+	float launchGravityZ;
+	weapon.PredictLaunch(throwDirection, cameraLocation, launchLocation, launchVelocity, launchGravityZ);
+
+	bool bChanged = false;
+
+	// Small aim changes keep last frame's samples and sweep, the arc can't move further than the tolerances
+	const bool bCanReuse = bHasSamples
+		&& FVector::DistSquared(launchLocation, Origin) <= FMath::Square(ReuseLocationTolerance)
+		&& FVector::DotProduct(launchVelocity.GetSafeNormal(), Velocity.GetSafeNormal()) >= FMath::Cos(FMath::DegreesToRadians(ReuseAngleToleranceDegrees))
+		&& FMath::IsNearlyEqual(launchVelocity.SizeSquared(), Velocity.SizeSquared(), 1.0)
+		&& launchGravityZ == GravityZ;
+
+	if (!bCanReuse)
+	{
+		Origin = launchLocation;
+		Velocity = launchVelocity;
+		GravityZ = launchGravityZ;
+		BuildSamples();
+
+		TraceCursor = 0;
+		HitSegment = INDEX_NONE;
+		bChanged = true;
+	}
+
+	// Sweep the segments in order. A hit ends the arc right away, reaching the end without one clears it
+	const int32 numSegments = X.Num() - 1;
+	NumTracesLastUpdate = 0;
+
+	while (NumTracesLastUpdate < MaxTracesPerFrame)
+	{
+		FHitResult hitResult;
+		const bool bHit = weapon.TraceThrowPreview(GetSample(TraceCursor), GetSample(TraceCursor + 1), hitResult);
+		NumTracesLastUpdate++;
+
+		if (bHit)
+		{
+			if (HitSegment != TraceCursor || !LodgePoint.Equals(hitResult.ImpactPoint, 1))
+			{
+				bChanged = true;
+			}
+
+			HitSegment = TraceCursor;
+			LodgePoint = hitResult.ImpactPoint;
+			LodgeNormal = hitResult.ImpactNormal;
+			TraceCursor = 0;
+			break;
+		}
+
+		// Past the old lodge point without a hit, whatever was hit there moved away
+		if (TraceCursor == HitSegment)
+		{
+			HitSegment = INDEX_NONE;
+			bChanged = true;
+		}
+
+		TraceCursor++;
+
+		if (TraceCursor >= numSegments)
+		{
+			TraceCursor = 0;
+			break;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ThrowPreviewTraces, NumTracesLastUpdate);
+
+	return bChanged;
+}
+// Forget the arc, the next update starts over
+void FThrowingWeaponTrajectoryPreview::Reset()
+{
+	bHasSamples = false;
+	TraceCursor = 0;
+	HitSegment = INDEX_NONE;
+}
+// Closed form positions (start + velocity * t + gravity * t^2 / 2) of four samples per vector instruction
+void FThrowingWeaponTrajectoryPreview::BuildSamples()
+{
+	const int32 numSamples = Align(FMath::Max(NumSamples, 4), 4);
+
+	X.SetNumUninitialized(numSamples);
+	Y.SetNumUninitialized(numSamples);
+	Z.SetNumUninitialized(numSamples);
+
+	const VectorRegister4Float velocityX = VectorSetFloat1(static_cast<float>(Velocity.X));
+	const VectorRegister4Float velocityY = VectorSetFloat1(static_cast<float>(Velocity.Y));
+	const VectorRegister4Float velocityZ = VectorSetFloat1(static_cast<float>(Velocity.Z));
+	const VectorRegister4Float halfGravityZ = VectorSetFloat1(GravityZ * 0.5f);
+	const VectorRegister4Float timeStep = VectorSetFloat1(SampleInterval * 4);
+
+	VectorRegister4Float time = MakeVectorRegisterFloat(0.f, SampleInterval, SampleInterval * 2, SampleInterval * 3);
+
+	for (int32 i = 0; i < numSamples; i += 4)
+	{
+		VectorStore(VectorMultiply(velocityX, time), X.GetData() + i);
+		VectorStore(VectorMultiply(velocityY, time), Y.GetData() + i);
+		VectorStore(VectorMultiplyAdd(VectorMultiply(halfGravityZ, time), time, VectorMultiply(velocityZ, time)), Z.GetData() + i);
+
+		time = VectorAdd(time, timeStep);
+	}
+
+	bHasSamples = true;
+}
+// Samples up to the lodge point, plus the lodge point itself
+int32 FThrowingWeaponTrajectoryPreview::GetNumVisiblePoints() const
+{
+	if (!bHasSamples)
+	{
+		return 0;
+	}
+	return HitSegment != INDEX_NONE ? HitSegment + 2 : X.Num();
+}
+
+FVector FThrowingWeaponTrajectoryPreview::GetVisiblePoint(int32 index) const
+{
+	return HitSegment != INDEX_NONE && index == HitSegment + 1 ? LodgePoint : GetSample(index);
+}
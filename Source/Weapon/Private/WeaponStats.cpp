@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponStats.h"
+
+#if WITH_WEAPON_PROFILING
+UE_TRACE_CHANNEL_DEFINE(WeaponChannel);
+#endif
+
+DEFINE_STAT(STAT_WeaponThrow);
+DEFINE_STAT(STAT_WeaponRecall);
+DEFINE_STAT(STAT_WeaponUpdateLaunched);
+DEFINE_STAT(STAT_WeaponUpdateWiggle);
+DEFINE_STAT(STAT_WeaponUpdateReturning);
+DEFINE_STAT(STAT_WeaponReturnPose);
+DEFINE_STAT(STAT_WeaponImpact);
+DEFINE_STAT(STAT_WeaponBatchedSimulation);
+DEFINE_STAT(STAT_WeaponActive);
+
+DEFINE_STAT(STAT_ThrowTraceSync);
+DEFINE_STAT(STAT_ThrowTraceAsyncSubmit);
+DEFINE_STAT(STAT_ThrowTraceAsyncConsume);
+DEFINE_STAT(STAT_ThrowTraceAsyncCount);
+DEFINE_STAT(STAT_ThrowTraceAsyncFallbacks);
+DEFINE_STAT(STAT_ThrowTraceAsyncLatency);
+DEFINE_STAT(STAT_ThrowTraceTimeSaved);
+DEFINE_STAT(STAT_TetherSimulate);
+DEFINE_STAT(STAT_TetherParticles);
+DEFINE_STAT(STAT_ThrowPreview);
+DEFINE_STAT(STAT_ThrowPreviewTraces);
+
+DEFINE_STAT(STAT_ThrowTargetQuery);
+DEFINE_STAT(STAT_ThrowTargetCellsVisited);
+DEFINE_STAT(STAT_ThrowTargetCandidates);
+DEFINE_STAT(STAT_ThrowTargets);
+
+DEFINE_STAT(STAT_WeaponComponent);
+
+DEFINE_STAT(STAT_WeaponSignificance);
+DEFINE_STAT(STAT_WeaponSignificanceFull);
+DEFINE_STAT(STAT_WeaponSignificanceReduced);
+DEFINE_STAT(STAT_WeaponSignificanceFar);
+DEFINE_STAT(STAT_WeaponSignificanceEventOnly);
+
+DEFINE_STAT(STAT_WeaponBallistics);
+DEFINE_STAT(STAT_WeaponBallisticBatch);
+DEFINE_STAT(STAT_WeaponBallisticSolves);
+
+DEFINE_STAT(STAT_WeaponImpactDrain);
+DEFINE_STAT(STAT_WeaponImpactQueueDepth);
+DEFINE_STAT(STAT_WeaponImpactsDrained);
+DEFINE_STAT(STAT_WeaponImpactLatency);
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponThrowLatency.h"
+
+#if WITH_WEAPON_THROW_LATENCY
+
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "RenderingThread.h"
+
+/// <summary>
+/// Console commands
+/// </summary>
+
+static FAutoConsoleCommand CmdWeaponThrowLatencyStats(
+	TEXT("Weapon.Latency.Stats"),
+	TEXT("Print input to launch latency percentiles of the recorded throws. Optional argument: reset"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		FWeaponThrowLatency::Get().LogPercentiles();
+
+		if (args.Num() > 0 && args[0] == TEXT("reset"))
+		{
+			FWeaponThrowLatency::Get().Reset();
+		}
+	}));
+
+// The one latency record shared by every player
+FWeaponThrowLatency& FWeaponThrowLatency::Get()
+{
+	static FWeaponThrowLatency Instance;
+	return Instance;
+}
+
+FWeaponThrowLatency::FWeaponThrowLatency()
+{
+	Reset();
+
+	FCoreDelegates::OnEndFrame.AddRaw(this, &FWeaponThrowLatency::EndFrame);
+}
+// The launch input of the local player was processed
+void FWeaponThrowLatency::RecordInput()
+{
+	PendingInputCycles = FPlatformTime::Cycles64();
+	PendingInputFrame = GFrameCounter;
+}
+// ThrowWeapon ran, pairs with the last input (throws without one, like replicated throws, aren't recorded)
+void FWeaponThrowLatency::RecordThrow(const AActor* weapon)
+{
+	if (PendingInputCycles == 0 || weapon == nullptr)
+	{
+		return;
+	}
+
+	FWeaponThrowLatencySample sample;
+	sample.InputCycles = PendingInputCycles;
+	sample.InputFrame = PendingInputFrame;
+	sample.ThrowCycles = FPlatformTime::Cycles64();
+	sample.ThrowFrame = GFrameCounter;
+
+	{
+		FScopeLock lock(&SamplesLock);
+
+		PendingSampleIndex = NextSampleIndex;
+		if (Samples.Num() < Capacity)
+		{
+			Samples.Add(sample);
+		}
+		else
+		{
+			Samples[PendingSampleIndex] = sample;
+		}
+		NextSampleIndex = (NextSampleIndex + 1) % Capacity;
+	}
+
+	PendingInputCycles = 0;
+	PendingWeapon = weapon;
+	PendingLaunchLocation = weapon->GetActorLocation();
+}
+// Look for the end of the first frame the pending weapon moved in, the render thread stamps when it reaches that frame
+void FWeaponThrowLatency::EndFrame()
+{
+	const AActor* weapon = PendingWeapon.Get();
+	if (weapon == nullptr || weapon->GetActorLocation().Equals(PendingLaunchLocation, 0.01))
+	{
+		return;
+	}
+
+	PendingWeapon.Reset();
+
+	const uint64 throwCycles = [this]()
+	{
+		FScopeLock lock(&SamplesLock);
+
+		FWeaponThrowLatencySample& sample = Samples[PendingSampleIndex];
+		sample.MovedCycles = FPlatformTime::Cycles64();
+		sample.MovedFrame = GFrameCounter;
+		return sample.ThrowCycles;
+	}();
+
+	// Render commands run in order, so this runs once the scene update with the moved weapon is on the render thread
+	const int32 sampleIndex = PendingSampleIndex;
+	ENQUEUE_RENDER_COMMAND(FWeaponThrowLatencyRendered)(
+		[this, sampleIndex, throwCycles](FRHICommandListImmediate& RHICmdList)
+		{
+			FScopeLock lock(&SamplesLock);
+
+			// The slot may have been reused by a later throw in the meantime
+			if (Samples.IsValidIndex(sampleIndex) && Samples[sampleIndex].ThrowCycles == throwCycles)
+			{
+				Samples[sampleIndex].RenderedCycles = FPlatformTime::Cycles64();
+			}
+		});
+}
+// Print input to throw, input to moved and input to rendered percentiles, in milliseconds and frames
+void FWeaponThrowLatency::LogPercentiles() const
+{
+	TArray<double> throwMs;
+	TArray<double> movedMs;
+	TArray<double> renderedMs;
+	TArray<double> movedFrames;
+
+	{
+		FScopeLock lock(&SamplesLock);
+
+		for (const FWeaponThrowLatencySample& sample : Samples)
+		{
+			throwMs.Add(FPlatformTime::ToMilliseconds64(sample.ThrowCycles - sample.InputCycles));
+
+			if (sample.MovedCycles != 0)
+			{
+				movedMs.Add(FPlatformTime::ToMilliseconds64(sample.MovedCycles - sample.InputCycles));
+				movedFrames.Add(static_cast<double>(sample.MovedFrame - sample.InputFrame));
+			}
+			if (sample.RenderedCycles != 0)
+			{
+				renderedMs.Add(FPlatformTime::ToMilliseconds64(sample.RenderedCycles - sample.InputCycles));
+			}
+		}
+	}
+
+	auto logPercentiles = [](const TCHAR* name, TArray<double>& values, const TCHAR* unit)
+	{
+		if (values.Num() == 0)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %-18s no samples"), name);
+			return;
+		}
+
+		values.Sort();
+		auto percentile = [&values](double fraction) { return values[FMath::Min(FMath::FloorToInt(fraction * values.Num()), values.Num() - 1)]; };
+
+		UE_LOG(LogTemp, Display, TEXT("  %-18s p50 %7.3f, p90 %7.3f, p99 %7.3f, max %7.3f %s"), name, percentile(0.5), percentile(0.9), percentile(0.99), values.Last(), unit);
+	};
+
+	UE_LOG(LogTemp, Display, TEXT("Throw latency (%d throws):"), throwMs.Num());
+	logPercentiles(TEXT("input to throw"), throwMs, TEXT("ms"));
+	logPercentiles(TEXT("input to moved"), movedMs, TEXT("ms"));
+	logPercentiles(TEXT("input to rendered"), renderedMs, TEXT("ms"));
+	logPercentiles(TEXT("frames to moved"), movedFrames, TEXT("frames"));
+}
+// Forget every throw
+void FWeaponThrowLatency::Reset()
+{
+	FScopeLock lock(&SamplesLock);
+
+	Samples.Reset(Capacity);
+	NextSampleIndex = 0;
+	PendingInputCycles = 0;
+	PendingInputFrame = 0;
+	PendingWeapon.Reset();
+	PendingLaunchLocation = FVector::ZeroVector;
+	PendingSampleIndex = INDEX_NONE;
+}
+
+#endif
@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponTraceDiagnostics.h"
+
+#if WITH_WEAPON_TRACE_DIAGNOSTICS
+
+#include "DrawDebugHelpers.h"
+#include "Engine/HitResult.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+/// <summary>
+/// Console variables and commands
+/// </summary>
+
+static int32 GWeaponTraceDiagnosticsDraw = 0;
+static FAutoConsoleVariableRef CVarWeaponTraceDiagnosticsDraw(
+	TEXT("Weapon.TraceDiagnostics.Draw"),
+	GWeaponTraceDiagnosticsDraw,
+	TEXT("Draw every throwing weapon trace as it happens. 0: off, 1: on"));
+
+static float GWeaponTraceDiagnosticsDrawDuration = 1;
+static FAutoConsoleVariableRef CVarWeaponTraceDiagnosticsDrawDuration(
+	TEXT("Weapon.TraceDiagnostics.DrawDuration"),
+	GWeaponTraceDiagnosticsDrawDuration,
+	TEXT("How long, in seconds, drawn throwing weapon traces stay on screen"));
+
+static FAutoConsoleCommandWithWorld CmdWeaponTraceDiagnosticsDrawHistory(
+	TEXT("Weapon.TraceDiagnostics.DrawHistory"),
+	TEXT("Draw every throwing weapon trace kept in the diagnostics ring buffer"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* world)
+	{
+		FWeaponTraceDiagnostics::Get().Draw(world, GWeaponTraceDiagnosticsDrawDuration);
+	}));
+
+static FAutoConsoleCommand CmdWeaponTraceDiagnosticsDumpCsv(
+	TEXT("Weapon.TraceDiagnostics.DumpCsv"),
+	TEXT("Write the throwing weapon traces kept in the ring buffer to Saved/Profiling. Optional argument: file name"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		const FString fileName = args.Num() > 0 ? args[0] : FString::Printf(TEXT("WeaponTraces-%s.csv"), *FDateTime::Now().ToString());
+		const FString filePath = FPaths::Combine(FPaths::ProfilingDir(), fileName);
+
+		if (FWeaponTraceDiagnostics::Get().DumpToCsv(filePath))
+		{
+			UE_LOG(LogTemp, Display, TEXT("Throwing weapon traces written to %s"), *filePath);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not write throwing weapon traces to %s"), *filePath);
+		}
+	}));
+
+static FAutoConsoleCommand CmdWeaponTraceDiagnosticsStats(
+	TEXT("Weapon.TraceDiagnostics.Stats"),
+	TEXT("Print the throwing weapon trace hit/miss/latency counters"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FWeaponTraceDiagnostics::Get().LogCounters();
+	}));
+
+static FAutoConsoleCommand CmdWeaponTraceDiagnosticsReset(
+	TEXT("Weapon.TraceDiagnostics.Reset"),
+	TEXT("Forget every recorded throwing weapon trace and zero the counters"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FWeaponTraceDiagnostics::Get().Reset();
+	}));
+
+// The one diagnostics instance shared by every throwing weapon
+FWeaponTraceDiagnostics& FWeaponTraceDiagnostics::Get()
+{
+	static FWeaponTraceDiagnostics Instance;
+	return Instance;
+}
+
+FWeaponTraceDiagnostics::FWeaponTraceDiagnostics()
+{
+	Reset();
+}
+// Store a trace in the ring buffer and update the counters. Async traces get their own latency counters
+void FWeaponTraceDiagnostics::Record(const UWorld* world, const FVector& start, const FVector& end, const FHitResult& hitResult, bool bHit, bool bSwept, bool bAsync, uint64 startCycles)
+{
+	FWeaponTraceRecord& record = Records[NextRecordIndex];
+	record.Start = start;
+	record.End = end;
+	record.ImpactPoint = bHit ? FVector(hitResult.ImpactPoint) : end;
+	record.WorldTimeSeconds = world != nullptr ? world->GetTimeSeconds() : 0;
+	record.LatencyMicroseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles) * 1000;
+	record.bHit = bHit;
+	record.bSwept = bSwept;
+	record.bAsync = bAsync;
+
+	NextRecordIndex = (NextRecordIndex + 1) % Capacity;
+	NumRecords = FMath::Min(NumRecords + 1, Capacity);
+
+	if (bHit)
+	{
+		NumHits++;
+	}
+	else
+	{
+		NumMisses++;
+	}
+
+	if (bAsync)
+	{
+		NumAsyncTraces++;
+		TotalAsyncLatencyMicroseconds += record.LatencyMicroseconds;
+		MaxAsyncLatencyMicroseconds = FMath::Max(MaxAsyncLatencyMicroseconds, record.LatencyMicroseconds);
+	}
+	else
+	{
+		TotalLatencyMicroseconds += record.LatencyMicroseconds;
+		MaxLatencyMicroseconds = FMath::Max(MaxLatencyMicroseconds, record.LatencyMicroseconds);
+	}
+
+	if (GWeaponTraceDiagnosticsDraw != 0)
+	{
+		DrawRecord(world, record, GWeaponTraceDiagnosticsDrawDuration);
+	}
+}
+// Draw every remembered trace
+void FWeaponTraceDiagnostics::Draw(const UWorld* world, float duration) const
+{
+	for (int32 i = 0; i < NumRecords; i++)
+	{
+		DrawRecord(world, Records[i], duration);
+	}
+}
+// Draw one trace, yellow up to the impact and red after it
+void FWeaponTraceDiagnostics::DrawRecord(const UWorld* world, const FWeaponTraceRecord& record, float duration) const
+{
+	if (world == nullptr)
+	{
+		return;
+	}
+
+	DrawDebugLine(world, record.Start, record.ImpactPoint, FColor::Yellow, false, duration);
+
+	if (record.bHit)
+	{
+		DrawDebugLine(world, record.ImpactPoint, record.End, FColor::Red, false, duration);
+		DrawDebugPoint(world, record.ImpactPoint, 8, FColor::Red, false, duration);
+	}
+}
+// Write every remembered trace, oldest first, and the counters to a CSV file
+bool FWeaponTraceDiagnostics::DumpToCsv(const FString& filePath) const
+{
+	FString csv = TEXT("WorldTime,StartX,StartY,StartZ,EndX,EndY,EndZ,ImpactX,ImpactY,ImpactZ,Hit,Swept,Async,LatencyUs\n");
+
+	const int32 oldestRecordIndex = NumRecords < Capacity ? 0 : NextRecordIndex;
+	for (int32 i = 0; i < NumRecords; i++)
+	{
+		const FWeaponTraceRecord& record = Records[(oldestRecordIndex + i) % Capacity];
+		csv += FString::Printf(TEXT("%.4f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,%d,%.2f\n"),
+			record.WorldTimeSeconds,
+			record.Start.X, record.Start.Y, record.Start.Z,
+			record.End.X, record.End.Y, record.End.Z,
+			record.ImpactPoint.X, record.ImpactPoint.Y, record.ImpactPoint.Z,
+			record.bHit ? 1 : 0, record.bSwept ? 1 : 0, record.bAsync ? 1 : 0, record.LatencyMicroseconds);
+	}
+
+	const uint64 numSyncTraces = NumHits + NumMisses - NumAsyncTraces;
+	csv += FString::Printf(TEXT("# Hits=%llu,Misses=%llu,AverageLatencyUs=%.2f,MaxLatencyUs=%.2f,AsyncTraces=%llu,AverageAsyncLatencyUs=%.2f,MaxAsyncLatencyUs=%.2f\n"),
+		NumHits, NumMisses, numSyncTraces > 0 ? TotalLatencyMicroseconds / numSyncTraces : 0.0, MaxLatencyMicroseconds,
+		NumAsyncTraces, NumAsyncTraces > 0 ? TotalAsyncLatencyMicroseconds / NumAsyncTraces : 0.0, MaxAsyncLatencyMicroseconds);
+
+	return FFileHelper::SaveStringToFile(csv, *filePath);
+}
+// Print the hit/miss/latency counters
+void FWeaponTraceDiagnostics::LogCounters() const
+{
+	const uint64 numTraces = NumHits + NumMisses;
+	const uint64 numSyncTraces = numTraces - NumAsyncTraces;
+	UE_LOG(LogTemp, Display, TEXT("Throwing weapon traces: %llu (hits %llu, misses %llu), average latency %.2f us, max latency %.2f us"),
+		numTraces, NumHits, NumMisses, numSyncTraces > 0 ? TotalLatencyMicroseconds / numSyncTraces : 0.0, MaxLatencyMicroseconds);
+	UE_LOG(LogTemp, Display, TEXT("Throwing weapon async traces: %llu, average submit to use %.2f us, max %.2f us"),
+		NumAsyncTraces, NumAsyncTraces > 0 ? TotalAsyncLatencyMicroseconds / NumAsyncTraces : 0.0, MaxAsyncLatencyMicroseconds);
+}
+// Forget every trace and zero the counters
+void FWeaponTraceDiagnostics::Reset()
+{
+	NextRecordIndex = 0;
+	NumRecords = 0;
+	NumHits = 0;
+	NumMisses = 0;
+	TotalLatencyMicroseconds = 0;
+	MaxLatencyMicroseconds = 0;
+	NumAsyncTraces = 0;
+	TotalAsyncLatencyMicroseconds = 0;
+	MaxAsyncLatencyMicroseconds = 0;
+}
+
+#endif
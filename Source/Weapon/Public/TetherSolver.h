@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// <summary>
+/// Verlet rope pinned at both ends. Particles are kept as padded structs of arrays so integration and every
+/// constraint iteration run four particles per vector instruction. Constraints are solved Jacobi style
+/// (all links at once, then all particles), which is what lets the links be vectorized
+/// </summary>
+struct WEAPON_API FTetherSolver
+{
+public:
+
+	void Reset(int32 numSegments, const FVector& start, const FVector& end); // Straight rope from start to end
+
+	void SetNumSegments(int32 numSegments); // Change the resolution, keeping the current shape
+
+	void Simulate(const FVector& start, const FVector& end, float segmentLength, const FVector& gravity, float deltaTime, float damping, int32 iterations); // One Verlet step and the constraint iterations
+
+	int32 GetNumParticles() const { return NumParticles; }
+	int32 GetNumSegments() const { return FMath::Max(NumParticles - 1, 0); }
+
+	FVector GetParticle(int32 index) const { return Origin + FVector(X[index], Y[index], Z[index]); }
+
+	void GetParticles(TArray<FVector3f>& outParticles) const; // Every particle in world space (single precision for rendering)
+
+	FBox GetBounds() const; // World space box around every particle
+
+private:
+
+	void Allocate(int32 numParticles);
+
+	void Rebase(const FVector& newOrigin); // Keep the single precision particles close to the origin
+
+	void PinEnds(const FVector3f& localStart, const FVector3f& localEnd);
+
+	int32 NumParticles = 0;
+	int32 NumPaddedParticles = 0; // NumParticles rounded up to a multiple of four
+
+	FVector Origin = FVector::ZeroVector; // Particles are stored relative to this point
+
+	// Particle positions and last positions, padded with four extra slots so a vector load at any particle stays in bounds
+	TArray<float> X, Y, Z;
+	TArray<float> PreviousX, PreviousY, PreviousZ;
+
+	// Correction of every link, index 0 is a zero so particle i reads its two links at i and i + 1
+	TArray<float> CorrectionX, CorrectionY, CorrectionZ;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "ThrowTargetComponent.generated.h"
+
+class UThrowTargetSubsystem;
+
+/// <summary>
+/// Marks the point of an actor that lock-on and aim assist aim throws at. Registers with UThrowTargetSubsystem while
+/// the actor plays and keeps its grid cell up to date as it moves
+/// </summary>
+UCLASS(ClassGroup = (Weapon), meta = (BlueprintSpawnableComponent))
+class WEAPON_API UThrowTargetComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UThrowTargetComponent();
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) override;
+
+#pragma region VARIABLES
+
+public:
+
+	// Scales the target's score, higher is picked over an equally placed target
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Throw Target", meta = (ClampMin = "0.0"))
+		float Priority;
+
+	// Can throws lock on to this target right now?
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Throw Target")
+		bool bIsTargetable;
+
+private:
+
+	UPROPERTY()
+		UThrowTargetSubsystem* ThrowTargetSubsystem; // Subsystem the target is registered with, nullptr when it isn't
+
+	int32 TargetHandle; // Handle in the subsystem grid
+
+#pragma endregion
+};
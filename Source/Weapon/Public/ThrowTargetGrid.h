@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/SparseArray.h"
+
+/// <summary>
+/// Uniform grid spatial hash of target locations. Only occupied cells are stored, a move only touches the grid when the
+/// target crosses into another cell, and queries visit at most a given number of cells so their cost stays bounded
+/// however many targets there are
+/// </summary>
+struct WEAPON_API FThrowTargetGrid
+{
+public:
+
+	explicit FThrowTargetGrid(float cellSize = 1000);
+
+	int32 Add(const FVector& location); // Insert a target, returns its handle
+	void Move(int32 handle, const FVector& location); // Update a target, changes cell only when it crossed a cell border
+	void Remove(int32 handle);
+
+	bool IsValidHandle(int32 handle) const { return Targets.IsValidIndex(handle); }
+	const FVector& GetLocation(int32 handle) const { return Targets[handle].Location; }
+	int32 Num() const { return Targets.Num(); }
+	int32 GetNumCells() const { return Cells.Num(); }
+	float GetCellSize() const { return CellSize; }
+
+	// Targets inside the cone, returns the cells visited. The cone is shortened until its bounds fit in maxCells
+	int32 QueryCone(const FVector& origin, const FVector& direction, float halfAngleRadians, float maxDistance, int32 maxCells, TArray<int32>& outHandles) const;
+
+	// Targets inside the sphere, returns the cells visited. The sphere is shrunk until its bounds fit in maxCells
+	int32 QuerySphere(const FVector& center, float radius, int32 maxCells, TArray<int32>& outHandles) const;
+
+private:
+
+	struct FTarget
+	{
+		FVector Location;
+		FIntVector Cell;
+		int32 SlotInCell; // Index in the cell's handle array, so removal is a swap
+	};
+
+	FIntVector GetCell(const FVector& location) const;
+
+	void AddToCell(int32 handle, const FIntVector& cell);
+	void RemoveFromCell(int32 handle);
+
+	template <typename TPredicate>
+	int32 VisitBox(const FIntVector& minCell, const FIntVector& maxCell, TPredicate isInside, TArray<int32>& outHandles) const; // Test every target in the occupied cells of the box
+
+	static int64 CountCells(const FIntVector& minCell, const FIntVector& maxCell);
+
+	float CellSize;
+	float InvCellSize;
+
+	TSparseArray<FTarget> Targets; // Indexed by handle
+	TMap<FIntVector, TArray<int32>> Cells; // Handles of the targets in each occupied cell
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ThrowTargetGrid.h"
+#include "ThrowTargetSubsystem.generated.h"
+
+class UThrowTargetComponent;
+
+/// <summary>
+/// Every throw target of the world in a uniform grid spatial hash, so lock-on and aim assist can ask for the targets in a
+/// cone every frame at a cost bounded by Weapon.Targets.MaxQueryCells instead of the number of targets
+/// </summary>
+UCLASS()
+class WEAPON_API UThrowTargetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+#pragma region FUNCTIONS
+
+public:
+
+	int32 RegisterTarget(UThrowTargetComponent* target); // Add a target at its current location, returns its handle
+
+	void UnregisterTarget(int32 handle);
+
+	void MoveTarget(int32 handle, const FVector& location); // Only touches the grid when the target crossed a cell border
+
+	void QueryCone(const FVector& origin, const FVector& direction, float halfAngleDegrees, float maxDistance, TArray<UThrowTargetComponent*>& outTargets) const; // Every target inside the cone
+
+	void QuerySphere(const FVector& center, float radius, TArray<UThrowTargetComponent*>& outTargets) const; // Every target inside the sphere
+
+	UThrowTargetComponent* FindBestTarget(const FVector& origin, const FVector& direction, float halfAngleDegrees, float maxDistance, const AActor* ignoredActor) const; // Best of centered and near, scaled by priority
+
+	int32 GetNumTargets() const { return Grid.Num(); }
+
+private:
+
+	void GatherTargets(TArray<UThrowTargetComponent*>& outTargets) const; // Components of the handles the last query found
+
+#pragma endregion
+
+#pragma region VARIABLES
+
+private:
+
+	FThrowTargetGrid Grid;
+
+	UPROPERTY()
+		TArray<TObjectPtr<UThrowTargetComponent>> Targets; // Indexed by grid handle
+
+	mutable TArray<int32> QueryHandles; // Reused by every query so it doesn't allocate
+
+#pragma endregion
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ThrowingWeaponArchetype.generated.h"
+
+class UCurveFloat;
+class UStaticMesh;
+
+/// <summary>
+/// A throwing weapon variant: its mesh and curves. Everything is a soft reference so a variant is only in memory while a
+/// weapon uses it or a preload manifest lists it (see UThrowingWeaponArchetypeSubsystem)
+/// </summary>
+UCLASS(BlueprintType)
+class WEAPON_API UThrowingWeaponArchetype : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	// Mesh shown by the weapon, the weapon keeps its own mesh when empty
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Mesh")
+		TSoftObjectPtr<UStaticMesh> Mesh;
+
+	// Handles rotation forward
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Timeline")
+		TSoftObjectPtr<UCurveFloat> RotationForwardCurve;
+
+	// How fast the throwing weapon takes to return to the player
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Timeline")
+		TSoftObjectPtr<UCurveFloat> ReturnSpeedCurve;
+
+	// How much the throwing weapon should wiggle when lodged before recalling
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Timeline")
+		TSoftObjectPtr<UCurveFloat> WiggleCurve;
+
+	void GetAssetPaths(TArray<FSoftObjectPath>& outPaths) const; // Every set soft reference, loaded together with the archetype
+};
+
+/// <summary>
+/// Archetypes loaded at startup and kept resident, for variants that must be ready the moment they are equipped
+/// </summary>
+UCLASS(BlueprintType)
+class WEAPON_API UThrowingWeaponPreloadManifest : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Preload")
+		TArray<TSoftObjectPtr<UThrowingWeaponArchetype>> Archetypes;
+};
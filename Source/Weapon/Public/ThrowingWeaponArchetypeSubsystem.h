@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ThrowingWeaponArchetype.h"
+#include "ThrowingWeaponArchetypeSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+DECLARE_DELEGATE_OneParam(FOnThrowingWeaponArchetypeLoaded, UThrowingWeaponArchetype*);
+
+/// <summary>
+/// Loads throwing weapon archetypes asynchronously (the archetype first, then its mesh and curves) and keeps them resident
+/// while any weapon uses them. Archetypes in the preload manifest, set in DefaultGame.ini, are loaded at startup and kept
+/// </summary>
+UCLASS(Config = Game)
+class WEAPON_API UThrowingWeaponArchetypeSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RequestArchetype(const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype, FOnThrowingWeaponArchetypeLoaded onLoaded); // Add a user, onLoaded runs once everything is in memory (right away if it already is)
+	void ReleaseArchetype(const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype); // Remove a user, unused archetypes that aren't preloaded can be garbage collected
+
+	bool IsArchetypeLoaded(const TSoftObjectPtr<UThrowingWeaponArchetype>& archetype) const;
+
+	int32 GetNumResidentArchetypes() const { return Archetypes.Num(); }
+
+private:
+
+	/// <summary>
+	/// Load state of one archetype, the handles keep the archetype and its assets in memory
+	/// </summary>
+	struct FArchetypeLoad
+	{
+		TSharedPtr<FStreamableHandle> ArchetypeHandle;
+		TSharedPtr<FStreamableHandle> AssetsHandle;
+		TArray<FOnThrowingWeaponArchetypeLoaded> Waiting; // Called once the assets are loaded
+		int32 NumUsers = 0;
+		bool bPreloaded = false; // Listed in the manifest, kept without users
+		bool bLoaded = false;
+	};
+
+	FArchetypeLoad& LoadArchetype(const FSoftObjectPath& path); // Start loading the archetype if it isn't already
+	void ArchetypeLoaded(FSoftObjectPath path);
+	void AssetsLoaded(FSoftObjectPath path);
+
+	UPROPERTY(Config)
+		TSoftObjectPtr<UThrowingWeaponPreloadManifest> PreloadManifest; // Archetypes to load at startup and keep
+
+	TSharedPtr<FStreamableHandle> PreloadManifestHandle;
+
+	TMap<FSoftObjectPath, FArchetypeLoad> Archetypes; // Every requested or preloaded archetype
+};
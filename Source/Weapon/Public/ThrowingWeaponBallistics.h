@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// <summary>
+/// Which of the (up to) two launch directions that reach a target to pick
+/// </summary>
+enum class EThrowingWeaponArc : uint8
+{
+	Low, // Flattest and fastest flight
+	High // Lob over whatever is in between
+};
+
+/// <summary>
+/// One shooter/target pair of a batched solve
+/// </summary>
+struct FThrowingWeaponBallisticQuery
+{
+	FVector Start = FVector::ZeroVector; // Where the flight starts
+	FVector Target = FVector::ZeroVector; // Where the target is now
+	FVector TargetVelocity = FVector::ZeroVector; // Zero for a target that stands still
+};
+
+/// <summary>
+/// Launch that hits the target, Time is negative when the target is out of reach
+/// </summary>
+struct FThrowingWeaponBallisticSolution
+{
+	FVector Direction = FVector::ZeroVector; // Unit launch direction
+	FVector AimPoint = FVector::ZeroVector; // Where the target is when the weapon gets there
+	float Time = -1; // Seconds of flight to the target
+
+	bool IsValid() const { return Time >= 0; }
+};
+
+/// <summary>
+/// Closed form launch directions for a throw at a fixed speed under constant gravity. Solves |d + v t - g t^2 / 2| = s t for
+/// the flight time t (d target relative to the start, v target velocity, g gravity, s launch speed): a quadratic in t^2 for a
+/// still target and a quartic for a moving one, solved with Ferrari's method. Needs nothing but Core and never allocates
+/// </summary>
+struct WEAPON_API FThrowingWeaponBallistics
+{
+	static bool Solve(const FVector& start, const FVector& target, float speed, float gravityZ, EThrowingWeaponArc arc, FThrowingWeaponBallisticSolution& outSolution); // Still target, false when it is out of reach
+
+	static bool SolveLeading(const FVector& start, const FVector& target, const FVector& targetVelocity, float speed, float gravityZ, EThrowingWeaponArc arc, FThrowingWeaponBallisticSolution& outSolution); // Moving target, aims where it will be
+
+	static int32 SolveBatch(TArrayView<const FThrowingWeaponBallisticQuery> queries, float speed, float gravityZ, EThrowingWeaponArc arc, TArrayView<FThrowingWeaponBallisticSolution> outSolutions); // Every pair with the same speed and gravity, returns how many are in reach
+};
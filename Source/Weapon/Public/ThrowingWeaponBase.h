@@ -4,7 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
-#include "Runtime/Engine/Classes/Components/TimelineComponent.h"
+#include "CollisionQueryParams.h"
+#include "WorldCollision.h"
+#include "Struct/public/BakedCurve.h"
+#include "ThrowingWeaponSimulation.h"
 #include "ThrowingWeaponBase.generated.h"
 
 /// <summary>
@@ -23,11 +26,24 @@ enum ThrowingWeaponState
 class UCapsuleComponent;
 class UProjectileMovementComponent;
 class APlayerCharacterBase;
+class UThrowingWeaponSubsystem;
+class UThrowingWeaponArchetype;
+class AThrowingWeaponBase;
+class UDamageType;
+class USoundBase;
+struct FStreamableHandle;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnThrowingWeaponStateChanged, AThrowingWeaponBase*, ThrowingWeaponState);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnThrowingWeaponImpact, AThrowingWeaponBase*, const FHitResult&);
 
 UCLASS()
 class WEAPON_API AThrowingWeaponBase : public AActor
 {
 	GENERATED_BODY()
+
+	friend class UThrowingWeaponSubsystem; // Batched simulation drives the weapon state directly
+	friend struct FThrowingWeaponBatch;
+	friend class UThrowingWeaponSignificanceSubsystem; // Reads what limits the tick rate and sets it on the projectile movement too
 	
 public:	
 	// Sets default values for this actor's properties
@@ -37,6 +53,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the weapon is destroyed or the level ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -71,28 +90,42 @@ private:
 
 	// Necessary for projectile motions
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category = "Projectile", meta = (AllowPrivateAccess = true))
-		UProjectileMovementComponent* ProjectileMovementComponent; 
+		UProjectileMovementComponent* ProjectileMovementComponent;
+#pragma endregion
 
-	// Timeline component for throwing weapon rotation forward	
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UTimelineComponent* TLThrowingWeaponRotationForwardComponent;
+#pragma region FUNCTIONS
 
-	// Timeline for the gravitation to kick in
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UTimelineComponent* TLWeaponThrowTraceComponent; 
+public:
 
-	// Timeline for return movement (mainly speed)
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UTimelineComponent* TLThrowingWeaponReturnComponent; 
+	UFUNCTION(BlueprintCallable)
+		void SetUseBatchedSimulation(bool bNewUseBatchedSimulation); // Switch between batched and per actor simulation while the weapon is Idle
 
-	// Timeline for wiggling the lodged throwing weapon
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UTimelineComponent* TLWiggleThrowingWeaponComponent; 
-#pragma endregion
+	UFUNCTION(BlueprintCallable)
+		void SetThrowingWeaponState(ThrowingWeaponState newState); // Change state, tick only while there is something to update and keep the batched simulation in sync
 
-#pragma region FUNCTIONS
+	UFUNCTION()
+		void SetOwningPlayer(APlayerCharacterBase* owningPlayer); // The player the weapon returns to (the local player unless set)
 
-public:
+	UFUNCTION()
+		void ReconcileLodge(FVector actorLocation, FRotator lodgePointRotation); // Match a lodge decided by the server, whatever this weapon predicted
+
+	UFUNCTION(BlueprintPure)
+		FRotator GetLodgePointRotation() const; // Relative rotation of the lodge point (set when the weapon lodges)
+
+	void PredictLaunch(const FVector& throwDirection, const FVector& cameraLocation, FVector& outLocation, FVector& outVelocity, float& outGravityZ) const; // Where ThrowWeapon would start the flight and how fast
+
+	bool TraceThrowPreview(const FVector& start, const FVector& end, FHitResult& hitResult) const; // Line trace against whatever the throw trace hits
+
+	UFUNCTION(BlueprintCallable)
+		bool SolveThrowDirection(FVector cameraLocation, FVector targetLocation, FVector targetVelocity, bool bHighArc, FVector& outThrowDirection) const; // ThrowWeapon's throwDirection that hits the (moving) target, false when it is out of reach
+
+	void SetArchetype(const TSoftObjectPtr<UThrowingWeaponArchetype>& newArchetype); // Load a weapon variant in the background and swap it on when it is ready
+
+	bool IsArchetypeReady() const { return bIsArchetypeReady; } // Are the mesh and curves of the current variant in memory?
+
+	static FCollisionShape MakeThrowSweepShape(const UStaticMeshComponent* meshComponent, float inflation); // Box of the mesh's scaled local bounds, to be swept with the mesh rotation
+
+	static bool SweepThrowPath(const UWorld* world, const FThrowingWeaponSweepPath& path, const FQuat& rotation, const FCollisionShape& shape, const FCollisionQueryParams& queryParams, FHitResult& hitResult); // Sweep segment by segment, stopping at the first blocking hit
 
 protected:		
 	
@@ -105,38 +138,68 @@ protected:
 private:
 
 	UFUNCTION()
-		void TLThrowingWeaponRotationForwardFloatUpdate(float value); // Timeline update for throwing weapon forward rotation
+		void UpdateLaunchedThrowingWeapon(float deltaTime); // Spin and impact trace of the launched throwing weapon
 
 	UFUNCTION()
-		void TLThrowingWeaponRotationForwardFinished(); // Timeline finished throwing weapon forward rotation 
+		void UpdateWiggleThrowingWeapon(float deltaTime); // Wiggle the lodged throwing weapon loose while it starts returning
 
 	UFUNCTION()
-		void TLWeaponThrowTraceFloatUpdate(float value); // Timeline update for launched throwing weapon (trajectory and collision)
+		void UpdateReturningThrowingWeapon(float deltaTime); // Move the returning throwing weapon towards the player
 
 	UFUNCTION()
-		void TLWeaponThrowTraceFinished(); // Timeline finished for launched throwing weapon
+		bool AdvanceThrowingWeaponReturn(float deltaTime); // Move along the return speed curve, true once the curve is finished
 
 	UFUNCTION()
-		void TLStopWeaponThrowTrace(); // Stops the throwing weapon trajectory trajectory
+		void ThrowingWeaponWiggleFinished(); // The lodged throwing weapon is loose
 
 	UFUNCTION()
-		void TLCalculateThrowingWeaponReturnPosition(); // Timeline Update for recalling the throwing weapon
+		void ThrowingWeaponReturnFinished(); // The throwing weapon is back at the player
 
 	UFUNCTION()
-		void TLThrowingWeaponReturnFinished(); // Timeline finished for recalling the throwing weapon
+		bool TraceThrowingWeaponFlight(FVector velocity, FHitResult& hitResult); // Trace for impacts with the configured collision mode
 
 	UFUNCTION()
-		void TLWiggleLodgedThrowingWeaponFloatUpdate(float value); // Timeline update for wiggling the lodged throwing weapon before recalling 
+		bool TraceThrowingWeaponFlightSync(FVector velocity, FHitResult& hitResult); // Trace right now on the game thread
 
 	UFUNCTION()
-		void TLWiggleLodgedThrowingWeaponFinished(); // Timeline finished for wiggling the lodged throwing weapon
+		bool TraceThrowingWeaponFlightAsync(FVector velocity, FHitResult& hitResult); // Use last frame's async result and queue this frame's trace
 
 	UFUNCTION()
-		void StartThrowingWeaponRotationForward(); // Starts the weapon rotation when it's thrown
+		void QueueAsyncThrowTrace(FVector velocity); // Queue this frame's trace for the subsystem to submit
+
+	void UpdateLowLatencyTickOrder(); // Tick after the owner's controller while the low latency throw is on
+
+	void TrackActiveWeapon(ThrowingWeaponState oldState, ThrowingWeaponState newState); // Keep the active weapon stat and trace counter in step with state changes
+
+	void RequestArchetype(); // Load Archetype (or the weapon's own curves without one) and apply it when ready
+
+	void ReleaseArchetype(); // Stop keeping the current variant in memory for this weapon
+
+	void ApplyArchetype(UThrowingWeaponArchetype* archetype); // Swap the loaded mesh and curves onto the weapon
+
+	void BakeCurves(const UCurveFloat* rotationForwardCurve, const UCurveFloat* returnSpeedCurve, const UCurveFloat* wiggleCurve); // Shared tables of the curves, constant ones for missing curves
 
 	UFUNCTION()
-		void StopThrowingWeaponRotation(); // Stops the weapon rotation	
-	
+		bool LineTraceThrowingWeaponFlight(FHitResult& hitResult); // Fixed look-ahead line trace along the throwing weapon forward vector
+
+	UFUNCTION()
+		bool SweepThrowingWeaponFlight(FVector velocity, FHitResult& hitResult); // Sweeps the throwing weapon shape along the path it travelled since the last trace
+
+	FThrowingWeaponFlightSample MakeThrowTraceSample(FVector velocity) const; // Where the swept shape is now, the next sweep starts from it
+
+	FCollisionShape GetThrowSweepShape() const; // Box of the mesh's local bounds, swept with the mesh rotation
+
+	UFUNCTION()
+		void PublishThrowingWeaponImpact(const FHitResult& hitResult, FVector velocity); // Hand the impact to the subsystem's once per frame drain (lodged right away without a subsystem)
+
+	UFUNCTION()
+		void HandleThrowingWeaponImpact(const FHitResult& hitResult, FVector velocity); // Stop the flight and lodge the throwing weapon where it hit
+
+	void ApplyThrowingWeaponImpactEffects(const FHitResult& hitResult, FVector velocity); // Damage whatever was hit and play the impact effects
+
+	UFUNCTION()
+		void StartThrowingWeaponRotationForward(); // Starts the weapon rotation when it's thrown
+
 	UFUNCTION()
 		void SnapThrowingWeaponToStartPosition(); // Snap throwing weapon to center of screen ( corshair)
 	
@@ -150,20 +213,18 @@ private:
 		void AdjustThrowingWeaponReturnLocation(); // Adjust return location of throwing weapon based on player location
 
 	UFUNCTION()
-		void ReturnPosition(); // Calculate return time
+		void ReturnPosition(); // Build the return path and the play rate that arrives at the player
 
 	UFUNCTION()
 		void CalculateThrowingWeaponReturn(float speedCurve); // Calculate the return for all the return timeline curves
 
-	UFUNCTION()
-		void WiggleLodgedThrowingWeapon(); // Logic for wiggling the lodged throwing weapon
+	FThrowingWeaponReturnPose CalculateThrowingWeaponReturnPose(float speedCurve) const; // Pure part of the return, safe on a worker while the game thread waits for it
 
-	UFUNCTION()
-		void ResetWiggleTimerDelay(); // Timer for how long the throwing weapon should wiggle 
+	void CommitThrowingWeaponReturnPose(const FThrowingWeaponReturnPose& returnPose); // Move the weapon to the return pose (game thread)
 
 	UFUNCTION()
-		void ResetThrowingWeaponReturnDelay(); // Reset the timer for how long the throwing weapon should wiggle
-		
+		void WiggleLodgedThrowingWeapon(); // Logic for wiggling the lodged throwing weapon
+
 	UFUNCTION()
 		FRotator ReturnCameraStartRotation(); // // Returns the rotation of the camera
 
@@ -176,11 +237,8 @@ private:
 	UFUNCTION()
 		float AdjustThrowingWeaponImpactPitch(FVector impactNormal, float inclinedSurfaceRange, float regularSurfaceRange); // Adjusts the vertical rise of the throwing weapon handle based on surface
 
-	UFUNCTION()
-		float GetClampedThrowingWeaponDistanceFromPlayer(float maxDistance); // Gets the max distance from player 
-
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-		float CalculateThrowingWeaponReturnTimelineSpeed(float optimalDistance, float throwingWeaponReturnSpeed); // Checks how long it will take for the throwing weapon to return to the player
+		float CalculateThrowingWeaponReturnTimelineSpeed() const; // Return curve play rate that arrives at the player when the return path's duration is up
 
 	
 #pragma endregion
@@ -211,6 +269,53 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
 		float ThrowingWeaponReturnSpeed;
 
+	// How far the return path bows out to the camera right, as a fraction of the distance to the player (0 is a straight return)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float ReturnPathCurvature;
+
+	// How far ahead of the throwing weapon the throw trace looks for impacts
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Collision")
+		float WeaponThrowTraceDistance;
+
+	// Sweep the throwing weapon shape along its flight since the last trace instead of a fixed line trace (no tunneling at high speed)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Collision")
+		bool bUseContinuousThrowCollision;
+
+	// Grows (positive) or shrinks (negative) the swept shape of the throwing weapon
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Collision", meta = (EditCondition = "bUseContinuousThrowCollision"))
+		float ContinuousCollisionInflation;
+
+	// Longest projectile movement step while continuous collision is on, the sweep splits a longer frame into segments of this length
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Collision", meta = (EditCondition = "bUseContinuousThrowCollision", ClampMin = "0.0166", ClampMax = "0.5"))
+		float ContinuousCollisionMaxStepTime;
+
+	// Run the throw trace through the world's async trace interface, the result is used one frame later (the launch frame still traces right away)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Collision")
+		bool bUseAsyncThrowTrace;
+
+	// Let UThrowingWeaponSubsystem simulate this weapon together with every other batched weapon, the actor only shows the result
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Simulation")
+		bool bUseBatchedSimulation;
+
+	// Tick the weapon and its projectile movement after the owner's controller, so a throw from this frame's input already flies this frame (Weapon.Throw.LowLatency overrides it)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Simulation")
+		bool bUseLowLatencyThrow;
+
+	// Point damage dealt to the actor the thrown weapon lodges in (by the server), 0 deals none
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Impact", meta = (ClampMin = "0.0"))
+		float ThrowImpactDamage;
+
+	// Damage type of ThrowImpactDamage
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Impact")
+		TSubclassOf<UDamageType> ThrowImpactDamageType;
+
+	// Played where the thrown weapon lodges
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Impact")
+		USoundBase* ThrowImpactSound;
+
+	// Weapon variant (mesh and curves), loaded in the background so variants don't load with the map. Without one the curves below are used
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		TSoftObjectPtr<UThrowingWeaponArchetype> Archetype;
 	
 
 private:
@@ -221,26 +326,19 @@ private:
 
 	// Handles rotation forward 
 	UPROPERTY(EditDefaultsOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UCurveFloat* TLThrowingWeaponRotationForward_Curve;
-
-	// Throwing weapon trajectory
-	UPROPERTY(EditDefaultsOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UCurveFloat* TLWeaponThrowTrace_Curve;	
+		TSoftObjectPtr<UCurveFloat> TLThrowingWeaponRotationForward_Curve;
 
 	// How fast the throwing weapon takes to return to the player
 	UPROPERTY(EditDefaultsOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UCurveFloat* TLThrowingWeaponReturnSpeed_Curve;	
+		TSoftObjectPtr<UCurveFloat> TLThrowingWeaponReturnSpeed_Curve;	
 
 	// How much the throwing weapon should wiggle when lodged before recalling
 	UPROPERTY(EditDefaultsOnly, Category = "Timeline", meta = (AllowPrivateAccess = true))
-		UCurveFloat* TLWiggleThrowingWeapon_Curve;
+		TSoftObjectPtr<UCurveFloat> TLWiggleThrowingWeapon_Curve;
 		
 	UPROPERTY()
 		FRotator StartCameraRotation; // Initial camera rotation when weapon was thrown	
 
-	UPROPERTY()
-		FRotator InitialRotation; // Initial Throwing weapon rotation when recalling
-
 	UPROPERTY()
 		FRotator LodgePointBaseRotation; // Lodged throwing weapon rotation
 
@@ -263,16 +361,47 @@ private:
 		FVector ReturnTargetLocation; // The target to where the throwing weapon will return (i.e the player)
 
 	UPROPERTY()
-		float OptimalDistance; // Used to determine how fast the throwing weapon should return based on the speed curve (max duration)
+		float ReturnPlayRate; // How fast the return curve is played
+
+	UPROPERTY()
+		float StateTime; // Launched: spin curve time, Wiggle: wiggle curve time
 
 	UPROPERTY()
-		float DistanceFromPlayer; // How far away the player is 
+		float ReturnTime; // Return speed curve time
 
 	UPROPERTY()
-		float MaxCalculationDistanceFromPlayer; // Used to set the value for distanceFromPlayer
+		float OptimalDistance; // Distance covered while the return curve plays once at ThrowingWeaponReturnSpeed, sets the average return speed
 
 	UPROPERTY()
-		bool bIsThrowingWeaponReturnDelayFinished; // Checks based on timer for how long the throwing weapon should wiggle before recalling
+		bool bIsThrowingWeaponReturnDelayFinished; // Is the throwing weapon back at the player?
+
+	FCollisionQueryParams ThrowTraceQueryParams; // Built once so the throw trace doesn't allocate an ignore list every frame
+
+	UPROPERTY()
+		UThrowingWeaponSubsystem* ThrowingWeaponSubsystem; // Subsystem of the world the weapon is in, nullptr outside of game worlds
+
+	FThrowingWeaponFlightSample PreviousThrowTraceSample; // Swept shape at the previous throw trace
+
+	TArray<FTraceHandle, TInlineAllocator<FThrowingWeaponSimulation::MaxSweepSubsteps + 1>> AsyncThrowTraceHandles; // Async throw trace submitted last frame, one per segment in flight order
+	FThrowingWeaponFlightSample AsyncThrowTraceStart; // Where the pending async throw trace starts, traced again if its result is lost
+	uint64 AsyncThrowTraceSubmitCycles; // When the pending async throw trace was submitted
+	bool bIsAsyncThrowTraceRunning; // False on the launch frame, which traces synchronously
+	bool bIsImpactPending; // An impact is published and waits for the drain, the flight stops looking for more
+
+	FThrowingWeaponReturnPath ReturnPath; // Built at the recall, evaluated every frame of the return
+
+	TSharedPtr<const FBakedCurve> SpinCurveTable; // Baked TLThrowingWeaponRotationForward_Curve
+	TSharedPtr<const FBakedCurve> ReturnSpeedCurveTable; // Baked TLThrowingWeaponReturnSpeed_Curve
+	TSharedPtr<const FBakedCurve> WiggleCurveTable; // Baked TLWiggleThrowingWeapon_Curve
+
+	TSharedPtr<FStreamableHandle> CurvesHandle; // Keeps the weapon's own curves in memory while they are used (no archetype)
+	TSoftObjectPtr<UThrowingWeaponArchetype> RequestedArchetype; // Archetype this weapon is a user of in the archetype subsystem
+	bool bIsArchetypeReady; // Mesh and curves of the current variant are applied
+
+	TWeakObjectPtr<AActor> LowLatencyTickPrerequisite; // Controller the weapon currently ticks after, if any
+
+	int32 BatchedSimulationIndex; // Slot in the subsystem batch of BatchedSimulationState, INDEX_NONE when not batched
+	TEnumAsByte<ThrowingWeaponState> BatchedSimulationState; // Which subsystem batch the weapon is in
 	
 
 #pragma endregion
@@ -281,35 +410,10 @@ private:
 
 public:
 
-protected:
+	FOnThrowingWeaponStateChanged OnThrowingWeaponStateChanged; // Broadcast after every state change
 
-private:
-	
-	// Delegate for throwing weapon rotation timeline
-	FOnTimelineFloat ThrowingWeaponRotationForwardInterpFunction{}; // Update
-	FOnTimelineEvent ThrowingWeaponRotationForwardTimelineFinished; // Finished
-
-	// Delegate for throwing weapon throw timeline
-	FOnTimelineFloat WeaponThrowTraceInterpFunction{}; // Update
-	FOnTimelineEvent WeaponThrowTraceTimelineFinished; // Finished
-
-	// Delegate for throwing weapon return timeline
-	FOnTimelineFloat ThrowingWeaponReturnInterpFunction{}; // Update
-	FOnTimelineFloat ThrowingWeaponReturnSpeedValue{}; // Update
-	FOnTimelineFloat ThrowingWeaponReturnRotTwoValue{}; // Update
-	FOnTimelineFloat ThrowingWeaponReturnVectorValue{}; // Update
-	FOnTimelineEvent ThrowingWeaponReturnTickEvent; // Update
-	FOnTimelineEvent ThrowingWeaponReturnFinished; // Finished
-
-	// Timer delegate for lodged throwing weapon wiggle
-	FTimerHandle ThrowingWeaponWiggleTimerDelay;
-	FTimerHandle ThrowingWeaponReturnDelay;
-
-	// Delegate for lodged axe wiggle timeline
-	FOnTimelineFloat WiggleLodgedThrowingWeaponInterpFunction{}; // Update
-	FOnTimelineEvent WiggleLodgedThrowingWeaponTimelineFinished; // Update
+	FOnThrowingWeaponImpact OnThrowingWeaponImpact; // Broadcast when the thrown weapon lodges, after the damage is dealt
 
 #pragma endregion
 
-
 };
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CollisionQueryParams.h"
+#include "ThrowingWeaponBase.h"
+#include "ThrowingWeaponComponent.generated.h"
+
+class UStaticMeshComponent;
+class UThrowingWeaponArchetype;
+class UThrowingWeaponComponent;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnThrowingWeaponComponentStateChanged, UThrowingWeaponComponent*, ThrowingWeaponState);
+
+/// <summary>
+/// The throw, lodge, wiggle and return of AThrowingWeaponBase as a component any pawn can host, for NPC crowds. The weapon
+/// is one static mesh proxy attached to the host's grip socket that switches to an absolute transform while it is away,
+/// so a throw and a catch never detach or reattach anything and no weapon actor is spawned
+/// </summary>
+UCLASS(ClassGroup = (Weapon), meta = (BlueprintSpawnableComponent))
+class WEAPON_API UThrowingWeaponComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UThrowingWeaponComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+#pragma region FUNCTIONS
+
+public:
+
+	UFUNCTION(BlueprintCallable)
+		void SetGrip(USceneComponent* gripComponent, FName gripSocketName); // Where the weapon is held and returns to
+
+	UFUNCTION(BlueprintCallable)
+		void ThrowWeapon(FVector throwDirection, FVector viewLocation, FRotator viewRotation); // Launch from in front of the view along throwDirection
+
+	UFUNCTION(BlueprintCallable)
+		void RecallThrowingWeapon(); // Return to the grip, a lodged weapon wiggles loose first
+
+	UFUNCTION(BlueprintPure)
+		ThrowingWeaponState GetThrowingWeaponState() const { return CurrentThrowingWeaponState; }
+
+	UStaticMeshComponent* GetProxyMesh() const { return ProxyMeshComponent; }
+
+private:
+
+	void UpdateLaunched(float deltaTime); // Integrate the flight, spin and sweep for an impact
+
+	void UpdateWiggle(float deltaTime); // Wiggle loose while the return already starts
+
+	bool AdvanceReturn(float deltaTime, float wiggleValue); // Move along the return path (tilted by the wiggle curve value), true once the weapon arrived
+
+	void Lodge(const FHitResult& hitResult);
+
+	void BuildReturnPath(); // Path from where the weapon is to the grip, built once per recall
+
+	void Catch(); // Back at the grip, the proxy follows the socket again
+
+	void SetThrowingWeaponState(ThrowingWeaponState newState);
+
+	void SetProxyPose(const FVector& location, const FRotator& rotation);
+
+	FTransform GetGripTransform() const;
+
+	FThrowingWeaponFlightSample MakeTraceSample() const; // Where the proxy's swept shape is now, the next sweep starts from it
+
+	FVector GetViewRightVector() const; // Right vector of the host's view, the return bows out towards it
+
+	void ApplyArchetype(UThrowingWeaponArchetype* archetype); // Mesh and curve tables of the loaded variant
+
+#pragma endregion
+
+#pragma region VARIABLES
+
+public:
+
+	// Weapon variant (mesh and curves), loaded in the background through UThrowingWeaponArchetypeSubsystem
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		TSoftObjectPtr<UThrowingWeaponArchetype> Archetype;
+
+	// Socket of the host's mesh the weapon is held at (used when SetGrip isn't called)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		FName GripSocketName;
+
+	// How fast the throwing weapon spins while thrown
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		float ThrowingWeaponSpinRate;
+
+	// Rotation multiplier for spin
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		float ThrowingWeaponRotationMultiplier;
+
+	// Speed for throwing weapon
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		float WeaponThrowSpeed;
+
+	// How far ahead of the view the weapon will start its course
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		float WeaponThrowDirectionMultiplier;
+
+	// Gravity applied to the flight, as a multiple of the world gravity
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		float GravityScale;
+
+	// How fast the throwing weapon should return
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon")
+		float ThrowingWeaponReturnSpeed;
+
+	// How far the return path bows out to the view right, as a fraction of the distance to the grip (0 is a straight return)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float ReturnPathCurvature;
+
+	// How far ahead of the weapon the flight sweep looks for impacts
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Throwing Weapon|Collision")
+		float WeaponThrowTraceDistance;
+
+	FOnThrowingWeaponComponentStateChanged OnThrowingWeaponStateChanged; // Called on every state change
+
+private:
+
+	UPROPERTY()
+		UStaticMeshComponent* ProxyMeshComponent; // The only scene component the weapon adds to its host
+
+	UPROPERTY()
+		USceneComponent* GripComponent; // What the weapon is held by
+
+	TEnumAsByte<ThrowingWeaponState> CurrentThrowingWeaponState;
+
+	FVector Location; // Weapon location while it is away from the grip
+	FVector Velocity; // Flight velocity while launched
+	FRotator ThrowRotation; // View rotation at the throw, the weapon lodges facing its yaw
+	FRotator LodgeRotation; // World rotation while lodged
+	FThrowingWeaponFlightSample PreviousTraceSample; // Proxy's swept shape at the previous impact sweep
+	float GravityZ;
+
+	float StateTime; // Launched: spin curve time, Wiggle: wiggle curve time
+	float ReturnTime; // Return curve time
+	float ReturnPlayRate; // Return curve play rate that arrives at the grip when the curve ends
+	FThrowingWeaponReturnPath ReturnPath; // Built at the recall
+
+	TSharedPtr<const FBakedCurve> SpinCurveTable;
+	TSharedPtr<const FBakedCurve> ReturnSpeedCurveTable;
+	TSharedPtr<const FBakedCurve> WiggleCurveTable;
+
+	FCollisionQueryParams ThrowTraceQueryParams; // Ignores the host
+
+#pragma endregion
+};
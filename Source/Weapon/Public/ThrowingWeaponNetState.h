@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ThrowingWeaponBase.h"
+#include "ThrowingWeaponNetState.generated.h"
+
+/// <summary>
+/// Replicated throwing weapon state. Sent quantized through NetSerialize instead of as full FVector/FRotator properties:
+/// Launched carries the launch (origin, direction, camera rotation), Lodged where the server lodged the weapon
+/// </summary>
+USTRUCT()
+struct WEAPON_API FThrowingWeaponNetState
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY()
+		uint8 State = ThrowingWeaponState::Idle; // ThrowingWeaponState
+
+	UPROPERTY()
+		uint8 Sequence = 0; // Counts throws, so a client can tell its own predicted throw from a new one
+
+	UPROPERTY()
+		FVector Location = FVector::ZeroVector; // Launched: throw origin (camera location), Lodged: weapon location (0.1 cm precision)
+
+	UPROPERTY()
+		FVector Direction = FVector::ZeroVector; // Launched: throw direction (unit vector, 16 bits per axis)
+
+	UPROPERTY()
+		FRotator Rotation = FRotator::ZeroRotator; // Launched: camera rotation, Lodged: lodge point rotation (16 bits per axis)
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	ThrowingWeaponState GetState() const { return static_cast<ThrowingWeaponState>(State); }
+
+#if !UE_BUILD_SHIPPING
+	static void RecordSent(const FThrowingWeaponNetState& netState, bool bIsRpc); // Count the payload of a sent state for Weapon.Net.Stats
+	static void RecordSentRecall(); // Count a recall request, which only carries the throw sequence
+	static void RecordThrow(); // A throw started on the server
+#endif
+};
+
+template<>
+struct TStructOpsTypeTraits<FThrowingWeaponNetState> : public TStructOpsTypeTraitsBase2<FThrowingWeaponNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
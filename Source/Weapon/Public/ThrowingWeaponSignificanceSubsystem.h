@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ThrowingWeaponSignificanceSubsystem.generated.h"
+
+/// <summary>
+/// How often a registered actor ticks, from most to least significant
+/// </summary>
+enum class EThrowingWeaponSignificance : uint8
+{
+	Full, // Every frame
+	Reduced, // Weapon.Significance.ReducedTickInterval, off-screen only
+	Far, // Weapon.Significance.FarTickInterval, off-screen only
+	EventOnly, // Nothing ticks until a state change wakes the actor up at full rate
+};
+
+/// <summary>
+/// Significance manager for throwing weapons and the characters that throw them. Every Weapon.Significance.UpdateInterval
+/// it scores each registered actor by its state, whether it was rendered recently and distance to the nearest viewer, and
+/// gives it the matching tick interval. Actors rendered recently tick every frame, only off-screen ones are slowed down.
+/// An actor that comes on screen keeps its lower rate until the next update, at most UpdateInterval later.
+/// Upgrades apply at once, downgrades go one level per update past a hysteresis band
+/// </summary>
+UCLASS()
+class WEAPON_API UThrowingWeaponSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+#pragma region FUNCTIONS
+
+public:
+
+	void RegisterActor(AActor* actor); // Start managing the tick rate of a throwing weapon or character
+
+	void UnregisterActor(AActor* actor); // Stop managing the actor and give it back its full tick rate
+
+	void RefreshActor(AActor* actor); // Score the actor again right away, called on state changes so they never wait for the next update
+
+	EThrowingWeaponSignificance GetSignificance(const AActor* actor) const; // Full for actors that aren't registered
+
+	int32 GetNumActors(EThrowingWeaponSignificance significance) const; // How many registered actors are at a significance
+
+private:
+
+	void GatherViewLocations(); // Local viewpoints, or every player's pawn on a server without local players
+
+	EThrowingWeaponSignificance CalculateSignificance(const AActor* actor, EThrowingWeaponSignificance currentSignificance) const; // Significance the actor should have now
+
+	EThrowingWeaponSignificance CalculateStateSignificance(const AActor* actor) const; // Full or EventOnly when the state alone decides, Reduced when distance and visibility decide
+
+	void ApplySignificance(AActor* actor, EThrowingWeaponSignificance significance); // Set the tick interval of the actor and, for throwing weapons, their projectile movement
+
+	static float GetTickInterval(EThrowingWeaponSignificance significance);
+
+#pragma endregion
+
+#pragma region VARIABLES
+
+private:
+
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		EThrowingWeaponSignificance Significance = EThrowingWeaponSignificance::Full;
+	};
+
+	TArray<FEntry> Entries;
+
+	TArray<FVector> ViewLocations; // Gathered once per update
+
+	float TimeUntilUpdate = 0;
+
+	bool bWasEnabled = true; // Weapon.Significance.Enabled at the last update, turning it off gives every actor its full rate back
+
+#pragma endregion
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// <summary>
+/// Where a lodging throwing weapon is and where it hit
+/// </summary>
+struct FThrowingWeaponImpact
+{
+	FVector ImpactNormal = FVector::ZeroVector; // Surface normal at the impact
+	FVector ImpactLocation = FVector::ZeroVector; // Impact point
+	FVector ActorLocation = FVector::ZeroVector; // Throwing weapon actor location
+	FVector LodgePointLocation = FVector::ZeroVector; // World location of the lodge point the mesh hangs from
+};
+
+/// <summary>
+/// Where a returning throwing weapon comes from and goes to
+/// </summary>
+struct FThrowingWeaponReturn
+{
+	FVector InitialLocation = FVector::ZeroVector; // Where the return started
+	FVector GripPointLocation = FVector::ZeroVector; // Player's WeaponGripPoint
+	FRotator GripPointRotation = FRotator::ZeroRotator; // Player's WeaponGripPoint
+	FVector CameraRightVector = FVector::ZeroVector; // Right vector of the player's camera
+};
+
+/// <summary>
+/// Curved return path built once at the recall: a quadratic Bezier from where the return started to the player, bowed
+/// towards the camera right. The player moving afterwards only shifts the end, so nothing is rebuilt per frame
+/// </summary>
+struct FThrowingWeaponReturnPath
+{
+	FVector Start = FVector::ZeroVector; // Where the return started
+	FVector Control = FVector::ZeroVector; // Bezier control point, pulls the path sideways
+	FVector End = FVector::ZeroVector; // Target at the recall
+	FVector EndOffset = FVector::ZeroVector; // Target relative to the grip point, kept while the player moves
+	float Length = 0; // Arc length of the path at the recall
+	float Duration = 0; // Seconds from the recall to the arrival
+};
+
+/// <summary>
+/// Where a returning throwing weapon is this frame
+/// </summary>
+struct FThrowingWeaponReturnPose
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+};
+
+/// <summary>
+/// Where and how fast a launched throwing weapon was at a throw trace, the next swept trace starts from it
+/// </summary>
+struct FThrowingWeaponFlightSample
+{
+	FVector Location = FVector::ZeroVector; // Center of the swept shape
+	FVector Velocity = FVector::ZeroVector; // Flight velocity
+	double Time = 0; // World time in seconds
+};
+
+/// <summary>
+/// Points of a swept throw trace, the flight since the last trace in substeps followed by the look-ahead
+/// </summary>
+typedef TArray<FVector, TInlineAllocator<10>> FThrowingWeaponSweepPath;
+
+/// <summary>
+/// Flight, lodge, wiggle and return math of the throwing weapons on plain values, shared by AThrowingWeaponBase, UThrowingWeaponComponent
+/// and UThrowingWeaponSubsystem. Needs nothing but Core (no actors, components or world) and never allocates
+/// </summary>
+struct WEAPON_API FThrowingWeaponSimulation
+{
+	static constexpr float WigglePlayRate = 3; // Play rate of the wiggle curve, the same as the old wiggle timeline
+
+	static constexpr float WigglePitch = -30; // Lodge pitch added at a wiggle curve value of 1
+
+	static constexpr float ReturnOptimalDistance = 1400; // Distance covered while the return curve plays once at a return speed of 1
+
+	static constexpr float DefaultMaxSweepStepTime = 0.05f; // Flight time per segment of a swept throw trace unless the weapon sets its own
+
+	static void AdvanceFlight(FVector& location, FVector& velocity, float gravityZ, float maxSpeed, float deltaTime); // Midpoint projectile step, maxSpeed 0 means no limit
+
+	static float AdvanceSpin(float spinTime, float deltaTime, float spinRate, float curveEndTime); // Spin curve time, held at the end of the curve
+
+	static FRotator CalculateWiggleRotation(const FRotator& baseRotation, float wiggleValue); // Rotation tilted by the wiggle curve value
+
+	static float CalculateLodgePitch(const FVector& velocity, const FVector& impactNormal); // Flight pitch plus a random tilt for the surface
+
+	static FRotator MakeRotationFromAxes(FVector forward, FVector right, FVector up); // Rotation of a matrix built from the (normalized) axes
+
+	static FVector AdjustImpactLocation(const FThrowingWeaponImpact& impact); // Actor location that puts the lodged mesh at the impact
+
+	static float AdjustImpactPitch(const FVector& impactNormal, float inclinedSurfaceRange, float regularSurfaceRange); // Pitch added to the lodge rotation for the surface
+
+	static constexpr int32 MaxSweepSubsteps = 8; // Most substeps a swept throw trace splits the flight into, a long hitch sweeps coarser steps
+
+	static void BuildSweepPath(const FThrowingWeaponFlightSample& from, const FThrowingWeaponFlightSample& to, float maxStepTime, float lookAheadDistance, FThrowingWeaponSweepPath& outPath); // Flight between two traces split at maxStepTime, then lookAheadDistance along the velocity
+
+	static FThrowingWeaponReturnPath BuildReturnPath(const FThrowingWeaponReturn& weaponReturn, float curvature, float averageSpeed); // Path and arrival time of a recall
+
+	static float CalculateReturnAverageSpeed(float returnSpeed, float curveEndTime); // ReturnOptimalDistance per play of the return curve at returnSpeed
+
+	static float CalculateQuadraticBezierLength(const FVector& start, const FVector& control, const FVector& end); // Exact arc length
+
+	static float CalculateReturnDuration(float pathLength, float averageSpeed); // Seconds to travel the path at averageSpeed
+
+	static float CalculateReturnPlayRate(float returnDuration, float curveEndTime); // Play rate that finishes the return curve when the weapon arrives
+
+	static float GetReturnCurveEndTime(float curveEndTime); // Time the return curve is played to, one second for a curve without duration
+
+	static float CalculateReturnAlpha(float curveValue, float returnTime, float curveEndTime); // Progress along the return path, linear in time for a curve without duration
+
+	static bool IsReturnFinished(float returnTime, float curveEndTime); // Has the return curve played to its (guarded) end?
+
+	static FThrowingWeaponReturnPose CalculateReturnPose(const FThrowingWeaponReturnPath& path, const FVector& gripPointLocation, const FRotator& gripPointRotation, float returnAlpha); // Pose at returnAlpha (0 start, 1 at the player)
+};
@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Containers/Queue.h"
+#include "ThrowingWeaponBase.h"
+#include <atomic>
+#include "ThrowingWeaponSubsystem.generated.h"
+
+struct FBakedCurve;
+class UThrowingWeaponSubsystem;
+class ACharacter;
+
+/// <summary>
+/// Values that stay the same while a throwing weapon sits in one batch (read rarely, so kept together per weapon)
+/// </summary>
+struct FThrowingWeaponBatchParams
+{
+	const FBakedCurve* SpinCurve = nullptr; // Forward rotation while launched (owned by the weapon)
+	const FBakedCurve* ReturnSpeedCurve = nullptr; // Return progress while recalled (owned by the weapon)
+	const FBakedCurve* WiggleCurve = nullptr; // Wiggle while pulled out of a surface (owned by the weapon)
+	float SpinRate = 1; // Play rate of the spin curve
+	float SpinMultiplier = 1; // Spin curve value to pitch degrees
+	float GravityZ = 0; // Gravity applied to the flight
+	float MaxSpeed = 0; // Flight speed limit, 0 means no limit
+	float ReturnPlayRate = 1; // Play rate of the return curve
+	FRotator LodgePointBaseRotation = FRotator::ZeroRotator; // Lodge point rotation the wiggle is added to
+	TWeakObjectPtr<ACharacter> SimulationOwner; // Character whose movement and pose the simulation tick waits for because of this weapon, if any
+};
+
+/// <summary>
+/// A throwing weapon flight trace waiting to be submitted to the world's async trace interface
+/// </summary>
+struct FThrowingWeaponFlightTrace
+{
+	TWeakObjectPtr<AThrowingWeaponBase> Weapon; // Weapon that reads the result next frame
+	FThrowingWeaponSweepPath Path; // Traced segment by segment, two points for a line trace
+	FQuat Rotation = FQuat::Identity; // Rotation of the swept shape
+	FCollisionShape Shape; // Swept shape, unused by line traces
+	bool bSwept = false; // Shape sweep or line trace?
+};
+
+/// <summary>
+/// A throwing weapon impact waiting for the once per frame drain, published from any thread
+/// </summary>
+struct FThrowingWeaponImpactEvent
+{
+	TWeakObjectPtr<AThrowingWeaponBase> Weapon; // Only resolved on the game thread
+	FHitResult HitResult;
+	FVector Velocity = FVector::ZeroVector; // Flight velocity at the impact
+	uint64 PublishCycles = 0; // When it was published, for the latency stat
+};
+
+/// <summary>
+/// Struct of arrays holding every throwing weapon in one ThrowingWeaponState. Index i of every array belongs to Weapons[i]
+/// </summary>
+USTRUCT()
+struct WEAPON_API FThrowingWeaponBatch
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY()
+		TArray<TObjectPtr<AThrowingWeaponBase>> Weapons; // The weapon actors showing the result
+
+	TArray<FVector> Locations; // Launched: current location, Wiggle/Returning: where the return started
+	TArray<FVector> Velocities; // Launched: current velocity
+	TArray<float> StateTimes; // Launched: spin curve time, Wiggle: wiggle curve time
+	TArray<float> ReturnTimes; // Wiggle/Returning: return curve time
+	TArray<FThrowingWeaponBatchParams> Params; // Per weapon constants
+
+	int32 Add(AThrowingWeaponBase* weapon); // Append a weapon, filling every array from its current state
+	void RemoveAtSwap(int32 index); // Remove a weapon, the last weapon moves into its slot
+	int32 Num() const { return Weapons.Num(); }
+};
+
+/// <summary>
+/// Runs the batched simulation in the world's tick, after the movement and the mesh pose of every character that owns a
+/// batched weapon (prerequisites added as the weapons join), so returning weapons follow this frame's grip point
+/// </summary>
+USTRUCT()
+struct FThrowingWeaponSimulationTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UThrowingWeaponSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FThrowingWeaponSimulationTickFunction> : public TStructOpsTypeTraitsBase2<FThrowingWeaponSimulationTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+UCLASS()
+class WEAPON_API UThrowingWeaponSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+#pragma region FUNCTIONS
+
+public:
+
+	void SetWeaponState(AThrowingWeaponBase* weapon, ThrowingWeaponState newState); // Move a batched weapon to the batch of its new state (Idle removes it)
+
+	void RemoveWeapon(AThrowingWeaponBase* weapon); // Stop simulating a weapon
+
+	void RefreshWeaponCurves(AThrowingWeaponBase* weapon); // Point the batch at the weapon's current curve tables after a variant swap
+
+	int32 GetNumWeapons(ThrowingWeaponState state) const; // How many weapons are in the batch of a state
+
+	void QueueFlightTrace(const FThrowingWeaponFlightTrace& trace); // Submitted with every other queued trace at the end of this frame's tick
+
+	void RecordSyncFlightTrace(uint64 cycles); // Cost of a game thread flight trace, the baseline for the time saved stat
+
+	void RecordAsyncFlightTrace(uint64 consumeCycles, double latencySeconds, bool bIsFallback); // Result of an async flight trace was used (or lost and traced again)
+
+	void PublishImpact(AThrowingWeaponBase* weapon, const FHitResult& hitResult, const FVector& velocity); // Thread safe, lodged by this frame's DrainImpacts (the next one when published after it)
+
+	double GetLastSimulationMilliseconds() const { return LastSimulationMilliseconds; } // Game thread time of the last batched simulation tick, workers included
+
+	int32 GetImpactQueueDepth() const { return ImpactQueueDepth.load(std::memory_order_relaxed); } // Impacts published and not drained yet
+
+private:
+
+	friend struct FThrowingWeaponSimulationTickFunction;
+
+	void TickSimulation(float deltaTime); // Advance every batch, run by SimulationTickFunction
+
+	void AddSimulationPrerequisite(AThrowingWeaponBase* weapon, FThrowingWeaponBatchParams& params); // Keep the simulation after the movement and pose of the weapon's owner
+
+	void RemoveSimulationPrerequisite(const FThrowingWeaponBatchParams& params); // Stop waiting for the owner once no simulated weapon needs it
+
+	void AdvanceLaunched(float deltaTime); // Integrate flight, spin and impact traces of every launched weapon
+
+	void AdvanceWiggle(float deltaTime); // Wiggle every weapon being pulled out of a surface while it starts returning, collecting FinishedWiggles
+
+	void AdvanceReturning(float deltaTime); // Move every returning weapon towards its owner
+
+	void DrainImpacts(); // Lodge, damage and effects of every impact published since the last drain, one pass each
+
+	void SubmitFlightTraces(); // Submit every queued flight trace in one batch
+
+	void ReportFlightTraceStats(); // Publish this frame's async trace stats and start counting the next frame
+
+	FThrowingWeaponBatch* GetBatch(ThrowingWeaponState state); // The batch of a state, nullptr for Idle
+
+	const FThrowingWeaponBatch* GetBatch(ThrowingWeaponState state) const;
+
+#pragma endregion
+
+#pragma region VARIABLES
+
+private:
+
+	UPROPERTY()
+		FThrowingWeaponBatch LaunchedBatch;
+
+	UPROPERTY()
+		FThrowingWeaponBatch LodgedBatch;
+
+	UPROPERTY()
+		FThrowingWeaponBatch WiggleBatch;
+
+	UPROPERTY()
+		FThrowingWeaponBatch ReturningBatch;
+
+	TQueue<FThrowingWeaponImpactEvent, EQueueMode::Mpsc> ImpactQueue; // Lock-free, any thread publishes and the game thread drains once per frame
+	std::atomic<int32> ImpactQueueDepth{ 0 }; // Published and not drained yet
+	TArray<FThrowingWeaponImpactEvent> DrainedImpacts; // Scratch of the drain, impacts of weapons still in flight
+	TArray<AThrowingWeaponBase*> PendingStateChanges; // Weapons whose timed state ended while advancing
+	TArray<AThrowingWeaponBase*> FinishedWiggles; // Weapons done wiggling this tick, moved to the returning batch after it advanced
+	TArray<float> CurveValues; // Scratch for batched curve evaluation
+	TArray<float> ReturnCurveValues; // Scratch for batched return curve evaluation
+	TArray<FThrowingWeaponReturnPose> ReturnPoses; // Scratch for the return poses worked out on the workers
+
+	FThrowingWeaponSimulationTickFunction SimulationTickFunction;
+	TMap<TWeakObjectPtr<ACharacter>, int32> SimulationPrerequisiteCounts; // Batched weapons per owner the simulation tick waits for
+	double LastSimulationMilliseconds = 0;
+
+	TArray<FThrowingWeaponFlightTrace> QueuedFlightTraces; // Flight traces to submit at the end of this tick
+
+	double AverageSyncFlightTraceCycles = 0; // Running average cost of a game thread flight trace
+	uint64 FrameAsyncFlightTraceCycles = 0; // Game thread cost of submitting and reading async traces this frame
+	int32 FrameAsyncFlightTraces = 0; // Async results used this frame
+	int32 FrameAsyncFlightTraceFallbacks = 0; // Async results lost this frame and traced again synchronously
+	double FrameMaxAsyncFlightTraceLatency = 0; // Longest submit to use time this frame, in seconds
+
+#if !UE_BUILD_SHIPPING
+	friend struct FThrowingWeaponBatchBenchmark;
+	TSharedPtr<struct FThrowingWeaponBatchBenchmark> Benchmark; // Running Weapon.Batch.Benchmark, if any
+#endif
+
+#pragma endregion
+
+};
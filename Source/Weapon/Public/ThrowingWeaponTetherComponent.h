@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/MeshComponent.h"
+#include "ThrowingWeaponBase.h"
+#include "TetherSolver.h"
+#include "ThrowingWeaponTetherComponent.generated.h"
+
+/// <summary>
+/// Rope between the player and the throwing weapon, simulated by FTetherSolver. It sleeps (no tick, hidden) while the weapon is
+/// Idle, and picks its segment and iteration count from the camera distance and the weapon state
+/// </summary>
+UCLASS(ClassGroup = (Rendering), meta = (BlueprintSpawnableComponent))
+class WEAPON_API UThrowingWeaponTetherComponent : public UMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UThrowingWeaponTetherComponent();
+
+	virtual void OnRegister() override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void CreateRenderState_Concurrent(FRegisterComponentContext* Context) override;
+
+	virtual void SendRenderDynamicData_Concurrent() override;
+
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+
+	virtual int32 GetNumMaterials() const override { return 1; }
+
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+#pragma region FUNCTIONS
+
+public:
+
+	UFUNCTION(BlueprintCallable, Category = "Tether")
+		void SetTetherEnd(USceneComponent* endComponent, FName endSocketName); // Attach the end of the tether to a component socket
+
+	UFUNCTION(BlueprintCallable, Category = "Tether")
+		void SetThrowingWeaponState(ThrowingWeaponState state); // Sleep while Idle, otherwise wake up and pick the iterations for the state
+
+	UFUNCTION(BlueprintPure, Category = "Tether")
+		bool IsSleeping() const { return bIsSleeping; }
+
+	int32 GetNumSegments() const { return Solver.GetNumSegments(); }
+	int32 GetNumIterations() const { return NumIterations; }
+
+private:
+
+	void UpdateLOD(); // Segments from the camera distance, iterations from the state and the camera distance
+
+	FVector GetTetherEndLocation() const;
+
+#pragma endregion
+
+#pragma region VARIABLES
+
+public:
+
+	// Rest length of the whole tether
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether", meta = (ClampMin = "0.0"))
+		float TetherLength;
+
+	// Width of the rendered tether
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether Rendering", meta = (ClampMin = "0.01"))
+		float Width;
+
+	// Sides of the rendered tether
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether Rendering", meta = (ClampMin = "1", ClampMax = "16"))
+		int32 NumSides;
+
+	// How many times the material repeats along the tether
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether Rendering")
+		float TileMaterial;
+
+	// Scale of the world gravity on the tether
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether")
+		float GravityScale;
+
+	// Velocity kept from one step to the next
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float Damping;
+
+	// Segments when the camera is at LODNearDistance or closer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether LOD", meta = (ClampMin = "1", ClampMax = "64"))
+		int32 MaxSegments;
+
+	// Segments when the camera is at LODFarDistance or further
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether LOD", meta = (ClampMin = "1", ClampMax = "64"))
+		int32 MinSegments;
+
+	// Constraint iterations while the weapon moves (Launched, Wiggle, Returning) close to the camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether LOD", meta = (ClampMin = "1", ClampMax = "32"))
+		int32 MaxIterations;
+
+	// Constraint iterations while the weapon is Lodged, and for every state far from the camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether LOD", meta = (ClampMin = "1", ClampMax = "32"))
+		int32 MinIterations;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether LOD")
+		float LODNearDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tether LOD")
+		float LODFarDistance;
+
+private:
+
+	UPROPERTY()
+		TWeakObjectPtr<USceneComponent> TetherEndComponent;
+
+	FTransform TetherEndSocketTransform; // Socket relative to TetherEndComponent, looked up once
+
+	FTetherSolver Solver;
+
+	TEnumAsByte<ThrowingWeaponState> WeaponState;
+
+	int32 NumIterations;
+
+	bool bIsSleeping;
+
+#pragma endregion
+
+};
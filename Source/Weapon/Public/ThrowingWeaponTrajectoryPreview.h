@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AThrowingWeaponBase;
+
+/// <summary>
+/// Predicted flight arc and lodge point of a throw, updated incrementally while aiming. Small aim changes reuse the previous
+/// samples, the samples themselves are computed four at a time in closed form, and the collision sweep along the arc is
+/// spread over frames with at most MaxTracesPerFrame line traces per frame
+/// </summary>
+struct WEAPON_API FThrowingWeaponTrajectoryPreview
+{
+public:
+
+	bool Update(const AThrowingWeaponBase& weapon, const FVector& throwDirection, const FVector& cameraLocation); // Step the preview, true when the visible arc changed
+
+	void Reset(); // Forget the arc, the next update starts over
+
+	int32 GetNumVisiblePoints() const; // Samples up to the lodge point, plus the lodge point itself
+	FVector GetVisiblePoint(int32 index) const;
+
+	bool HasLodgePoint() const { return HitSegment != INDEX_NONE; }
+	const FVector& GetLodgePoint() const { return LodgePoint; }
+	const FVector& GetLodgeNormal() const { return LodgeNormal; }
+
+	int32 GetNumTracesLastUpdate() const { return NumTracesLastUpdate; }
+
+	int32 NumSamples = 32; // Samples along the arc (rounded up to a multiple of four)
+	float SampleInterval = 0.08f; // Flight seconds between samples
+	int32 MaxTracesPerFrame = 6; // Collision queries per update
+	float ReuseLocationTolerance = 8; // Start location change that still reuses the samples
+	float ReuseAngleToleranceDegrees = 0.75f; // Aim change that still reuses the samples
+
+private:
+
+	void BuildSamples(); // Closed form positions of every sample
+
+	FVector GetSample(int32 index) const { return Origin + FVector(X[index], Y[index], Z[index]); }
+
+	FVector Origin = FVector::ZeroVector; // Launch location the samples were built for
+	FVector Velocity = FVector::ZeroVector; // Launch velocity the samples were built for
+	float GravityZ = 0;
+
+	TArray<float> X, Y, Z; // Sample positions relative to Origin
+
+	int32 TraceCursor = 0; // Next segment of the running collision sweep
+	int32 HitSegment = INDEX_NONE; // Segment the arc ends on, INDEX_NONE when it hits nothing
+	FVector LodgePoint = FVector::ZeroVector;
+	FVector LodgeNormal = FVector::ZeroVector;
+
+	int32 NumTracesLastUpdate = 0;
+	bool bHasSamples = false;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+/// <summary>
+/// Stats of the Weapon module, shown with "stat Weapon". The same scopes go to Unreal Insights on the Weapon trace
+/// channel ("Trace.Enable Weapon" or -trace=cpu,Weapon). Both are switched at runtime and compile out in Shipping
+/// </summary>
+DECLARE_STATS_GROUP(TEXT("Weapon"), STATGROUP_Weapon, STATCAT_Advanced);
+
+#define WITH_WEAPON_PROFILING !UE_BUILD_SHIPPING
+
+#if WITH_WEAPON_PROFILING
+
+UE_TRACE_CHANNEL_EXTERN(WeaponChannel, WEAPON_API);
+
+// Cycle stat and Insights CPU scope under the stat's name
+#define WEAPON_PROFILE_SCOPE(Stat) SCOPE_CYCLE_COUNTER(Stat); TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, WeaponChannel)
+
+#else
+
+#define WEAPON_PROFILE_SCOPE(Stat)
+
+#endif
+
+// State machine
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw weapon"), STAT_WeaponThrow, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Recall weapon"), STAT_WeaponRecall, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update launched"), STAT_WeaponUpdateLaunched, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update wiggle"), STAT_WeaponUpdateWiggle, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update returning"), STAT_WeaponUpdateReturning, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Return pose"), STAT_WeaponReturnPose, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact and lodge"), STAT_WeaponImpact, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched simulation"), STAT_WeaponBatchedSimulation, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active weapons"), STAT_WeaponActive, STATGROUP_Weapon, WEAPON_API);
+
+// Throw traces
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw trace (sync)"), STAT_ThrowTraceSync, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw trace submit (async)"), STAT_ThrowTraceAsyncSubmit, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw trace consume (async)"), STAT_ThrowTraceAsyncConsume, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async throw traces"), STAT_ThrowTraceAsyncCount, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async throw trace sync fallbacks"), STAT_ThrowTraceAsyncFallbacks, STATGROUP_Weapon, WEAPON_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Async throw trace max latency (ms)"), STAT_ThrowTraceAsyncLatency, STATGROUP_Weapon, WEAPON_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Async throw trace GT time saved (ms)"), STAT_ThrowTraceTimeSaved, STATGROUP_Weapon, WEAPON_API);
+
+// Tether
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tether simulate"), STAT_TetherSimulate, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Tether particles"), STAT_TetherParticles, STATGROUP_Weapon, WEAPON_API);
+
+// Trajectory preview
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw preview"), STAT_ThrowPreview, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Throw preview traces"), STAT_ThrowPreviewTraces, STATGROUP_Weapon, WEAPON_API);
+
+// Throw targets
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throw target query"), STAT_ThrowTargetQuery, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Throw target cells visited"), STAT_ThrowTargetCellsVisited, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Throw target candidates tested"), STAT_ThrowTargetCandidates, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Throw targets"), STAT_ThrowTargets, STATGROUP_Weapon, WEAPON_API);
+
+// Throwing weapon component
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Throwing weapon component"), STAT_WeaponComponent, STATGROUP_Weapon, WEAPON_API);
+
+// Significance
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Significance"), STAT_WeaponSignificance, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Significance full rate"), STAT_WeaponSignificanceFull, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Significance reduced rate"), STAT_WeaponSignificanceReduced, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Significance far rate"), STAT_WeaponSignificanceFar, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Significance event only"), STAT_WeaponSignificanceEventOnly, STATGROUP_Weapon, WEAPON_API);
+
+// Ballistics
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ballistic throw solve"), STAT_WeaponBallistics, STATGROUP_Weapon, WEAPON_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ballistic batch solve"), STAT_WeaponBallisticBatch, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ballistic batch pairs"), STAT_WeaponBallisticSolves, STATGROUP_Weapon, WEAPON_API);
+
+// Impact queue
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact drain"), STAT_WeaponImpactDrain, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impact queue depth"), STAT_WeaponImpactQueueDepth, STATGROUP_Weapon, WEAPON_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impacts drained"), STAT_WeaponImpactsDrained, STATGROUP_Weapon, WEAPON_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Impact max queue latency (ms)"), STAT_WeaponImpactLatency, STATGROUP_Weapon, WEAPON_API);
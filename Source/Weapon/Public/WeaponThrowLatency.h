@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// <summary>
+/// Development only record of how long a throw takes from the input to the screen. Compiles out completely in Shipping
+/// </summary>
+#define WITH_WEAPON_THROW_LATENCY !UE_BUILD_SHIPPING
+
+#if WITH_WEAPON_THROW_LATENCY
+
+class AActor;
+
+// One throw, every time is in FPlatformTime cycles and every frame a GFrameCounter value
+struct FWeaponThrowLatencySample
+{
+	uint64 InputCycles = 0; // The launch input was processed
+	uint64 ThrowCycles = 0; // ThrowWeapon was called
+	uint64 MovedCycles = 0; // End of the first frame the weapon had left its launch position
+	uint64 RenderedCycles = 0; // The render thread reached the scene of that frame
+	uint64 InputFrame = 0;
+	uint64 ThrowFrame = 0;
+	uint64 MovedFrame = 0;
+};
+
+class WEAPON_API FWeaponThrowLatency
+{
+public:
+
+	// How many throws are remembered
+	static constexpr int32 Capacity = 512;
+
+	static FWeaponThrowLatency& Get(); // The one latency record shared by every player
+
+	void RecordInput(); // The launch input of the local player was processed
+
+	void RecordThrow(const AActor* weapon); // ThrowWeapon ran, pairs with the last input and waits for the weapon to move
+
+	void LogPercentiles() const; // Print input to throw, input to moved and input to rendered percentiles
+
+	void Reset(); // Forget every throw
+
+private:
+
+	FWeaponThrowLatency();
+
+	void EndFrame(); // Look for the first frame the pending weapon moved in
+
+	mutable FCriticalSection SamplesLock; // The render thread writes RenderedCycles
+	TArray<FWeaponThrowLatencySample> Samples; // Ring buffer of the last throws
+	int32 NextSampleIndex;
+
+	uint64 PendingInputCycles; // Input waiting for its ThrowWeapon, 0 when there is none
+	uint64 PendingInputFrame;
+
+	TWeakObjectPtr<const AActor> PendingWeapon; // Thrown weapon waiting to move
+	FVector PendingLaunchLocation; // Where it was when ThrowWeapon returned
+	int32 PendingSampleIndex;
+};
+
+#define WEAPON_THROW_LATENCY_INPUT() FWeaponThrowLatency::Get().RecordInput()
+#define WEAPON_THROW_LATENCY_THROW(Weapon) FWeaponThrowLatency::Get().RecordThrow(Weapon)
+
+#else
+
+#define WEAPON_THROW_LATENCY_INPUT()
+#define WEAPON_THROW_LATENCY_THROW(Weapon)
+
+#endif
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+
+/// <summary>
+/// Development only record of the throwing weapon flight traces. Compiles out completely in Shipping
+/// </summary>
+#define WITH_WEAPON_TRACE_DIAGNOSTICS !UE_BUILD_SHIPPING
+
+#if WITH_WEAPON_TRACE_DIAGNOSTICS
+
+struct FHitResult;
+class UWorld;
+
+// A single throwing weapon trace kept in the diagnostics ring buffer
+struct FWeaponTraceRecord
+{
+	FVector Start = FVector::ZeroVector; // Where the trace started
+	FVector End = FVector::ZeroVector; // Where the trace ended
+	FVector ImpactPoint = FVector::ZeroVector; // Impact point when the trace hit something
+	double WorldTimeSeconds = 0; // World time when the trace was made
+	float LatencyMicroseconds = 0; // How long the query took, or for async traces how long the result took to be used after the submit
+	bool bHit = false; // Did the trace hit something?
+	bool bSwept = false; // Was it a shape sweep or a line trace?
+	bool bAsync = false; // Was it run by the async trace interface?
+};
+
+class WEAPON_API FWeaponTraceDiagnostics
+{
+public:
+
+	// How many traces the ring buffer remembers
+	static constexpr int32 Capacity = 256;
+
+	static FWeaponTraceDiagnostics& Get(); // The one diagnostics instance shared by every throwing weapon
+
+	void Record(const UWorld* world, const FVector& start, const FVector& end, const FHitResult& hitResult, bool bHit, bool bSwept, bool bAsync, uint64 startCycles); // Store a trace and update the counters
+
+	void Draw(const UWorld* world, float duration) const; // Draw every remembered trace
+
+	bool DumpToCsv(const FString& filePath) const; // Write every remembered trace and the counters to a CSV file
+
+	void LogCounters() const; // Print the hit/miss/latency counters
+
+	void Reset(); // Forget every trace and zero the counters
+
+private:
+
+	FWeaponTraceDiagnostics();
+
+	void DrawRecord(const UWorld* world, const FWeaponTraceRecord& record, float duration) const; // Draw one trace
+
+	TStaticArray<FWeaponTraceRecord, Capacity> Records; // Ring buffer of the last traces
+
+	int32 NextRecordIndex; // Where the next trace is written
+	int32 NumRecords; // How many slots of the ring buffer are filled
+
+	uint64 NumHits; // Traces that hit something
+	uint64 NumMisses; // Traces that hit nothing
+	double TotalLatencyMicroseconds; // Summed latency of every game thread trace
+	float MaxLatencyMicroseconds; // Slowest game thread trace
+
+	uint64 NumAsyncTraces; // Async traces, counted apart since their latency spans a frame instead of one query
+	double TotalAsyncLatencyMicroseconds; // Summed submit to use time of every async trace
+	float MaxAsyncLatencyMicroseconds; // Longest submit to use time
+};
+
+#define WEAPON_TRACE_DIAGNOSTICS_BEGIN(StartCyclesName) const uint64 StartCyclesName = FPlatformTime::Cycles64()
+#define WEAPON_TRACE_DIAGNOSTICS_RECORD(World, Start, End, HitResult, bHit, bSwept, StartCyclesName) \
+	FWeaponTraceDiagnostics::Get().Record(World, Start, End, HitResult, bHit, bSwept, false, StartCyclesName)
+#define WEAPON_TRACE_DIAGNOSTICS_RECORD_ASYNC(World, Start, End, HitResult, bHit, bSwept, SubmitCycles) \
+	FWeaponTraceDiagnostics::Get().Record(World, Start, End, HitResult, bHit, bSwept, true, SubmitCycles)
+
+#else
+
+#define WEAPON_TRACE_DIAGNOSTICS_BEGIN(StartCyclesName)
+#define WEAPON_TRACE_DIAGNOSTICS_RECORD(World, Start, End, HitResult, bHit, bSwept, StartCyclesName)
+#define WEAPON_TRACE_DIAGNOSTICS_RECORD_ASYNC(World, Start, End, HitResult, bHit, bSwept, SubmitCycles)
+
+#endif